@@ -0,0 +1,307 @@
+/**
+*
+* \brief Implementation of the on-disk HRTF cache used to speed up the start of the examples
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "HRTFCache.h"
+#include "StartupPipeline.h"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+#if defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#define HRTF_CACHE_MAGIC	"3DTIHRC1"
+#define HRTF_CACHE_VERSION	1
+#define HRTF_CACHE_ALIGN	16
+
+namespace HRTFCache
+{
+	namespace
+	{
+		/** \brief Read-only memory mapping of a whole file
+		*/
+		class CMappedFile
+		{
+		public:
+			CMappedFile() : data{ nullptr }, size{ 0 }
+#if defined(_WIN32)
+				, file{ INVALID_HANDLE_VALUE }, mapping{ NULL }
+#endif
+			{}
+			~CMappedFile() { Close(); }
+
+			bool Open(const std::string & fileName)
+			{
+#if defined(_WIN32)
+				file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+				if (file == INVALID_HANDLE_VALUE) return false;
+				LARGE_INTEGER fileSize;
+				if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { Close(); return false; }
+				mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (mapping == NULL) { Close(); return false; }
+				data = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				if (data == nullptr) { Close(); return false; }
+				size = (size_t)fileSize.QuadPart;
+#else
+				int fd = open(fileName.c_str(), O_RDONLY);
+				if (fd < 0) return false;
+				struct stat fileStat;
+				if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) { close(fd); return false; }
+				void * address = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				close(fd);																	// The mapping keeps its own reference to the file
+				if (address == MAP_FAILED) return false;
+				data = (const uint8_t *)address;
+				size = (size_t)fileStat.st_size;
+#endif
+				return true;
+			}
+
+			void Close()
+			{
+#if defined(_WIN32)
+				if (data != nullptr) UnmapViewOfFile(data);
+				if (mapping != NULL) CloseHandle(mapping);
+				if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+				mapping = NULL;
+				file = INVALID_HANDLE_VALUE;
+#else
+				if (data != nullptr) munmap((void *)data, size);
+#endif
+				data = nullptr;
+				size = 0;
+			}
+
+			const uint8_t * data;
+			size_t size;
+
+		private:
+#if defined(_WIN32)
+			HANDLE file;
+			HANDLE mapping;
+#endif
+		};
+
+		uint64_t AlignOffset(uint64_t offset)
+		{
+			return (offset + HRTF_CACHE_ALIGN - 1) & ~(uint64_t)(HRTF_CACHE_ALIGN - 1);
+		}
+
+		double MillisecondsSince(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		/** \brief Loads the HRTF table stored in a cache file into the listener
+		*	\retval false if the file does not exist, is corrupted or was built for a different configuration
+		*/
+		bool LoadFromCache(const std::string & cacheFile, uint64_t sofaHash, Binaural::CCore & core, shared_ptr<Binaural::CListener> listener, bool & specifiedDelays)
+		{
+			CMappedFile mappedFile;
+			if (!mappedFile.Open(cacheFile)) return false;
+			if (mappedFile.size < sizeof(THRTFCacheHeader)) return false;
+
+			// Check that the file was built from the same SOFA file and for the same configuration
+			THRTFCacheHeader header;
+			std::memcpy(&header, mappedFile.data, sizeof(header));
+			Common::TAudioStateStruct audioState = core.GetAudioState();
+			if (std::memcmp(header.magic, HRTF_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+				header.version != HRTF_CACHE_VERSION ||
+				header.headerSize != sizeof(THRTFCacheHeader) ||
+				header.sofaHash != sofaHash ||
+				header.sampleRate != (uint32_t)audioState.sampleRate ||
+				header.bufferSize != (uint32_t)audioState.bufferSize ||
+				header.resamplingStep != (uint32_t)core.GetHRTFResamplingStep() ||
+				header.hrirLength == 0 || header.numberOfDirections == 0)
+			{
+				return false;
+			}
+
+			// Check that the arrays announced by the header are inside the file
+			uint64_t directionsSize = (uint64_t)header.numberOfDirections * sizeof(TDirectionRecord);
+			uint64_t samplesSize = (uint64_t)header.numberOfDirections * 2 * header.hrirLength * sizeof(float);
+			if (header.directionsOffset + directionsSize > mappedFile.size || header.samplesOffset + samplesSize > mappedFile.size)
+				return false;
+
+			const TDirectionRecord * directions = (const TDirectionRecord *)(mappedFile.data + header.directionsOffset);
+			const float * samples = (const float *)(mappedFile.data + header.samplesOffset);
+
+			Binaural::CHRTF * hrtf = listener->GetHRTF();
+			hrtf->BeginSetup(header.hrirLength, header.distanceOfMeasurement);
+			for (uint32_t i = 0; i < header.numberOfDirections; i++)
+			{
+				THRIRStruct hrir;
+				hrir.leftDelay = directions[i].leftDelay;
+				hrir.rightDelay = directions[i].rightDelay;
+				hrir.leftHRIR.resize(header.hrirLength);
+				hrir.rightHRIR.resize(header.hrirLength);
+				const float * leftSamples = samples + (uint64_t)i * 2 * header.hrirLength;
+				std::memcpy(hrir.leftHRIR.data(), leftSamples, header.hrirLength * sizeof(float));
+				std::memcpy(hrir.rightHRIR.data(), leftSamples + header.hrirLength, header.hrirLength * sizeof(float));
+				hrtf->AddHRIR(directions[i].azimuth, directions[i].elevation, std::move(hrir));
+			}
+			specifiedDelays = header.specifiedDelays != 0;
+			return hrtf->EndSetup();												// Resampling and partitioning are done by the toolkit here
+		}
+
+		/** \brief Writes the HRTF table of the listener into a cache file
+		*	\details The file is written with a temporary name and renamed at the end, so an interrupted write never leaves a
+		*			 truncated cache file behind.
+		*/
+		bool SaveToCache(const std::string & cacheFile, uint64_t sofaHash, Binaural::CCore & core, shared_ptr<Binaural::CListener> listener, bool specifiedDelays)
+		{
+			Binaural::CHRTF * hrtf = listener->GetHRTF();
+			const T_HRTFTable & table = hrtf->GetRawHRTFTable();
+			uint32_t hrirLength = (uint32_t)hrtf->GetHRIRLength();
+			if (table.empty() || hrirLength == 0) return false;
+
+			// Directions are sorted so that the same SOFA file always produces the same cache file
+			std::vector<orientation> orientations;
+			orientations.reserve(table.size());
+			for (auto it = table.begin(); it != table.end(); it++) orientations.push_back(it->first);
+			std::sort(orientations.begin(), orientations.end(), [](const orientation & a, const orientation & b) {
+				return a.azimuth != b.azimuth ? a.azimuth < b.azimuth : a.elevation < b.elevation;
+			});
+
+			Common::TAudioStateStruct audioState = core.GetAudioState();
+			THRTFCacheHeader header;
+			std::memset(&header, 0, sizeof(header));
+			std::memcpy(header.magic, HRTF_CACHE_MAGIC, sizeof(header.magic));
+			header.version = HRTF_CACHE_VERSION;
+			header.headerSize = sizeof(THRTFCacheHeader);
+			header.sofaHash = sofaHash;
+			header.sampleRate = (uint32_t)audioState.sampleRate;
+			header.bufferSize = (uint32_t)audioState.bufferSize;
+			header.resamplingStep = (uint32_t)core.GetHRTFResamplingStep();
+			header.hrirLength = hrirLength;
+			header.numberOfDirections = (uint32_t)orientations.size();
+			header.specifiedDelays = specifiedDelays ? 1 : 0;
+			header.distanceOfMeasurement = hrtf->GetHRTFDistanceOfMeasurement();
+			header.directionsOffset = AlignOffset(sizeof(THRTFCacheHeader));
+			header.samplesOffset = AlignOffset(header.directionsOffset + orientations.size() * sizeof(TDirectionRecord));
+
+			std::string temporaryFile = cacheFile + ".tmp";
+			FILE * file = fopen(temporaryFile.c_str(), "wb");
+			if (file == nullptr) return false;
+
+			bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+			const char padding[HRTF_CACHE_ALIGN] = { 0 };
+			ok = ok && fwrite(padding, 1, header.directionsOffset - sizeof(header), file) == header.directionsOffset - sizeof(header);
+			for (size_t i = 0; ok && i < orientations.size(); i++)
+			{
+				const THRIRStruct & hrir = table.at(orientations[i]);
+				TDirectionRecord record = { orientations[i].azimuth, orientations[i].elevation, hrir.leftDelay, hrir.rightDelay };
+				ok = fwrite(&record, sizeof(record), 1, file) == 1;
+			}
+			uint64_t directionsEnd = header.directionsOffset + orientations.size() * sizeof(TDirectionRecord);
+			ok = ok && fwrite(padding, 1, header.samplesOffset - directionsEnd, file) == header.samplesOffset - directionsEnd;
+			for (size_t i = 0; ok && i < orientations.size(); i++)
+			{
+				const THRIRStruct & hrir = table.at(orientations[i]);
+				ok = hrir.leftHRIR.size() == hrirLength && hrir.rightHRIR.size() == hrirLength;
+				ok = ok && fwrite(hrir.leftHRIR.data(), sizeof(float), hrirLength, file) == hrirLength;
+				ok = ok && fwrite(hrir.rightHRIR.data(), sizeof(float), hrirLength, file) == hrirLength;
+			}
+			ok = (fclose(file) == 0) && ok;
+
+			if (ok)
+			{
+				std::remove(cacheFile.c_str());											// rename() does not overwrite on Windows
+				ok = std::rename(temporaryFile.c_str(), cacheFile.c_str()) == 0;
+			}
+			if (!ok) std::remove(temporaryFile.c_str());
+			return ok;
+		}
+	}
+
+	bool HashFile(const std::string & fileName, uint64_t & hash)
+	{
+		FILE * file = fopen(fileName.c_str(), "rb");
+		if (file == nullptr) return false;
+
+		hash = 14695981039346656037ULL;											// FNV-1a 64-bit offset basis
+		std::vector<unsigned char> chunk(1 << 16);
+		size_t bytesRead;
+		while ((bytesRead = fread(chunk.data(), 1, chunk.size(), file)) > 0)
+		{
+			for (size_t i = 0; i < bytesRead; i++)
+			{
+				hash ^= chunk[i];
+				hash *= 1099511628211ULL;											// FNV-1a 64-bit prime
+			}
+		}
+		fclose(file);
+		return true;
+	}
+
+	std::string GetCacheFileName(const std::string & sofaFile, uint64_t sofaHash, Binaural::CCore & core)
+	{
+		Common::TAudioStateStruct audioState = core.GetAudioState();
+		char key[128];
+		snprintf(key, sizeof(key), "-%016llx-%d-%d-%d.3dti-hrtf-cache", (unsigned long long)sofaHash,
+			audioState.sampleRate, audioState.bufferSize, core.GetHRTFResamplingStep());
+		return sofaFile + key;
+	}
+
+	bool CreateFromSofa(const std::string & sofaFile, shared_ptr<Binaural::CListener> listener, bool & specifiedDelays, Binaural::CCore & core)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		uint64_t sofaHash;
+		if (!HashFile(sofaFile, sofaHash))
+		{
+			std::cout << "ERROR: file " << sofaFile << " doesn't exist." << std::endl;
+			return false;
+		}
+		std::string cacheFile = GetCacheFileName(sofaFile, sofaHash, core);
+
+		// Warm start: the HRTF table is taken from the cache file, without parsing the SOFA file
+		if (LoadFromCache(cacheFile, sofaHash, core, listener, specifiedDelays))
+		{
+			std::cout << "HRTF loaded from cache " << cacheFile << " in " << MillisecondsSince(start) << " ms (warm start)" << std::endl;
+			return true;
+		}
+
+		// Cold start: the SOFA file is parsed, never at the same time as another one (see StartupPipeline::GetSofaMutex),
+		// and the cache file is created for the next run
+		{
+			std::lock_guard<std::mutex> sofaLock(StartupPipeline::GetSofaMutex());
+			if (!HRTF::CreateFromSofa(sofaFile, listener, specifiedDelays))
+				return false;
+		}
+		double loadTime = MillisecondsSince(start);
+		if (!SaveToCache(cacheFile, sofaHash, core, listener, specifiedDelays))
+			std::cout << "WARNING: HRTF cache " << cacheFile << " could not be written" << std::endl;
+		std::cout << "HRTF loaded from " << sofaFile << " in " << loadTime << " ms (cold start)" << std::endl;
+		return true;
+	}
+}
@@ -0,0 +1,94 @@
+/**
+*
+* \brief Declaration of the on-disk HRTF cache used to speed up the start of the examples
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _HRTFCACHE_H_
+#define _HRTFCACHE_H_
+
+#include <string>
+#include <cstdint>
+#include <HRTF/HRTFFactory.h>
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+
+namespace HRTFCache
+{
+	/** \brief Header of a cache file. The whole file can be mapped in memory and read in place:
+	*	\details [THRTFCacheHeader][TDirectionRecord x numberOfDirections][float left/right HRIRs x numberOfDirections]
+	*			 All offsets are in bytes from the beginning of the file and the HRIR block is 16-byte aligned.
+	*/
+	struct THRTFCacheHeader
+	{
+		char		magic[8];					// "3DTIHRC1"
+		uint32_t	version;					// Layout version, see HRTF_CACHE_VERSION
+		uint32_t	headerSize;					// sizeof(THRTFCacheHeader), to detect layout changes
+		uint64_t	sofaHash;					// FNV-1a hash of the SOFA file contents
+		uint32_t	sampleRate;					// Sample rate of the core when the cache was built
+		uint32_t	bufferSize;					// Buffer size of the core when the cache was built
+		uint32_t	resamplingStep;				// HRTF resampling step of the core when the cache was built
+		uint32_t	hrirLength;					// Number of samples of each HRIR
+		uint32_t	numberOfDirections;			// Number of measured directions stored in the file
+		uint32_t	specifiedDelays;			// Value returned by HRTF::CreateFromSofa in specifiedDelays
+		float		distanceOfMeasurement;		// Distance (in metres) at which the HRTF was measured
+		uint32_t	reserved;
+		uint64_t	directionsOffset;			// Offset of the TDirectionRecord array
+		uint64_t	samplesOffset;				// Offset of the HRIR samples
+	};
+
+	/** \brief One measured direction of the HRTF table, as stored in the cache file
+	*/
+	struct TDirectionRecord
+	{
+		int32_t		azimuth;
+		int32_t		elevation;
+		uint64_t	leftDelay;
+		uint64_t	rightDelay;
+	};
+
+	/** \brief Loads an HRTF from a SOFA file into the listener, using an on-disk cache to skip the SOFA parsing on later runs
+	*	\details The cache file is created next to the SOFA file and its name contains the hash of the SOFA file, the sample rate,
+	*			 the buffer size and the HRTF resampling step of the core, so any change of those produces a new cache file.
+	*			 The time spent loading the HRTF (cold or warm start) is reported through the console. The cache only skips the
+	*			 parsing: the HRIRs are added to the HRTF of the listener, which resamples and partitions them in the calling thread
+	*			 when its setup ends, as on a cold start. That work is done inside the toolkit and cannot be spread over threads from here.
+	*	\param [in] sofaFile name of the SOFA file to open
+	*	\param [in] listener listener where the HRTF will be loaded
+	*	\param [out] specifiedDelays true if the SOFA file has the delays specified
+	*	\param [in] core core the listener belongs to, used to build the cache key
+	*	\retval true if the HRTF was successfully loaded, either from the cache or from the SOFA file
+	*/
+	bool CreateFromSofa(const std::string & sofaFile, shared_ptr<Binaural::CListener> listener, bool & specifiedDelays, Binaural::CCore & core);
+
+	/** \brief Returns the name of the cache file for a SOFA file and a given core configuration
+	*	\param [in] sofaFile name of the SOFA file
+	*	\param [in] sofaHash hash of the SOFA file contents
+	*	\param [in] core core whose audio state and resampling step are part of the key
+	*	\retval name of the cache file
+	*/
+	std::string GetCacheFileName(const std::string & sofaFile, uint64_t sofaHash, Binaural::CCore & core);
+
+	/** \brief Computes the FNV-1a hash of the contents of a file
+	*	\param [in] fileName name of the file
+	*	\param [out] hash hash of the file contents
+	*	\retval false if the file could not be read
+	*/
+	bool HashFile(const std::string & fileName, uint64_t & hash);
+}
+
+#endif
@@ -27,12 +27,30 @@
 #endif
 #define SAMPLERATE 44100
 int iBufferSize;
+int iDeviceBufferSize;
 bool bEnableReverb;
-int main()
+std::atomic<bool> bReverbReady(false);		// Set when the BRIR has been loaded, as the stream may start before
+int main(int argc, char* argv[])
 {
+    // Benchmarks can be run from the command line instead of the example: example --benchmark <name> [bufferSize]
+    if (argc > 2 && string(argv[1]) == "--benchmark")
+    {
+        if (!Benchmarks::Run(argv[2], argc > 3 ? atoi(argv[3]) : 512))
+            cout << "Unknown benchmark: " << argv[2] << endl;
+        return 0;
+    }
+
     //Input buffer size and reverb enable
-    cout << "Insert wished buffer size (256, 512, 1024, 2048, 4096...)\n(2048 at least recommended for linux)\t: ";
-    cin >> iBufferSize; cin.ignore();
+    do {																			 // The partitioned convolution of the reverb needs a power of two
+        cout << "Insert wished buffer size (128, 256, 512, 1024, 2048...)\t: ";
+        cin >> iBufferSize; cin.clear(); cin.ignore(INT_MAX, '\n');
+    } while (iBufferSize < 64 || (iBufferSize & (iBufferSize - 1)) != 0);
+
+    do {																			 // The device buffer is filled from quanta of iBufferSize samples, see FixedQuantumAdapter.h
+        cout << "Insert wished device buffer size (any size from " << iBufferSize << ", 0 to use the same)\t: ";
+        cin >> iDeviceBufferSize; cin.clear(); cin.ignore(INT_MAX, '\n');
+    } while (iDeviceBufferSize < 0 || (iDeviceBufferSize > 0 && iDeviceBufferSize < iBufferSize));
+    if (iDeviceBufferSize == 0) iDeviceBufferSize = iBufferSize;
 
     char cInput;
     do{  	cout << "\nDo you want reverb? (Y/n) : "; cInput=getchar();
@@ -41,6 +59,24 @@ int main()
     if(cInput=='y' || cInput == '\n') bEnableReverb = true;
     else                              bEnableReverb = false;
 
+    int iHearingSimulation;
+    do {
+        cout << "\nHearing simulation (0 - none, 1 - hearing loss, 2 - hearing loss with hearing aid, add 3 to run it in a worker thread)\t: ";
+        cin >> iHearingSimulation; cin.clear(); cin.ignore(INT_MAX, '\n');
+    } while (iHearingSimulation < 0 || iHearingSimulation > 5);
+
+    int iHearingImplementation = 0;
+    if (iHearingSimulation != 0) do {												 // See HAHLStage.h and VectorizedHAHL.h
+        cout << "\nHearing simulation implementation (0 - toolkit simulators, 1 - simplified vectorized model)\t: ";
+        cin >> iHearingImplementation; cin.clear(); cin.ignore(INT_MAX, '\n');
+    } while (iHearingImplementation < 0 || iHearingImplementation > 1);
+
+    int iCrowdSources;
+    do {																			 // Crowd sources are rendered by CrowdRenderer, see CrowdRenderer.h
+        cout << "\nNumber of crowd sources talking around the listener (0 - none)\t: ";
+        cin >> iCrowdSources; cin.clear(); cin.ignore(INT_MAX, '\n');
+    } while (iCrowdSources < 0);
+
     // Core setup
     Common::TAudioStateStruct audioState;	    // Audio State struct declaration
     audioState.bufferSize = iBufferSize;			// Setting buffer size and sample rate
@@ -60,23 +96,25 @@ int main()
     listener->SetListenerTransform(listenerPosition);
     listener->DisableCustomizedITD();								 // Disabling custom head radius
 
-	   /* HRTF can be loaded in either SOFA (more info in https://sofacoustics.org/) or 3dti-hrtf format.
-	      These HRTF files are provided with 3DTI Audio Toolkit. They can be found in 3dti_AudioToolkit/resources/HRTF */
-		bool specifiedDelays;
-		HRTF::CreateFromSofa("hrtf.sofa", listener, specifiedDelays);			// Comment this line and uncomment next lines to load the default HRTF in 3dti-hrtf format instead of in SOFA format
-		//HRTF::CreateFrom3dti("hrtf.3dti-hrtf", listener);			       
-    
-    
-
     // Environment setup
     	environment = myCore.CreateEnvironment();									// Creating environment to have reverberated sound
       environment->SetReverberationOrder(TReverberationOrder::BIDIMENSIONAL);		// Setting number of ambisonic channels to use in reverberation processing
-      BRIR::CreateFromSofa("brir.sofa", environment);								// Loading SOFAcoustics BRIR file and applying it to the environment
+    reverb = std::make_shared<VirtualAmbisonicReverb>(iBufferSize, environment->GetReverberationOrder());	 // Reverb with short head partitions and long tail partitions, see VirtualAmbisonicReverb.h
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    if (hardwareThreads > 2 && reverb->GetNumberOfChannels() > 1)						 // One core is left for the tail of the reverb, the audio thread processes channels too
+    {
+        unsigned int reverbWorkers = reverb->GetNumberOfChannels() - 1;
+        if (reverbWorkers > hardwareThreads - 2) reverbWorkers = hardwareThreads - 2;
+        // The audio thread takes the channels the workers have not started, but still waits in every block for the ones they are
+        // convolving, so a worker preempted in the middle of a channel delays the whole block (see ThreadPool::ParallelFor)
+        reverbThreadPool = std::make_shared<ThreadPool>(reverbWorkers);
+        reverb->SetThreadPool(reverbThreadPool.get());
+    }
+    reverbInputs.resize(2);																 // Speech and steps sources
 
 
     // Speech source setup
     sourceSpeech = myCore.CreateSingleSourceDSP();										 // Creating audio source
-    LoadWav(samplesVectorSpeech, "speech.wav");											 // Loading .wav file
     Common::CTransform sourceSpeechPosition = Common::CTransform();
     sourceSpeechPosition.SetPosition(Common::CVector3(0, 2, 0));						 // Setting source in x=0,y=2,z=0 (on the left)
     sourceSpeech->SetSourceTransform(sourceSpeechPosition);
@@ -87,7 +125,6 @@ int main()
 
     // Steps source setup
     sourceSteps = myCore.CreateSingleSourceDSP();										 // Creating audio source
-    LoadWav(samplesVectorSteps, "steps.wav");											   // Loading .wav file
     Common::CTransform sourceStepsPosition = Common::CTransform();
     sourceStepsPosition.SetPosition(Common::CVector3(-3, 10, -10));						 // Setting source in (-3,-10,-10)
     sourceSteps->SetSourceTransform(sourceStepsPosition);
@@ -97,10 +134,55 @@ int main()
     sourceSteps->EnableDistanceAttenuationAnechoic();
     sourcePosition = sourceStepsPosition;												 // Saving initial position into source position to move the steps audio source later on
 
+    // Crowd setup, with the same resampling step as the HRTF of the listener
+    if (iCrowdSources > 0) CreateCrowd(iCrowdSources, iBufferSize);
 
-    // Declaration and initialization of stereo buffer
-  	outputBufferStereo.left.resize(iBufferSize);
-  	outputBufferStereo.right.resize(iBufferSize);
+
+    // The core always processes iBufferSize samples, whatever the buffer size of the device
+    quantumAdapter = std::make_shared<FixedQuantumAdapter>(iBufferSize, [](Common::CEarPair<CMonoBuffer<float>> & bufferOutput) {
+        bufferOutput.left.Fill(iBufferSize, 0.0f);
+        bufferOutput.right.Fill(iBufferSize, 0.0f);
+        audioProcess(bufferOutput, iBufferSize);
+        if (hahlStage) hahlStage->Process(bufferOutput);						 // Applied to the whole mix, as heard by the listener
+    });
+
+    // Hearing loss simulation, with a sample audiogram, see HAHLStage.h. In a worker thread, the mix is one quantum late.
+    if (iHearingSimulation % 3 != 0)
+    {
+        hahlStage = std::make_shared<HAHLStage>(SAMPLERATE, iBufferSize);
+        hahlStage->SetHearingLoss(Common::T_ear::BOTH, HAHL_EXAMPLE_AUDIOGRAM);
+        hahlStage->SetHearingAid(iHearingSimulation % 3 == 2);
+        hahlStage->SetImplementation(iHearingImplementation == 1 ? HAHLStage::VECTORIZED : HAHLStage::TOOLKIT);
+        if (iHearingSimulation > 3) hahlStage->StartWorker();
+    }
+
+
+    // Loading of resources. HRTF, BRIR and wav files do not depend on each other, so each one is loaded in its own thread
+    // while the audio device is chosen and opened in this one. The HRTF and BRIR SOFA files are parsed one after the other,
+    // as the SOFA libraries are not thread safe (see StartupPipeline::GetSofaMutex). The stream starts as soon as the HRTF
+    // and the wav files are ready; the reverb is added to the mix later, when the BRIR has been loaded (see bReverbReady).
+    bool specifiedDelays;
+    StartupPipeline startup;															 // Must be declared after everything its stages use, as its destructor waits for them
+
+	   /* HRTF can be loaded in either SOFA (more info in https://sofacoustics.org/) or 3dti-hrtf format.
+	      These HRTF files are provided with 3DTI Audio Toolkit. They can be found in 3dti_AudioToolkit/resources/HRTF
+	      The SOFA file is only parsed on the first run, later runs load the HRTF table from an on-disk cache (see HRTFCache.h).
+	      Replace the call in the stage by HRTF::CreateFromSofa("hrtf.sofa", listener, specifiedDelays) to always parse the SOFA file,
+	      or by HRTF::CreateFrom3dti("hrtf.3dti-hrtf", listener) to load the default HRTF in 3dti-hrtf format instead of in SOFA format */
+    startup.LaunchStage("HRTF", true, [&]() {
+        return HRTFCache::CreateFromSofa("hrtf.sofa", listener, specifiedDelays, myCore)
+            && (!crowd || (crowdHRIRCache->Setup(*listener->GetHRTF()) && crowd->Setup(*listener->GetHRTF())));	 // The HRIRs of the crowd come from the HRTF of the listener
+    });
+    if (bEnableReverb)																	 // Loading SOFAcoustics BRIR file and applying it to the environment
+        startup.LaunchStage("BRIR", false, [&]() {
+            {
+                std::lock_guard<std::mutex> sofaLock(StartupPipeline::GetSofaMutex());
+                if (!BRIR::CreateFromSofa("brir.sofa", environment)) return false;
+            }
+            return reverb->Setup(*environment->GetBRIR());									 // The ABIRs are partitioned concurrently with the other stages
+        }, [&]() { bReverbReady = true; });
+    startup.LaunchStage("speech.wav", true, [&]() { LoadWav(samplesVectorSpeech, "speech.wav"); return !samplesVectorSpeech.empty(); });	 // Loading .wav files
+    startup.LaunchStage("steps.wav",  true, [&]() { LoadWav(samplesVectorSteps,  "steps.wav");  return !samplesVectorSteps.empty();  });
 
 
     // Audio output configuration, using RtAudio (more info in https://www.music.mcgill.ca/~gary/rtaudio/)
@@ -134,26 +216,52 @@ int main()
     }while(flag!='0');*/
     options.numberOfBuffers = 4;                // Setting number of buffers used by RtAudio
     options.priority = 1;                       // Setting stream thread priority
-    unsigned int frameSize = iBufferSize;       // Declaring and initializing frame size variable because next statement needs it
+    unsigned int frameSize = iDeviceBufferSize; // Declaring and initializing frame size variable because next statement needs it. RtAudio may change it.
 
     // Opening of audio stream
-    try{
-	       audio->openStream(&outputParameters,     // Specified output parameters
-		               nullptr,			                  // Unspecified input parameters because there will not be input stream
-		               RTAUDIO_FLOAT32,	              // Output buffer will be 32-bit float
-		               SAMPLERATE,			                    // Sample rate will be 44.1 kHz
-		               &frameSize,		                // Frame size will be iBufferSize samples
-		               &rtAudioCallback,	            // Pointer to the function that will be called every time RtAudio needs the buffer to be filled
-		               nullptr,			                  // Unused pointer to get feedback
-		               &options			                  // Stream options (real-time stream, 4 buffers and priority)
-		              );
-     }catch ( RtAudioError& e ) {
-    	    std::cout << "\nERROR:\t" << e.getMessage() << '\n' << std::endl;
-    	    exit( 0 );
-     }
+    bool streamOpened = startup.RunStage("Audio device", [&]() {
+        try{
+	           audio->openStream(&outputParameters,     // Specified output parameters
+		                   nullptr,			                  // Unspecified input parameters because there will not be input stream
+		                   RTAUDIO_FLOAT32,	              // Output buffer will be 32-bit float
+		                   SAMPLERATE,			                    // Sample rate will be 44.1 kHz
+		                   &frameSize,		                // Frame size will be iDeviceBufferSize samples, or the closest size the device supports
+		                   &rtAudioCallback,	            // Pointer to the function that will be called every time RtAudio needs the buffer to be filled
+		                   nullptr,			                  // Unused pointer to get feedback
+		                   &options			                  // Stream options (real-time stream, 4 buffers and priority)
+		                  );
+         }catch ( RtAudioError& e ) {
+    	        std::cout << "\nERROR:\t" << e.getMessage() << '\n' << std::endl;
+    	        return false;
+         }
+         return true;
+    });
+    if (!streamOpened) {
+        startup.WaitForAllStages();                     // exit() does not run the destructor of startup, so the stages still running are joined here
+        exit( 0 );
+    }
+    cout << "Device buffer size " << frameSize << ", processing quantum " << iBufferSize << endl;
+    if (frameSize < (unsigned int)iBufferSize) {										 // The device may not support the size asked for
+        std::cout << "\nERROR:\tThe device buffer is smaller than the processing quantum, choose a smaller buffer size\n" << std::endl;
+        audio->closeStream();
+        startup.WaitForAllStages();
+        exit( 0 );
+    }
+
+    // Waiting for the minimum set of resources needed to render audio
+    if (!startup.WaitForRequiredStages()) {
+        std::cout << "\nERROR:\tThe HRTF or the wav files could not be loaded\n" << std::endl;
+        startup.WaitForAllStages();                     // The BRIR may still be loading
+        exit( 0 );
+    }
+
+    // Each crowd source starts reading the speech at a different point
+    for (int i = 0; i < iCrowdSources; i++)
+        crowdEndFrames[i] = (unsigned int)((samplesVectorSpeech.size() * i) / iCrowdSources) - 1;
 
     // Starting the stream
     audio->startStream();
+    cout << "[startup] Audio started after " << startup.GetElapsedMilliseconds() << " ms" << endl;
 
     // Informing user by the console to press any key to end the execution
     cout << "Press ENTER to finish... \n";
@@ -164,6 +272,10 @@ int main()
     // Stopping and closing the stream
     audio->stopStream();
     audio->closeStream();
+    if (bEnableReverb && bReverbReady)
+        cout << "The reverb tail was late " << reverb->GetNumberOfLateTails() << " times" << endl;
+    if (hahlStage && hahlStage->IsWorkerRunning())
+        cout << "The hearing simulation was late " << hahlStage->GetNumberOfLateBlocks() << " times" << endl;
 
 
     return 0;
@@ -189,6 +301,38 @@ int SelectAudioDevice() {
 	return selectAudioDevice;
 }
 
+void CreateCrowd(int numberOfSources, int bufferSize)
+{
+    crowd = std::make_shared<CrowdRenderer>(bufferSize, 15);
+    crowd->SetGroupingMode(CrowdRenderer::BATCHED);									 // Same output as one convolution per source, see CrowdRenderer.h
+    crowdHRIRCache = std::make_shared<HRIRCache>(bufferSize, 2.0f, 4 * numberOfSources);	 // Sources in the same 2-degree cell share its interpolated HRIR, see HRIRCache.h
+    crowd->SetHRIRCache(crowdHRIRCache.get());
+
+    crowdBuffers.assign(numberOfSources, CMonoBuffer<float>(bufferSize));
+    crowdInputs.resize(numberOfSources);
+    crowdSamplePositions.assign(numberOfSources, 0);
+    crowdEndFrames.assign(numberOfSources, 0);
+    crowdOutput.left.assign(bufferSize, 0.0f);
+    crowdOutput.right.assign(bufferSize, 0.0f);
+    for (int i = 0; i < numberOfSources; i++)
+    {
+        float azimuth = 2.0f * M_PI * (i + 0.5f) / numberOfSources;					 // Spread around the listener, in rings from 4 to 10 metres
+        float distance = 4.0f + 2.0f * (i % 4);
+        crowdInputs[i].buffer = &crowdBuffers[i];
+        crowdInputs[i].sourceTransform.SetPosition(Common::CVector3(distance * cos(azimuth), distance * sin(azimuth), 0));
+    }
+}
+
+void MoveCrowd(float angle)
+{
+    float c = cos(angle), s = sin(angle);
+    for (size_t i = 0; i < crowdInputs.size(); i++)
+    {
+        Common::CVector3 position = crowdInputs[i].sourceTransform.GetPosition();
+        crowdInputs[i].sourceTransform.SetPosition(Common::CVector3(c * position.x - s * position.y, s * position.x + c * position.y, position.z));
+    }
+}
+
 static int rtAudioCallback(void *outputBuffer, void *inputBuffer, unsigned int uiBufferSize, double streamTime, RtAudioStreamStatus status, void *data)
 {
     // Setting the output buffer as float
@@ -197,30 +341,17 @@ static int rtAudioCallback(void *outputBuffer, void *inputBuffer, unsigned int u
     // Checking if there is underflow or overflow
     if (status) cout << "stream over/underflow detected";
 
-  	// Initializes buffer with zeros
-	  outputBufferStereo.left.Fill(uiBufferSize, 0.0f);
-	  outputBufferStereo.right.Fill(uiBufferSize, 0.0f);
-
-
-    // Getting the processed audio
-    audioProcess(outputBufferStereo, uiBufferSize);
-
-    // Declaration and initialization of interlaced audio vector for correct stereo output
-    CStereoBuffer<float> iOutput;
-    iOutput.Interlace(outputBufferStereo.left, outputBufferStereo.right);
-
-    // Buffer filling loop
-    for (auto it = iOutput.begin(); it != iOutput.end(); it++)
-    {
-        floatOutputBuffer[0] = *it;						 // Setting of value in actual buffer position
-        floatOutputBuffer = &floatOutputBuffer[1];				 // Updating pointer to next buffer position
-    }
+    // Getting the processed audio, interlaced, rendering as many quanta of iBufferSize samples as needed
+    quantumAdapter->Process(floatOutputBuffer, uiBufferSize);
 
     // Moving the steps source
     sourcePosition.SetPosition(Common::CVector3(sourcePosition.GetPosition().x,
                                                 sourcePosition.GetPosition().y - streamTime / 110.0f,
                                                 sourcePosition.GetPosition().z > 10 ? sourcePosition.GetPosition().z : sourcePosition.GetPosition().z + streamTime / 110.0f));
     sourceSteps->SetSourceTransform(sourcePosition);
+
+    // Moving the crowd around the listener, a full turn per minute
+    if (crowd) MoveCrowd(2.0f * M_PI / 60.0f * uiBufferSize / SAMPLERATE);
     return 0;
 }
 
@@ -250,12 +381,26 @@ void audioProcess(Common::CEarPair<CMonoBuffer<float>> & bufferOutput, int uiBuf
     bufferOutput.left += bufferProcessed.left;
     bufferOutput.right += bufferProcessed.right;
 
+    // Anechoic process of the crowd, every source reading the speech at its own point
+    if (crowd)
+    {
+        for (size_t i = 0; i < crowdBuffers.size(); i++)
+            FillBuffer(crowdBuffers[i], crowdSamplePositions[i], crowdEndFrames[i], samplesVectorSpeech);
+        crowd->Process(crowdInputs, listener->GetListenerTransform(), crowdOutput.left, crowdOutput.right);
+        bufferOutput.left += crowdOutput.left;
+        bufferOutput.right += crowdOutput.right;
+    }
+
     // Declaration and initialization of separate buffer needed for the reverb
     Common::CEarPair<CMonoBuffer<float>> bufferReverb;
 
     // Reverberation processing of all sources
-    if(bEnableReverb){
-           environment->ProcessVirtualAmbisonicReverb(bufferReverb.left, bufferReverb.right);
+    // Replace by environment->ProcessVirtualAmbisonicReverb(bufferReverb.left, bufferReverb.right) to use the reverb of the toolkit,
+    // which convolves the whole BRIR in blocks of the buffer size
+    if(bEnableReverb && bReverbReady){
+           reverbInputs[0].buffer = &speechInput;	reverbInputs[0].sourceTransform = sourceSpeech->GetSourceTransform();
+           reverbInputs[1].buffer = &stepsInput;	reverbInputs[1].sourceTransform = sourceSteps->GetSourceTransform();
+           reverb->Process(reverbInputs, listener->GetListenerTransform(), bufferReverb.left, bufferReverb.right);
 	    // Adding reverberated sound to the output mix
 	    bufferOutput.left += bufferReverb.left;
 	    bufferOutput.right += bufferReverb.right;
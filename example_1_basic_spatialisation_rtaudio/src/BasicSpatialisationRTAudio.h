@@ -25,12 +25,21 @@
 
 #include <cstdio>
 #include <cstring>
+#include <atomic>
 #include <HRTF/HRTFFactory.h>
 #include <HRTF/HRTFCereal.h>
 #include <BRIR/BRIRFactory.h>
 #include <BRIR/BRIRCereal.h>
 #include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
 #include <RtAudio.h>
+#include "HRTFCache.h"
+#include "ThreadPool.h"
+#include "Benchmarks.h"
+#include "CrowdRenderer.h"
+#include "FixedQuantumAdapter.h"
+#include "HAHLStage.h"
+#include "StartupPipeline.h"
+#include "VirtualAmbisonicReverb.h"
 
 
 shared_ptr<RtAudio>						audio;												 // Pointer to RtAudio API
@@ -39,10 +48,21 @@ Binaural::CCore							myCore;												 // Core interface
 shared_ptr<Binaural::CListener>			listener;											 // Pointer to listener interface
 shared_ptr<Binaural::CSingleSourceDSP>	sourceSpeech, sourceSteps;							 // Pointers to each audio source interface
 shared_ptr<Binaural::CEnvironment>		environment;										 // Pointer to environment interface
+shared_ptr<ThreadPool>					reverbThreadPool;									 // Worker threads processing the Ambisonic channels of the reverb, if there are enough cores
+shared_ptr<VirtualAmbisonicReverb>		reverb;												 // Low-latency reverb using the BRIR loaded into the environment
+vector<VirtualAmbisonicReverb::TSourceInput>	reverbInputs;									 // Input of each source to the reverb, sized in main and updated in place by the audio thread
 
 Common::CTransform						sourcePosition;										 // Storages the position of the steps source
 
-Common::CEarPair<CMonoBuffer<float>>	outputBufferStereo;									 // Stereo buffer containing processed audio
+shared_ptr<FixedQuantumAdapter>			quantumAdapter;										 // Renders the audio in quanta of the core buffer size and stores the processed audio
+shared_ptr<HAHLStage>					hahlStage;											 // Hearing loss and hearing aid simulation applied to the mix, if enabled
+
+shared_ptr<CrowdRenderer>				crowd;												 // Renders the crowd sources, if any
+shared_ptr<HRIRCache>					crowdHRIRCache;										 // HRIRs interpolated for the directions the crowd walks through
+vector<CMonoBuffer<float>>				crowdBuffers;										 // Input buffer of each crowd source, allocated in main
+vector<CrowdRenderer::TSourceInput>		crowdInputs;										 // Input buffer and position of each crowd source
+vector<unsigned int>					crowdSamplePositions, crowdEndFrames;				 // Frame of the speech being read by each crowd source
+Common::CEarPair<CMonoBuffer<float>>	crowdOutput;										 // Binaural mix of the crowd
 
 vector<float>							samplesVectorSpeech, samplesVectorSteps;			 // Storages the audio from the wav files
 
@@ -57,6 +77,17 @@ unsigned int							wavSamplePositionSpeech, positionEndFrameSpeech,	 // Storages
 */
 void audioProcess(Common::CEarPair<CMonoBuffer<float>>& bufferOutput, int bufferSize);
 
+/** \brief Creates the crowd sources, standing in rings around the listener, and their buffers
+*	\param [in] numberOfSources number of crowd sources
+*	\param [in] bufferSize size of buffer in samples
+*/
+void CreateCrowd(int numberOfSources, int bufferSize);
+
+/** \brief Makes the crowd sources walk around the listener
+*	\param [in] angle angle walked since the last call, in radians
+*/
+void MoveCrowd(float angle);
+
 /** \brief This method shows the user a very simple menu that allows him to choose the audio interface to be used.
 *	\param [out] int AudioDeviceID
 */
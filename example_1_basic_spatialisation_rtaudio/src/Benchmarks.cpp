@@ -0,0 +1,798 @@
+/**
+*
+* \brief Implementation of the benchmarks that can be run from the command line of the example project 1
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "Benchmarks.h"
+#include "CrowdRenderer.h"
+#include "FFT.h"
+#include "FixedQuantumAdapter.h"
+#include "HAHLStage.h"
+#include "HRIRCache.h"
+#include "HRTFCache.h"
+#include "StartupPipeline.h"
+#include "ThreadPool.h"
+#include "VirtualAmbisonicReverb.h"
+#include <BRIR/BRIRFactory.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define BENCHMARK_SAMPLERATE	44100
+#define BENCHMARK_HRTF_FILE		"hrtf.sofa"
+#define BENCHMARK_BRIR_FILE		"brir.sofa"
+#define BENCHMARK_REVERB_SOURCES	8
+#define BENCHMARK_REVERB_SECONDS	20
+#define BENCHMARK_CROWD_STEP		15
+#define BENCHMARK_CROWD_BLOCKS		200
+#define BENCHMARK_PRECISION_SECONDS	10
+#define BENCHMARK_PRECISION_SOURCES	128
+#define BENCHMARK_HRIR_SECONDS		60
+#define BENCHMARK_HRIR_CAPACITY		256
+#define BENCHMARK_HRIR_CROWD_SOURCES	64
+#define BENCHMARK_QUANTUM_SECONDS	10
+#define BENCHMARK_QUANTUM_SOURCES	32
+#define BENCHMARK_HAHL_SECONDS		10
+
+namespace Benchmarks
+{
+	namespace
+	{
+		double MillisecondsSince(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		/** \brief Creates a core with its listener, ready to load an HRTF
+		*/
+		shared_ptr<Binaural::CListener> SetupCore(Binaural::CCore & core, int bufferSize, int resamplingStep)
+		{
+			Common::TAudioStateStruct audioState;
+			audioState.bufferSize = bufferSize;
+			audioState.sampleRate = BENCHMARK_SAMPLERATE;
+			core.SetAudioState(audioState);
+			core.SetHRTFResamplingStep(resamplingStep);
+			shared_ptr<Binaural::CListener> listener = core.CreateListener();
+			listener->DisableCustomizedITD();
+			return listener;
+		}
+
+		/** \brief Sources around the listener, each one playing white noise
+		*/
+		template <typename TSourceInput>
+		void CreateSources(int numberOfSources, int bufferSize, std::vector<CMonoBuffer<float>> & buffers, std::vector<TSourceInput> & sources)
+		{
+			std::mt19937 generator(numberOfSources);
+			std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+			std::uniform_real_distribution<float> azimuths(0.0f, 2.0f * 3.14159265f);
+			std::uniform_real_distribution<float> heights(-0.3f, 0.3f);
+			std::uniform_real_distribution<float> distances(1.0f, 10.0f);
+			buffers.assign(numberOfSources, CMonoBuffer<float>(bufferSize));
+			sources.resize(numberOfSources);
+			for (int s = 0; s < numberOfSources; s++)
+			{
+				for (float & sample : buffers[s]) sample = distribution(generator);
+				float azimuth = azimuths(generator), distance = distances(generator);
+				sources[s].buffer = &buffers[s];
+				sources[s].sourceTransform.SetPosition(Common::CVector3(distance * std::cos(azimuth), distance * std::sin(azimuth), heights(generator)));
+			}
+		}
+
+		/** \brief Prints one line of the precision benchmark and updates the reference when the precision is float32
+		*	\param [in] output left and right outputs of every block, one after the other
+		*/
+		void PrintPrecisionResult(const char * engine, SpectrumStorage::TPrecision precision, size_t filterSize, double time, const std::vector<float> & output,
+								  size_t & referenceSize, double & referenceTime, std::vector<float> & referenceOutput)
+		{
+			if (precision == SpectrumStorage::FLOAT32)
+			{
+				referenceSize = filterSize;
+				referenceTime = time;
+				referenceOutput = output;
+			}
+			float largest = 0.0f, difference = 0.0f;
+			for (size_t n = 0; n < output.size(); n++)
+			{
+				largest = std::max(largest, std::abs(referenceOutput[n]));
+				difference = std::max(difference, std::abs(output[n] - referenceOutput[n]));
+			}
+			double errorDB = difference > 0.0f ? 20.0 * std::log10(difference / largest) : -std::numeric_limits<double>::infinity();
+			printf("%8s %12s %12.1f %10.0f%% %12.4f %9.2fx %16.1f\n", engine, SpectrumStorage::GetPrecisionName(precision), filterSize / 1024.0,
+				   100.0 * filterSize / referenceSize, time, referenceTime / time, errorDB);
+		}
+
+		/** \brief Positions of the steps source on each block, moved as in rtAudioCallback (drift) or in paCallbackMethod of example 2 (orbit)
+		*/
+		std::vector<Common::CVector3> CreateTrajectory(bool orbit, int numberOfBlocks, int bufferSize)
+		{
+			std::vector<Common::CVector3> positions(numberOfBlocks);
+			Common::CVector3 position = orbit ? Common::CVector3(10, 0, -10) : Common::CVector3(-3, 10, -10);
+			for (int b = 0; b < numberOfBlocks; b++)
+			{
+				positions[b] = position;
+				if (orbit)
+				{
+					float t = 0.005f * (b + 1);
+					position = Common::CVector3(10 * std::cos(t), 10 * std::sin(t), position.z);
+				}
+				else
+				{
+					float streamTime = (float)b * bufferSize / BENCHMARK_SAMPLERATE;
+					position = Common::CVector3(position.x, position.y - streamTime / 110.0f, position.z > 10 ? position.z : position.z + streamTime / 110.0f);
+				}
+			}
+			return positions;
+		}
+
+		/** \brief Returns true if both HRTF tables contain exactly the same directions, delays and samples
+		*/
+		bool AreIdentical(const T_HRTFTable & a, const T_HRTFTable & b)
+		{
+			if (a.size() != b.size()) return false;
+			for (auto it = a.begin(); it != a.end(); it++)
+			{
+				auto other = b.find(it->first);
+				if (other == b.end()) return false;
+				const THRIRStruct & x = it->second;
+				const THRIRStruct & y = other->second;
+				if (x.leftDelay != y.leftDelay || x.rightDelay != y.rightDelay) return false;
+				if (x.leftHRIR.size() != y.leftHRIR.size() || x.rightHRIR.size() != y.rightHRIR.size()) return false;
+				if (std::memcmp(x.leftHRIR.data(), y.leftHRIR.data(), x.leftHRIR.size() * sizeof(float)) != 0) return false;
+				if (std::memcmp(x.rightHRIR.data(), y.rightHRIR.data(), x.rightHRIR.size() * sizeof(float)) != 0) return false;
+			}
+			return true;
+		}
+
+		/** \brief Returns true if both HRTFs give exactly the same partitioned HRIRs and delays after the resampling done by the toolkit
+		*	\details The directions are taken every 5 degrees, which includes the resampled grid of all the steps of the startup benchmark
+		*/
+		bool AreIdentical(Binaural::CHRTF * a, Binaural::CHRTF * b)
+		{
+			if (a->GetHRIRNumberOfSubfilters() != b->GetHRIRNumberOfSubfilters() || a->GetHRIRSubfilterLength() != b->GetHRIRSubfilterLength()) return false;
+			Common::T_ear ears[] = { Common::T_ear::LEFT, Common::T_ear::RIGHT };
+			for (int azimuth = 0; azimuth < 360; azimuth += 5)
+			{
+				for (int elevation = -90; elevation <= 90; elevation += 5)
+				{
+					float elevationAngle = (float)(elevation < 0 ? elevation + 360 : elevation);			// The toolkit uses elevations from 270 to 360 below the horizon
+					for (Common::T_ear ear : ears)
+					{
+						if (a->GetHRIRDelay(ear, (float)azimuth, elevationAngle, false) != b->GetHRIRDelay(ear, (float)azimuth, elevationAngle, false)) return false;
+						std::vector<CMonoBuffer<float>> x = a->GetHRIR_partitioned(ear, (float)azimuth, elevationAngle, false);
+						std::vector<CMonoBuffer<float>> y = b->GetHRIR_partitioned(ear, (float)azimuth, elevationAngle, false);
+						if (x.size() != y.size()) return false;
+						for (size_t p = 0; p < x.size(); p++)
+						{
+							if (x[p].size() != y[p].size()) return false;
+							if (std::memcmp(x[p].data(), y[p].data(), x[p].size() * sizeof(float)) != 0) return false;
+						}
+					}
+				}
+			}
+			return true;
+		}
+	}
+
+	bool Run(const std::string & name, int bufferSize)
+	{
+		if (name == "startup") RunStartup(bufferSize);
+		else if (name == "fft") RunFFT();
+		else if (name == "reverb") RunReverb(bufferSize);
+		else if (name == "crowd") RunCrowd(bufferSize);
+		else if (name == "precision") RunPrecision(bufferSize);
+		else if (name == "hrir") RunHRIRCache(bufferSize);
+		else if (name == "quantum") RunQuantum(bufferSize);
+		else if (name == "hahl") RunHAHL(bufferSize);
+		else return false;
+		return true;
+	}
+
+	void RunStartup(int bufferSize)
+	{
+		bool specifiedDelays;
+
+		std::cout << "Startup benchmark, buffer size " << bufferSize << std::endl;
+		printf("%6s %14s %10s %16s %10s %20s %10s\n", "step", "SOFA HRTF(ms)", "BRIR(ms)", "cache write(ms)", "warm(ms)", "warm + BRIR conc.(ms)", "identical");
+
+		int resamplingSteps[] = { 5, 10, 15 };
+		for (int step : resamplingSteps)
+		{
+			// Cold start, parsing the SOFA files
+			Binaural::CCore coldCore;
+			shared_ptr<Binaural::CListener> coldListener = SetupCore(coldCore, bufferSize, step);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			HRTF::CreateFromSofa(BENCHMARK_HRTF_FILE, coldListener, specifiedDelays);
+			double sofaTime = MillisecondsSince(start);
+
+			shared_ptr<Binaural::CEnvironment> environment = coldCore.CreateEnvironment();
+			environment->SetReverberationOrder(TReverberationOrder::BIDIMENSIONAL);
+			start = std::chrono::steady_clock::now();
+			BRIR::CreateFromSofa(BENCHMARK_BRIR_FILE, environment);
+			double brirTime = MillisecondsSince(start);
+
+			// Creating the cache file for this configuration, which also includes one SOFA parsing
+			Binaural::CCore cacheCore;
+			shared_ptr<Binaural::CListener> cacheListener = SetupCore(cacheCore, bufferSize, step);
+			uint64_t sofaHash = 0;
+			HRTFCache::HashFile(BENCHMARK_HRTF_FILE, sofaHash);
+			std::remove(HRTFCache::GetCacheFileName(BENCHMARK_HRTF_FILE, sofaHash, cacheCore).c_str());
+			start = std::chrono::steady_clock::now();
+			HRTFCache::CreateFromSofa(BENCHMARK_HRTF_FILE, cacheListener, specifiedDelays, cacheCore);
+			double cacheTime = MillisecondsSince(start);
+
+			// Warm start
+			Binaural::CCore warmCore;
+			shared_ptr<Binaural::CListener> warmListener = SetupCore(warmCore, bufferSize, step);
+			start = std::chrono::steady_clock::now();
+			HRTFCache::CreateFromSofa(BENCHMARK_HRTF_FILE, warmListener, specifiedDelays, warmCore);
+			double warmTime = MillisecondsSince(start);
+
+			// Warm start with the BRIR loaded in another thread, as the example does. The BRIR SOFA file is parsed under the
+			// SOFA mutex, which the warm HRTF load does not take as it reads the cache file, so both loads still overlap here.
+			Binaural::CCore concurrentCore;
+			shared_ptr<Binaural::CListener> concurrentListener = SetupCore(concurrentCore, bufferSize, step);
+			shared_ptr<Binaural::CEnvironment> concurrentEnvironment = concurrentCore.CreateEnvironment();
+			concurrentEnvironment->SetReverberationOrder(TReverberationOrder::BIDIMENSIONAL);
+			start = std::chrono::steady_clock::now();
+			std::future<bool> brirLoaded = std::async(std::launch::async, [&]() {
+				std::lock_guard<std::mutex> sofaLock(StartupPipeline::GetSofaMutex());
+				return BRIR::CreateFromSofa(BENCHMARK_BRIR_FILE, concurrentEnvironment);
+			});
+			HRTFCache::CreateFromSofa(BENCHMARK_HRTF_FILE, concurrentListener, specifiedDelays, concurrentCore);
+			brirLoaded.get();
+			double concurrentTime = MillisecondsSince(start);
+
+			// The cached HRTF must give the same raw table and the same resampled and partitioned HRIRs as the SOFA file
+			bool identical = AreIdentical(coldListener->GetHRTF()->GetRawHRTFTable(), warmListener->GetHRTF()->GetRawHRTFTable()) &&
+							 AreIdentical(coldListener->GetHRTF(), warmListener->GetHRTF()) &&
+							 AreIdentical(coldListener->GetHRTF(), concurrentListener->GetHRTF());
+
+			printf("%6d %14.1f %10.1f %16.1f %10.1f %20.1f %10s\n", step, sofaTime, brirTime, cacheTime, warmTime, concurrentTime, identical ? "yes" : "NO");
+		}
+	}
+
+	void RunFFT()
+	{
+		std::vector<const FFTBackend *> backends = FFTBackend::GetAvailable();
+		std::cout << "FFT benchmark, best backend for this CPU: " << FFTBackend::GetBest().GetName() << std::endl;
+		printf("%6s %6s %8s %16s %10s %12s\n", "block", "FFT", "backend", "fwd+inv(us)", "speedup", "max error");
+
+		std::mt19937 generator(1);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		for (int blockSize = 256; blockSize <= 4096; blockSize *= 2)
+		{
+			// The reverb transforms blocks padded with the previous block, twice their size
+			int size = 2 * blockSize;
+			std::vector<float> input(size);
+			for (float & sample : input) sample = distribution(generator);
+
+			FFT reference(size, backends[0]);
+			std::vector<std::complex<float>> referenceSpectrum(reference.GetNumberOfBins());
+			reference.Forward(input.data(), referenceSpectrum.data());
+
+			double referenceTime = 0.0;
+			for (const FFTBackend * backend : backends)
+			{
+				FFT fft(size, backend);
+				std::vector<std::complex<float>> spectrum(fft.GetNumberOfBins());
+				std::vector<float> output(size);
+
+				// Error of the spectrum against the radix-2 one and of the round trip against the input
+				fft.Forward(input.data(), spectrum.data());
+				fft.Inverse(spectrum.data(), output.data());
+				float maxError = 0.0f;
+				for (int k = 0; k < fft.GetNumberOfBins(); k++)
+					maxError = std::max(maxError, std::abs(spectrum[k] - referenceSpectrum[k]) / size);
+				for (int n = 0; n < size; n++)
+					maxError = std::max(maxError, std::abs(output[n] - input[n]));
+
+				// Enough iterations for about the same number of samples in every size
+				int iterations = (1 << 22) / size;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for (int i = 0; i < iterations; i++)
+				{
+					fft.Forward(output.data(), spectrum.data());
+					fft.Inverse(spectrum.data(), output.data());
+				}
+				double time = MillisecondsSince(start) * 1000.0 / iterations;
+				if (backend == backends[0]) referenceTime = time;
+
+				printf("%6d %6d %8s %16.2f %9.2fx %12.2e\n", blockSize, size, backend->GetName(), time, referenceTime / time, maxError);
+			}
+		}
+	}
+
+	void RunReverb(int bufferSize)
+	{
+		// The BRIR is loaded with the six virtual speakers, so that it can be used with every order
+		Binaural::CCore core;
+		SetupCore(core, bufferSize, 15);
+		shared_ptr<Binaural::CEnvironment> environment = core.CreateEnvironment();
+		environment->SetReverberationOrder(TReverberationOrder::THREEDIMENSIONAL);
+		if (!BRIR::CreateFromSofa(BENCHMARK_BRIR_FILE, environment))
+		{
+			std::cout << "Could not load " << BENCHMARK_BRIR_FILE << std::endl;
+			return;
+		}
+
+		// Sources spread around the listener, each one playing white noise
+		std::mt19937 generator(1);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		std::vector<CMonoBuffer<float>> sourceBuffers(BENCHMARK_REVERB_SOURCES, CMonoBuffer<float>(bufferSize));
+		std::vector<VirtualAmbisonicReverb::TSourceInput> sources(BENCHMARK_REVERB_SOURCES);
+		for (int s = 0; s < BENCHMARK_REVERB_SOURCES; s++)
+		{
+			for (float & sample : sourceBuffers[s]) sample = distribution(generator);
+			float angle = 2.0f * 3.14159265f * s / BENCHMARK_REVERB_SOURCES;
+			sources[s].buffer = &sourceBuffers[s];
+			sources[s].sourceTransform.SetPosition(Common::CVector3(2.0f * std::cos(angle), 2.0f * std::sin(angle), 0.5f * (s % 3 - 1)));
+		}
+		Common::CTransform listenerTransform;
+
+		int numberOfBlocks = BENCHMARK_REVERB_SECONDS * BENCHMARK_SAMPLERATE / bufferSize;
+		double blockDuration = 1000.0 * bufferSize / BENCHMARK_SAMPLERATE;
+		std::cout << "Reverb benchmark, buffer size " << bufferSize << " (" << blockDuration << " ms per block), " << BENCHMARK_REVERB_SOURCES << " sources, "
+				  << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+		printf("%18s %9s %8s %14s %14s %9s %11s %12s\n", "order", "channels", "threads", "mean(ms)", "worst(ms)", "speedup", "late tails", "difference");
+
+		TReverberationOrder orders[] = { TReverberationOrder::ADIMENSIONAL, TReverberationOrder::BIDIMENSIONAL, TReverberationOrder::THREEDIMENSIONAL };
+		const char * orderNames[] = { "ADIMENSIONAL", "BIDIMENSIONAL", "THREEDIMENSIONAL" };
+		for (int o = 0; o < 3; o++)
+		{
+			// Serial and parallel runs over the same input, keeping the output of the last block to compare them
+			double serialMean = 0.0;
+			std::vector<float> serialLast;
+			for (int parallel = 0; parallel < 2; parallel++)
+			{
+				VirtualAmbisonicReverb reverb(bufferSize, orders[o]);
+				std::shared_ptr<ThreadPool> threadPool;
+				if (parallel)
+				{
+					if (reverb.GetNumberOfChannels() < 2) continue;
+					threadPool = std::make_shared<ThreadPool>(reverb.GetNumberOfChannels() - 1);
+					reverb.SetThreadPool(threadPool.get());
+				}
+				if (!reverb.Setup(*environment->GetBRIR()))
+				{
+					std::cout << "The BRIR does not have the virtual speakers needed by " << orderNames[o] << std::endl;
+					break;
+				}
+
+				CMonoBuffer<float> outputLeft, outputRight;
+				double total = 0.0, worst = 0.0;
+				for (int b = 0; b < numberOfBlocks; b++)
+				{
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					reverb.Process(sources, listenerTransform, outputLeft, outputRight);
+					double time = MillisecondsSince(start);
+					total += time;
+					worst = std::max(worst, time);
+				}
+				double mean = total / numberOfBlocks;
+
+				float difference = 0.0f;
+				if (!parallel)
+				{
+					serialMean = mean;
+					serialLast = outputLeft;
+					serialLast.insert(serialLast.end(), outputRight.begin(), outputRight.end());
+				}
+				else
+				{
+					for (int n = 0; n < bufferSize; n++)
+						difference = std::max(difference, std::max(std::abs(outputLeft[n] - serialLast[n]), std::abs(outputRight[n] - serialLast[bufferSize + n])));
+				}
+
+				printf("%18s %9d %8u %14.4f %14.4f %8.2fx %11u %12.2e\n", orderNames[o], reverb.GetNumberOfChannels(), parallel ? threadPool->GetNumberOfThreads() : 1,
+					   mean, worst, serialMean / mean, reverb.GetNumberOfLateTails(), difference);
+			}
+		}
+	}
+
+	void RunCrowd(int bufferSize)
+	{
+		Binaural::CCore core;
+		shared_ptr<Binaural::CListener> listener = SetupCore(core, bufferSize, BENCHMARK_CROWD_STEP);
+		bool specifiedDelays;
+		if (!HRTFCache::CreateFromSofa(BENCHMARK_HRTF_FILE, listener, specifiedDelays, core))
+		{
+			std::cout << "Could not load " << BENCHMARK_HRTF_FILE << std::endl;
+			return;
+		}
+		std::cout << "Crowd benchmark, buffer size " << bufferSize << " (" << 1000.0 * bufferSize / BENCHMARK_SAMPLERATE << " ms per block), "
+				  << BENCHMARK_CROWD_STEP << " degree cells, FFT backend " << FFTBackend::GetBest().GetName() << std::endl;
+		printf("%8s %9s %13s %15s %12s %10s %16s %14s %12s\n", "sources", "occupied", "toolkit(ms)", "per source(ms)", "batched(ms)", "mixed(ms)", "batched speedup", "mixed speedup", "difference");
+
+		int sourceCounts[] = { 64, 128, 256 };
+		for (int numberOfSources : sourceCounts)
+		{
+			std::vector<CMonoBuffer<float>> sourceBuffers;
+			std::vector<CrowdRenderer::TSourceInput> sources;
+			CreateSources(numberOfSources, bufferSize, sourceBuffers, sources);				// Heads of people standing around the listener
+			std::vector<shared_ptr<Binaural::CSingleSourceDSP>> sourceDSPs(numberOfSources);
+			for (int s = 0; s < numberOfSources; s++)
+			{
+				sourceDSPs[s] = core.CreateSingleSourceDSP();
+				sourceDSPs[s]->SetSourceTransform(sources[s].sourceTransform);
+				sourceDSPs[s]->SetSpatializationMode(Binaural::TSpatializationMode::HighQuality);
+				sourceDSPs[s]->DisableNearFieldEffect();
+				sourceDSPs[s]->DisableReverbProcess();
+			}
+
+			// One source DSP per source, as the toolkit does
+			Common::CEarPair<CMonoBuffer<float>> sourceOutput, mix;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int b = 0; b < BENCHMARK_CROWD_BLOCKS; b++)
+			{
+				mix.left.assign(bufferSize, 0.0f);
+				mix.right.assign(bufferSize, 0.0f);
+				for (int s = 0; s < numberOfSources; s++)
+				{
+					sourceDSPs[s]->SetBuffer(sourceBuffers[s]);
+					sourceDSPs[s]->ProcessAnechoic(sourceOutput.left, sourceOutput.right);
+					for (int n = 0; n < bufferSize; n++)
+					{
+						mix.left[n] += sourceOutput.left[n];
+						mix.right[n] += sourceOutput.right[n];
+					}
+				}
+			}
+			double toolkitTime = MillisecondsSince(start) / BENCHMARK_CROWD_BLOCKS;
+			for (int s = 0; s < numberOfSources; s++) core.RemoveSingleSourceDSP(sourceDSPs[s]);
+
+			// The renderer in each mode, with the same sources
+			CrowdRenderer::TGroupingMode modes[] = { CrowdRenderer::PER_SOURCE, CrowdRenderer::BATCHED, CrowdRenderer::MIXED };
+			double times[3];
+			int occupiedCells = 0;
+			float difference = 0.0f;
+			Common::CTransform listenerTransform;
+			CMonoBuffer<float> outputLeft, outputRight, referenceLeft;
+			for (int m = 0; m < 3; m++)
+			{
+				CrowdRenderer renderer(bufferSize, BENCHMARK_CROWD_STEP);
+				renderer.Setup(*listener->GetHRTF());
+				renderer.SetGroupingMode(modes[m]);
+				start = std::chrono::steady_clock::now();
+				for (int b = 0; b < BENCHMARK_CROWD_BLOCKS; b++)
+					renderer.Process(sources, listenerTransform, outputLeft, outputRight);
+				times[m] = MillisecondsSince(start) / BENCHMARK_CROWD_BLOCKS;
+				occupiedCells = renderer.GetNumberOfOccupiedCells();
+
+				// The sources do not move, so all the modes give the same output
+				if (m == 0) referenceLeft = outputLeft;
+				for (int n = 0; n < bufferSize; n++)
+					difference = std::max(difference, std::abs(outputLeft[n] - referenceLeft[n]));
+			}
+
+			printf("%8d %9d %13.3f %15.3f %12.3f %10.3f %15.2fx %13.2fx %12.2e\n", numberOfSources, occupiedCells, toolkitTime,
+				   times[0], times[1], times[2], times[0] / times[1], times[0] / times[2], difference);
+		}
+	}
+
+	void RunPrecision(int bufferSize)
+	{
+		Binaural::CCore core;
+		shared_ptr<Binaural::CListener> listener = SetupCore(core, bufferSize, BENCHMARK_CROWD_STEP);
+		shared_ptr<Binaural::CEnvironment> environment = core.CreateEnvironment();
+		environment->SetReverberationOrder(TReverberationOrder::THREEDIMENSIONAL);
+		bool specifiedDelays;
+		if (!HRTFCache::CreateFromSofa(BENCHMARK_HRTF_FILE, listener, specifiedDelays, core) || !BRIR::CreateFromSofa(BENCHMARK_BRIR_FILE, environment))
+		{
+			std::cout << "Could not load " << BENCHMARK_HRTF_FILE << " or " << BENCHMARK_BRIR_FILE << std::endl;
+			return;
+		}
+
+		int numberOfBlocks = BENCHMARK_PRECISION_SECONDS * BENCHMARK_SAMPLERATE / bufferSize;
+		std::cout << "Precision benchmark, buffer size " << bufferSize << ", " << numberOfBlocks << " blocks, FFT backend " << FFTBackend::GetBest().GetName() << std::endl;
+		std::cout << "reverb: THREEDIMENSIONAL, time of the audio thread; crowd: " << BENCHMARK_PRECISION_SOURCES << " sources, BATCHED mode" << std::endl;
+		printf("%8s %12s %12s %11s %12s %10s %16s\n", "engine", "precision", "filters(KB)", "memory", "block(ms)", "speedup", "error(dB)");
+
+		SpectrumStorage::TPrecision precisions[] = { SpectrumStorage::FLOAT32, SpectrumStorage::FLOAT16, SpectrumStorage::BLOCK_INT16 };
+		size_t referenceSize = 0;
+		double referenceTime = 0.0;
+		std::vector<float> referenceOutput, output;
+		CMonoBuffer<float> outputLeft, outputRight;
+		Common::CTransform listenerTransform;
+
+		// Reverb, with the BRIR of the environment
+		std::vector<CMonoBuffer<float>> sourceBuffers;
+		std::vector<VirtualAmbisonicReverb::TSourceInput> reverbSources;
+		CreateSources(BENCHMARK_REVERB_SOURCES, bufferSize, sourceBuffers, reverbSources);
+		for (SpectrumStorage::TPrecision precision : precisions)
+		{
+			VirtualAmbisonicReverb reverb(bufferSize, TReverberationOrder::THREEDIMENSIONAL, 8, precision);
+			if (!reverb.Setup(*environment->GetBRIR())) return;
+			output.clear();
+			double total = 0.0;
+			for (int b = 0; b < numberOfBlocks; b++)
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				reverb.Process(reverbSources, listenerTransform, outputLeft, outputRight);
+				total += MillisecondsSince(start);
+				output.insert(output.end(), outputLeft.begin(), outputLeft.end());
+				output.insert(output.end(), outputRight.begin(), outputRight.end());
+			}
+			PrintPrecisionResult("reverb", precision, reverb.GetFilterSizeInBytes(), total / numberOfBlocks, output, referenceSize, referenceTime, referenceOutput);
+		}
+
+		// Crowd renderer, with the HRTF of the listener
+		std::vector<CrowdRenderer::TSourceInput> crowdSources;
+		CreateSources(BENCHMARK_PRECISION_SOURCES, bufferSize, sourceBuffers, crowdSources);
+		for (SpectrumStorage::TPrecision precision : precisions)
+		{
+			CrowdRenderer renderer(bufferSize, BENCHMARK_CROWD_STEP, precision);
+			renderer.Setup(*listener->GetHRTF());
+			renderer.SetGroupingMode(CrowdRenderer::BATCHED);
+			output.clear();
+			double total = 0.0;
+			for (int b = 0; b < numberOfBlocks; b++)
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				renderer.Process(crowdSources, listenerTransform, outputLeft, outputRight);
+				total += MillisecondsSince(start);
+				output.insert(output.end(), outputLeft.begin(), outputLeft.end());
+				output.insert(output.end(), outputRight.begin(), outputRight.end());
+			}
+			PrintPrecisionResult("crowd", precision, renderer.GetFilterSizeInBytes(), total / numberOfBlocks, output, referenceSize, referenceTime, referenceOutput);
+		}
+	}
+
+	void RunHRIRCache(int bufferSize)
+	{
+		Binaural::CCore core;
+		shared_ptr<Binaural::CListener> listener = SetupCore(core, bufferSize, 5);
+		bool specifiedDelays;
+		if (!HRTFCache::CreateFromSofa(BENCHMARK_HRTF_FILE, listener, specifiedDelays, core))
+		{
+			std::cout << "Could not load " << BENCHMARK_HRTF_FILE << std::endl;
+			return;
+		}
+
+		int numberOfBlocks = BENCHMARK_HRIR_SECONDS * BENCHMARK_SAMPLERATE / bufferSize;
+		std::cout << "HRIR cache benchmark, buffer size " << bufferSize << ", " << numberOfBlocks << " blocks, capacity " << BENCHMARK_HRIR_CAPACITY << " entries" << std::endl;
+		printf("%10s %8s %9s %10s %16s %12s %9s %12s\n", "trajectory", "step", "entries", "hit rate", "interpolate(us)", "cached(us)", "speedup", "memory(KB)");
+
+		Common::CTransform listenerTransform;
+		const char * trajectoryNames[] = { "drift", "orbit" };
+		float quantizationSteps[] = { 1.0f, 2.0f, 5.0f };
+		for (int orbit = 0; orbit < 2; orbit++)
+		{
+			std::vector<Common::CVector3> positions = CreateTrajectory(orbit != 0, numberOfBlocks, bufferSize);
+			std::vector<Common::CTransform> sourceTransforms(numberOfBlocks);
+			for (int b = 0; b < numberOfBlocks; b++) sourceTransforms[b].SetPosition(positions[b]);
+
+			// Without cache, as the HRIR of every block is interpolated for its exact direction
+			HRIRCache reference(bufferSize, 1.0f, 1);
+			reference.Setup(*listener->GetHRTF());
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int b = 0; b < numberOfBlocks; b++)
+			{
+				Common::CVector3 direction = listenerTransform.GetVectorTo(sourceTransforms[b]);
+				reference.Interpolate(direction.GetAzimuthDegrees(), direction.GetElevationDegrees());
+			}
+			double interpolateTime = MillisecondsSince(start) * 1000.0 / numberOfBlocks;
+
+			for (float step : quantizationSteps)
+			{
+				HRIRCache cache(bufferSize, step, BENCHMARK_HRIR_CAPACITY);
+				cache.Setup(*listener->GetHRTF());
+				start = std::chrono::steady_clock::now();
+				for (int b = 0; b < numberOfBlocks; b++)
+					cache.Get(sourceTransforms[b], listenerTransform);
+				double cachedTime = MillisecondsSince(start) * 1000.0 / numberOfBlocks;
+
+				double hitRate = 100.0 * cache.GetHits() / (cache.GetHits() + cache.GetMisses());
+				printf("%10s %7.0fd %9d %9.1f%% %16.2f %12.2f %8.2fx %12.1f\n", trajectoryNames[orbit], step, cache.GetNumberOfEntries(), hitRate,
+					   interpolateTime, cachedTime, interpolateTime / cachedTime, cache.GetSizeInBytes() / 1024.0);
+			}
+		}
+
+		// A crowd walking around the listener, as in the example, rendered by CrowdRenderer in BATCHED mode with its own cells and with the cache
+		std::vector<CMonoBuffer<float>> sourceBuffers;
+		std::vector<CrowdRenderer::TSourceInput> sources;
+		CreateSources(BENCHMARK_HRIR_CROWD_SOURCES, bufferSize, sourceBuffers, sources);
+		std::vector<Common::CVector3> startPositions(sources.size());
+		for (size_t s = 0; s < sources.size(); s++) startPositions[s] = sources[s].sourceTransform.GetPosition();
+
+		std::cout << std::endl << "Crowd of " << BENCHMARK_HRIR_CROWD_SOURCES << " sources walking a full turn per minute, BATCHED mode, cache capacity "
+				  << 4 * BENCHMARK_HRIR_CROWD_SOURCES << " entries" << std::endl;
+		printf("%18s %10s %9s %12s %12s\n", "cells", "occupied", "hit rate", "mean(ms)", "worst(ms)");
+		float cellSteps[] = { 0.0f, 1.0f, 2.0f, 5.0f };
+		for (float step : cellSteps)
+		{
+			CrowdRenderer renderer(bufferSize, BENCHMARK_CROWD_STEP);
+			renderer.SetGroupingMode(CrowdRenderer::BATCHED);
+			HRIRCache cache(bufferSize, step > 0.0f ? step : 1.0f, 4 * BENCHMARK_HRIR_CROWD_SOURCES);
+			if (step > 0.0f)
+			{
+				cache.Setup(*listener->GetHRTF());
+				renderer.SetHRIRCache(&cache);
+			}
+			renderer.Setup(*listener->GetHRTF());
+
+			CMonoBuffer<float> outputLeft, outputRight;
+			double total = 0.0, worst = 0.0;
+			int occupiedCells = 0;
+			for (int b = 0; b < numberOfBlocks; b++)
+			{
+				float angle = 2.0f * 3.14159265f / 60.0f * b * bufferSize / BENCHMARK_SAMPLERATE;
+				for (size_t s = 0; s < sources.size(); s++)
+				{
+					const Common::CVector3 & p = startPositions[s];
+					sources[s].sourceTransform.SetPosition(Common::CVector3(std::cos(angle) * p.x - std::sin(angle) * p.y, std::sin(angle) * p.x + std::cos(angle) * p.y, p.z));
+				}
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				renderer.Process(sources, listenerTransform, outputLeft, outputRight);
+				double time = MillisecondsSince(start);
+				total += time;
+				worst = std::max(worst, time);
+				occupiedCells = std::max(occupiedCells, renderer.GetNumberOfOccupiedCells());
+			}
+
+			char cells[32];
+			if (step > 0.0f) snprintf(cells, sizeof(cells), "cache %.0fd", step);
+			else snprintf(cells, sizeof(cells), "measured %dd", BENCHMARK_CROWD_STEP);
+			double hitRate = step > 0.0f ? 100.0 * cache.GetHits() / (cache.GetHits() + cache.GetMisses()) : 100.0;
+			printf("%18s %10d %8.1f%% %12.3f %12.3f\n", cells, occupiedCells, hitRate, total / numberOfBlocks, worst);
+		}
+	}
+
+	void RunQuantum(int bufferSize)
+	{
+		Binaural::CCore core;
+		shared_ptr<Binaural::CListener> listener = SetupCore(core, bufferSize, BENCHMARK_CROWD_STEP);
+		bool specifiedDelays;
+		if (!HRTFCache::CreateFromSofa(BENCHMARK_HRTF_FILE, listener, specifiedDelays, core))
+		{
+			std::cout << "Could not load " << BENCHMARK_HRTF_FILE << std::endl;
+			return;
+		}
+
+		int numberOfFrames = BENCHMARK_QUANTUM_SECONDS * BENCHMARK_SAMPLERATE;
+		std::cout << "Quantum benchmark, processing quantum " << bufferSize << ", " << BENCHMARK_QUANTUM_SOURCES << " sources in CrowdRenderer, "
+				  << BENCHMARK_QUANTUM_SECONDS << " seconds" << std::endl;
+		printf("%8s %10s %14s %16s %16s %10s %10s\n", "device", "callbacks", "quanta/call", "mean call(ms)", "worst call(ms)", "buffered", "identical");
+
+		// Sources play white noise that changes on every quantum, so that any misplaced sample changes the output
+		std::vector<CMonoBuffer<float>> sourceBuffers;
+		std::vector<CrowdRenderer::TSourceInput> sources;
+		CreateSources(BENCHMARK_QUANTUM_SOURCES, bufferSize, sourceBuffers, sources);
+		Common::CTransform listenerTransform;
+
+		int deviceSizes[] = { bufferSize, 441, 480, 1000, 2048, 4096 };
+		std::vector<float> referenceOutput;
+		for (int deviceSize : deviceSizes)
+		{
+			if (deviceSize < bufferSize) continue;											// Rejected by the example, see FixedQuantumAdapter.h
+			CrowdRenderer renderer(bufferSize, BENCHMARK_CROWD_STEP);
+			renderer.Setup(*listener->GetHRTF());
+			std::mt19937 generator(1);
+			std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+			FixedQuantumAdapter adapter(bufferSize, [&](Common::CEarPair<CMonoBuffer<float>> & bufferOutput) {
+				for (CMonoBuffer<float> & buffer : sourceBuffers)
+					for (float & sample : buffer) sample = distribution(generator);
+				renderer.Process(sources, listenerTransform, bufferOutput.left, bufferOutput.right);
+			});
+
+			int callbacks = numberOfFrames / deviceSize, maximumLatency = 0;
+			std::vector<float> output(2 * (size_t)callbacks * deviceSize);
+			unsigned long maximumQuanta = 0;
+			double total = 0.0, worst = 0.0;
+			for (int c = 0; c < callbacks; c++)
+			{
+				unsigned long quantaBefore = adapter.GetNumberOfQuanta();
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				adapter.Process(&output[2 * (size_t)c * deviceSize], deviceSize);
+				double time = MillisecondsSince(start);
+				total += time;
+				worst = std::max(worst, time);
+				maximumQuanta = std::max(maximumQuanta, adapter.GetNumberOfQuanta() - quantaBefore);
+				maximumLatency = std::max(maximumLatency, adapter.GetBufferedFrames());
+			}
+			if (deviceSize == bufferSize) referenceOutput = output;
+			size_t compared = std::min(output.size(), referenceOutput.size());
+
+			printf("%8d %10d %14lu %16.3f %16.3f %10d %10s\n", deviceSize, callbacks, maximumQuanta, total / callbacks, worst, maximumLatency,
+				   std::equal(output.begin(), output.begin() + compared, referenceOutput.begin()) ? "yes" : "NO");
+		}
+	}
+
+	void RunHAHL(int bufferSize)
+	{
+		int numberOfBlocks = BENCHMARK_HAHL_SECONDS * BENCHMARK_SAMPLERATE / bufferSize;
+		double blockDuration = 1000.0 * bufferSize / BENCHMARK_SAMPLERATE;
+		std::cout << "HAHL benchmark, block size " << bufferSize << " (" << blockDuration << " ms), hearing loss and hearing aid on both ears, "
+				  << BENCHMARK_HAHL_SECONDS << " seconds" << std::endl;
+		printf("%14s %8s %14s %16s %12s %16s %6s %10s\n", "version", "thread", "mean block(us)", "worst block(us)", "% of block", "listeners/core", "late", "identical");
+
+		// Mix of white noise whose level changes every second from -60 to -10 dBFS, so that the gains of all the bands keep moving
+		std::mt19937 generator(1);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		std::vector<float> input(2 * (size_t)numberOfBlocks * bufferSize);
+		for (size_t n = 0; n < input.size(); n++)
+		{
+			int second = (int)(n / (2 * BENCHMARK_SAMPLERATE));
+			input[n] = std::pow(10.0f, (-60.0f + 10.0f * (second % 6)) / 20.0f) * distribution(generator);
+		}
+
+		// The toolkit simulators, then the simplified model of VectorizedHAHL with its scalar reference, which must give the same output
+		struct TConfiguration { const char * version; HAHLStage::TImplementation implementation; bool hearingAid; bool worker; };
+		TConfiguration configurations[] = { { "toolkit HL", HAHLStage::TOOLKIT, false, false }, { "toolkit HL", HAHLStage::TOOLKIT, false, true },
+											{ "toolkit HA+HL", HAHLStage::TOOLKIT, true, false }, { "toolkit HA+HL", HAHLStage::TOOLKIT, true, true },
+											{ "scalar HA+HL", HAHLStage::VECTORIZED_SCALAR, true, false }, { "SSE2 HA+HL", HAHLStage::VECTORIZED, true, false },
+											{ "SSE2 HA+HL", HAHLStage::VECTORIZED, true, true } };
+		std::vector<float> referenceOutput;
+		for (const TConfiguration & configuration : configurations)
+		{
+			HAHLStage stage(BENCHMARK_SAMPLERATE, bufferSize);
+			stage.SetHearingLoss(Common::T_ear::BOTH, HAHL_EXAMPLE_AUDIOGRAM);
+			stage.SetHearingAid(configuration.hearingAid);
+			stage.SetImplementation(configuration.implementation);
+			if (configuration.worker) stage.StartWorker();
+
+			// In the worker thread, blocks are passed at the pace of a real device, as the worker is expected to have a whole block of time
+			std::vector<float> output(input.size());
+			Common::CEarPair<CMonoBuffer<float>> buffer;
+			double total = 0.0, worst = 0.0;
+			std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+			for (int b = 0; b < numberOfBlocks; b++)
+			{
+				const float * blockInput = &input[2 * (size_t)b * bufferSize];
+				buffer.left.assign(blockInput, blockInput + bufferSize);
+				buffer.right.assign(blockInput + bufferSize, blockInput + 2 * bufferSize);
+				if (configuration.worker)
+					std::this_thread::sleep_until(runStart + std::chrono::microseconds((long long)(1000.0 * b * blockDuration)));
+
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				stage.Process(buffer);
+				double time = MillisecondsSince(start);
+				total += time;
+				worst = std::max(worst, time);
+
+				std::copy(buffer.left.begin(), buffer.left.end(), &output[2 * (size_t)b * bufferSize]);
+				std::copy(buffer.right.begin(), buffer.right.end(), &output[(2 * (size_t)b + 1) * bufferSize]);
+			}
+
+			// The worker returns each block one call later, and must give the output of the audio thread configuration before it.
+			// The SSE2 implementation must give the output of the scalar one.
+			const char * identical = "-";
+			if (configuration.worker)
+				identical = std::equal(output.begin() + 2 * bufferSize, output.end(), referenceOutput.begin()) ? "yes" : "NO";
+			else if (configuration.implementation == HAHLStage::VECTORIZED)
+				identical = output == referenceOutput ? "yes" : "NO";
+			if (!configuration.worker) referenceOutput = output;
+
+			// In the worker thread, the time measured is only the exchange of blocks, so it does not tell how many listeners fit in a core
+			double mean = 1000.0 * total / numberOfBlocks;
+			char listeners[32];
+			if (configuration.worker) snprintf(listeners, sizeof(listeners), "-");
+			else snprintf(listeners, sizeof(listeners), "%.0f", 1000.0 * blockDuration / mean);
+			printf("%14s %8s %14.2f %16.2f %11.3f%% %16s %6u %10s\n", configuration.version, configuration.worker ? "worker" : "audio", mean, 1000.0 * worst,
+				   100.0 * mean / (1000.0 * blockDuration), listeners, stage.GetNumberOfLateBlocks(), identical);
+		}
+	}
+}
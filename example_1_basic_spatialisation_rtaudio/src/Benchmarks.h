@@ -0,0 +1,86 @@
+/**
+*
+* \brief Declaration of the benchmarks that can be run from the command line of the example project 1
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _BENCHMARKS_H_
+#define _BENCHMARKS_H_
+
+#include <string>
+
+namespace Benchmarks
+{
+	/** \brief Runs one of the benchmarks and prints its results through the console
+	*	\details Usage: example --benchmark <name> [bufferSize]. Available benchmarks:
+	*			 - startup: HRTF (cold, warm, and warm while the BRIR is loaded) and BRIR loading times for resampling steps of 5, 10 and 15 degrees
+	*			 - fft: forward and inverse transform time of each FFT backend supported by the CPU, for block sizes from 256 to 4096
+	*			 - reverb: time per block of the reverb with its Ambisonic channels processed serially and in parallel, for each reverberation order
+	*			 - crowd: time per block of 64, 128 and 256 sources spatialised by the toolkit and by CrowdRenderer in each grouping mode
+	*			 - precision: memory, time per block and error of the reverb and the crowd renderer with their filters stored in float32, float16 and int16
+	*			 - hrir: hit rate and time per block of HRIRCache for the trajectories of the moving sources of examples 1 and 2, against interpolating on every block
+	*			 - quantum: callback times of a crowd rendered in quanta of the buffer size through FixedQuantumAdapter, for several device buffer sizes
+	*			 - hahl: time per block of the hearing loss simulation of one listener, without and with the hearing aid, with the toolkit simulators and with VectorizedHAHL, in the audio thread and in a worker thread
+	*	\param [in] name name of the benchmark
+	*	\param [in] bufferSize buffer size of the core used by the benchmark
+	*	\retval false if there is no benchmark with that name
+	*/
+	bool Run(const std::string & name, int bufferSize);
+
+	/** \brief Measures the time needed to load the HRTF and the BRIR with several HRTF resampling steps
+	*	\param [in] bufferSize buffer size of the core
+	*/
+	void RunStartup(int bufferSize);
+
+	/** \brief Measures the FFT backends against the radix-2 one, with the transform sizes used by the reverb for block sizes from 256 to 4096
+	*/
+	void RunFFT();
+
+	/** \brief Measures the scaling of the reverb with its Ambisonic channels processed in a thread pool, for ADIMENSIONAL, BIDIMENSIONAL and THREEDIMENSIONAL orders
+	*	\param [in] bufferSize block size of the reverb. Must be a power of two.
+	*/
+	void RunReverb(int bufferSize);
+
+	/** \brief Measures the gain of grouping the sources of a crowd by HRTF direction cell, against one source DSP per source
+	*	\param [in] bufferSize buffer size of the core. Must be a power of two.
+	*/
+	void RunCrowd(int bufferSize);
+
+	/** \brief Measures the reverb (BRIR) and the crowd renderer (HRTF) with their filter spectra stored in each precision, against float32
+	*	\param [in] bufferSize block size. Must be a power of two.
+	*/
+	void RunPrecision(int bufferSize);
+
+	/** \brief Measures HRIRCache with several quantization steps on the drifting trajectory of example 1 and the orbit of example 2
+	*	\param [in] bufferSize partition size of the HRIRs, and the block size that sets the trajectories. Must be a power of two.
+	*/
+	void RunHRIRCache(int bufferSize);
+
+	/** \brief Measures FixedQuantumAdapter with device buffer sizes that are not the processing quantum, and checks that the output does not change
+	*	\param [in] bufferSize processing quantum. Must be a power of two.
+	*/
+	void RunQuantum(int bufferSize);
+
+	/** \brief Measures the cost of HAHLStage for one listener, without and with the hearing aid, with the toolkit simulators and with the scalar and SSE2
+	*		   implementations of VectorizedHAHL, in the audio thread and in a worker thread paced in real time
+	*	\param [in] bufferSize block size of the stage
+	*/
+	void RunHAHL(int bufferSize);
+}
+
+#endif
@@ -0,0 +1,390 @@
+/**
+*
+* \brief Implementation of CrowdRenderer, which spatialises many sources grouping them by HRTF direction cell
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "CrowdRenderer.h"
+#include <algorithm>
+#include <cmath>
+
+#define ANECHOIC_REFERENCE_DISTANCE		1.0f		// Distance without attenuation, in meters
+#define ANECHOIC_MINIMUM_DISTANCE		0.1f		// Closer sources are attenuated as if they were at this distance
+
+namespace
+{
+	const double PI = 3.14159265358979323846;
+
+	/** \brief Unit vector of a direction given in degrees, with elevations from -90 to 90
+	*/
+	void DirectionVector(double azimuth, double elevation, double vector[3])
+	{
+		double a = azimuth * PI / 180.0, e = elevation * PI / 180.0;
+		vector[0] = std::cos(a) * std::cos(e);
+		vector[1] = std::sin(a) * std::cos(e);
+		vector[2] = std::sin(e);
+	}
+}
+
+CrowdRenderer::CrowdRenderer(int blockSize, int resamplingStep, SpectrumStorage::TPrecision precision)
+	: blockSize{ blockSize }, resamplingStep{ resamplingStep }, numberOfAzimuths{ 360 / resamplingStep },
+	  numberOfCells{ (360 / resamplingStep) * (180 / resamplingStep + 1) }, numberOfPartitions{ 0 }, numberOfBins{ 0 },
+	  mode{ MIXED }, precision{ precision }, hrirCache{ nullptr }, numberOfOccupiedCells{ 0 }, ready{ false }
+{
+}
+
+bool CrowdRenderer::Setup(Binaural::CHRTF & hrtf)
+{
+	const T_HRTFTable & table = hrtf.GetRawHRTFTable();
+	if (table.empty()) return false;
+
+	// Directions of the table, with the elevations of the toolkit (0 to 90 and 270 to 360) moved to -90 to 90
+	std::vector<const THRIRStruct *> hrirs;
+	std::vector<double> directions;
+	for (auto it = table.begin(); it != table.end(); it++)
+	{
+		double elevation = it->first.elevation > 180 ? it->first.elevation - 360.0 : it->first.elevation;
+		double vector[3];
+		DirectionVector(it->first.azimuth, elevation, vector);
+		directions.insert(directions.end(), vector, vector + 3);
+		hrirs.push_back(&it->second);
+	}
+
+	// Each cell takes the HRIR measured closest to its centre
+	std::vector<const THRIRStruct *> cellHRIRs(numberOfCells);
+	size_t length = 0;
+	for (int cell = 0; cell < numberOfCells; cell++)
+	{
+		double centre[3];
+		DirectionVector((cell % numberOfAzimuths) * resamplingStep, -90.0 + (cell / numberOfAzimuths) * resamplingStep, centre);
+		size_t closest = 0;
+		double closestDot = -2.0;
+		for (size_t i = 0; i < hrirs.size(); i++)
+		{
+			double dot = centre[0] * directions[3 * i] + centre[1] * directions[3 * i + 1] + centre[2] * directions[3 * i + 2];
+			if (dot > closestDot)
+			{
+				closestDot = dot;
+				closest = i;
+			}
+		}
+		const THRIRStruct * hrir = hrirs[closest];
+		cellHRIRs[cell] = hrir;
+		length = std::max(length, std::max((size_t)hrir->leftDelay + hrir->leftHRIR.size(), (size_t)hrir->rightDelay + hrir->rightHRIR.size()));
+	}
+
+	fft.reset(new FFT(2 * blockSize));
+	numberOfBins = fft->GetNumberOfBins();
+	numberOfPartitions = (int)((length + blockSize - 1) / blockSize);
+	if (hrirCache) numberOfPartitions = std::max(numberOfPartitions, hrirCache->GetNumberOfPartitions());	// The input history must cover the interpolated delays
+
+	// Spectra of the partitions of each cell. The delay of the HRIR is part of its impulse response.
+	std::vector<float> impulseResponse;
+	std::vector<float> paddedPartition(2 * blockSize);
+	std::vector<std::complex<float>> spectrum(numberOfBins);
+	for (int ear = 0; ear < 2; ear++)
+	{
+		cellSpectra[ear].Setup(precision, numberOfCells * numberOfPartitions, numberOfBins);
+		for (int cell = 0; cell < numberOfCells; cell++)
+		{
+			const THRIRStruct * hrir = cellHRIRs[cell];
+			const CMonoBuffer<float> & samples = ear == 0 ? hrir->leftHRIR : hrir->rightHRIR;
+			impulseResponse.assign((size_t)numberOfPartitions * blockSize, 0.0f);
+			std::copy(samples.begin(), samples.end(), impulseResponse.begin() + (size_t)(ear == 0 ? hrir->leftDelay : hrir->rightDelay));
+			for (int p = 0; p < numberOfPartitions; p++)
+			{
+				std::fill(paddedPartition.begin(), paddedPartition.end(), 0.0f);
+				std::copy(impulseResponse.begin() + (size_t)p * blockSize, impulseResponse.begin() + (size_t)(p + 1) * blockSize, paddedPartition.begin());
+				fft->Forward(paddedPartition.data(), spectrum.data());
+				cellSpectra[ear].Store(cell * numberOfPartitions + p, spectrum.data());
+			}
+		}
+	}
+
+	cellStates.resize(numberOfCells);
+	for (int cell = 0; cell < numberOfCells; cell++)
+	{
+		ResetChannel(cellStates[cell]);
+		cellStates[cell].silentBlocks = numberOfPartitions + 1;
+	}
+	activeCells.clear();
+	activeCells.reserve(numberOfCells);
+	cellInput.assign(blockSize, 0.0f);
+	transformBuffer.assign(2 * blockSize, 0.0f);
+	accumulators[0].resize(numberOfBins);
+	accumulators[1].resize(numberOfBins);
+	groupSpectrum.resize(numberOfBins);
+	sourceStates.clear();
+	ready = true;
+	return true;
+}
+
+void CrowdRenderer::SetGroupingMode(TGroupingMode _mode)
+{
+	mode = _mode;
+}
+
+void CrowdRenderer::SetHRIRCache(HRIRCache * cache)
+{
+	hrirCache = cache;
+}
+
+bool CrowdRenderer::UsesHRIRCache() const
+{
+	return hrirCache != nullptr && mode != MIXED;
+}
+
+int CrowdRenderer::GetNumberOfOccupiedCells() const
+{
+	return numberOfOccupiedCells;
+}
+
+int CrowdRenderer::GetNumberOfCells() const
+{
+	return numberOfCells;
+}
+
+int CrowdRenderer::GetNumberOfPartitions() const
+{
+	return numberOfPartitions;
+}
+
+size_t CrowdRenderer::GetFilterSizeInBytes() const
+{
+	return cellSpectra[0].GetSizeInBytes() + cellSpectra[1].GetSizeInBytes();
+}
+
+void CrowdRenderer::ResetChannel(TChannelState & channel)
+{
+	channel.previousInput.assign(blockSize, 0.0f);
+	channel.delayLine.assign((size_t)numberOfPartitions * numberOfBins, std::complex<float>(0.0f, 0.0f));
+	channel.delayLinePosition = 0;
+	channel.silentBlocks = 0;
+}
+
+int CrowdRenderer::GetCell(const Common::CTransform & sourceTransform, const Common::CTransform & listenerTransform, float & gain) const
+{
+	Common::CVector3 direction = listenerTransform.GetVectorTo(sourceTransform);		// In the coordinates of the listener
+	float distance = direction.GetDistance();
+	gain = ANECHOIC_REFERENCE_DISTANCE / std::max(distance, ANECHOIC_MINIMUM_DISTANCE);
+	float azimuth = 0.0f, elevation = 0.0f;
+	if (distance > 0.0f)
+	{
+		azimuth = direction.GetAzimuthDegrees();
+		elevation = direction.GetElevationDegrees();
+	}
+	if (UsesHRIRCache()) return hrirCache->GetKey(azimuth, elevation);
+
+	if (elevation > 180.0f) elevation -= 360.0f;
+	int azimuthIndex = (int)std::floor(azimuth / resamplingStep + 0.5f) % numberOfAzimuths;
+	if (azimuthIndex < 0) azimuthIndex += numberOfAzimuths;
+	int elevationIndex = std::min(std::max((int)std::floor((elevation + 90.0f) / resamplingStep + 0.5f), 0), 180 / resamplingStep);
+	return elevationIndex * numberOfAzimuths + azimuthIndex;
+}
+
+void CrowdRenderer::TransformInput(TChannelState & channel, const float * input, float gain)
+{
+	std::copy(channel.previousInput.begin(), channel.previousInput.end(), transformBuffer.begin());
+	for (int n = 0; n < blockSize; n++)
+		channel.previousInput[n] = transformBuffer[blockSize + n] = gain * input[n];
+	channel.delayLinePosition = (channel.delayLinePosition + 1) % numberOfPartitions;
+	fft->Forward(transformBuffer.data(), &channel.delayLine[(size_t)channel.delayLinePosition * numberOfBins]);
+}
+
+CrowdRenderer::TFilter CrowdRenderer::GetFilter(int cell)
+{
+	TFilter filter;
+	if (UsesHRIRCache())
+	{
+		const HRIRCache::TEntry & entry = hrirCache->Get(cell);							// Valid until the next lookup, so it is used straight away
+		filter.spectra[0] = &entry.spectra[0];
+		filter.spectra[1] = &entry.spectra[1];
+		filter.firstPartition = 0;
+		filter.numberOfPartitions = hrirCache->GetNumberOfPartitions();
+	}
+	else
+	{
+		filter.spectra[0] = &cellSpectra[0];
+		filter.spectra[1] = &cellSpectra[1];
+		filter.firstPartition = cell * numberOfPartitions;
+		filter.numberOfPartitions = numberOfPartitions;
+	}
+	return filter;
+}
+
+void CrowdRenderer::Accumulate(const TChannelState & channel, const TFilter & filter, int ear, std::complex<float> * accumulator)
+{
+	for (int p = 0; p < filter.numberOfPartitions; p++)
+	{
+		int slot = (channel.delayLinePosition - p + numberOfPartitions) % numberOfPartitions;
+		filter.spectra[ear]->MultiplyAccumulate(*fft, filter.firstPartition + p, &channel.delayLine[(size_t)slot * numberOfBins], accumulator);
+	}
+}
+
+void CrowdRenderer::AddToOutput(const std::complex<float> * accumulator, float * output)
+{
+	// The first half is aliased by the circular convolution, the second half is the result
+	fft->Inverse(accumulator, transformBuffer.data());
+	for (int n = 0; n < blockSize; n++)
+		output[n] += transformBuffer[blockSize + n];
+}
+
+void CrowdRenderer::Process(const std::vector<TSourceInput> & sources, const Common::CTransform & listenerTransform, CMonoBuffer<float> & outputLeft, CMonoBuffer<float> & outputRight)
+{
+	outputLeft.assign(blockSize, 0.0f);
+	outputRight.assign(blockSize, 0.0f);
+	numberOfOccupiedCells = 0;
+	if (!ready) return;
+
+	float * outputs[2] = { outputLeft.data(), outputRight.data() };
+	const std::complex<float> zero(0.0f, 0.0f);
+
+	if (sourceStates.size() < sources.size())												// Only allocates when sources are added
+	{
+		size_t first = sourceStates.size();
+		sourceStates.resize(sources.size());
+		for (size_t s = first; s < sources.size(); s++) ResetChannel(sourceStates[s]);
+		sourceCells.resize(sources.size());
+		sourceGains.resize(sources.size());
+		sourceOrder.reserve(sources.size());
+	}
+
+	// Cell and gain of each source, and the sources sorted by cell
+	sourceOrder.clear();
+	for (size_t s = 0; s < sources.size(); s++)
+	{
+		if ((int)sources[s].buffer->size() < blockSize) continue;
+		sourceCells[s] = GetCell(sources[s].sourceTransform, listenerTransform, sourceGains[s]);
+		sourceOrder.push_back((int)s);
+	}
+	std::sort(sourceOrder.begin(), sourceOrder.end(), [this](int a, int b) { return sourceCells[a] != sourceCells[b] ? sourceCells[a] < sourceCells[b] : a < b; });
+	for (size_t i = 0; i < sourceOrder.size(); i++)
+		if (i == 0 || sourceCells[sourceOrder[i]] != sourceCells[sourceOrder[i - 1]]) numberOfOccupiedCells++;
+
+	if (mode == PER_SOURCE)
+	{
+		for (size_t i = 0; i < sourceOrder.size(); i++)
+		{
+			int s = sourceOrder[i];
+			TransformInput(sourceStates[s], sources[s].buffer->data(), sourceGains[s]);
+			TFilter filter = GetFilter(sourceCells[s]);
+			for (int ear = 0; ear < 2; ear++)
+			{
+				std::fill(accumulators[ear].begin(), accumulators[ear].end(), zero);
+				Accumulate(sourceStates[s], filter, ear, accumulators[ear].data());
+				AddToOutput(accumulators[ear].data(), outputs[ear]);
+			}
+		}
+	}
+	else if (mode == BATCHED)
+	{
+		for (size_t i = 0; i < sourceOrder.size(); i++)
+			TransformInput(sourceStates[sourceOrder[i]], sources[sourceOrder[i]].buffer->data(), sourceGains[sourceOrder[i]]);
+
+		for (size_t first = 0; first < sourceOrder.size(); )
+		{
+			int cell = sourceCells[sourceOrder[first]];
+			size_t end = first;
+			while (end < sourceOrder.size() && sourceCells[sourceOrder[end]] == cell) end++;
+
+			// The products are linear, so the input spectra of the sources are added before multiplying them by each HRIR partition
+			TFilter filter = GetFilter(cell);
+			std::fill(accumulators[0].begin(), accumulators[0].end(), zero);
+			std::fill(accumulators[1].begin(), accumulators[1].end(), zero);
+			for (int p = 0; p < filter.numberOfPartitions; p++)
+			{
+				const std::complex<float> * input = nullptr;
+				for (size_t i = first; i < end; i++)
+				{
+					const TChannelState & channel = sourceStates[sourceOrder[i]];
+					int slot = (channel.delayLinePosition - p + numberOfPartitions) % numberOfPartitions;
+					const std::complex<float> * sourceSpectrum = &channel.delayLine[(size_t)slot * numberOfBins];
+					if (i == first && end - first == 1)
+						input = sourceSpectrum;												// Single source, nothing to add
+					else
+					{
+						if (i == first) std::copy(sourceSpectrum, sourceSpectrum + numberOfBins, groupSpectrum.begin());
+						else fft->Accumulate(sourceSpectrum, groupSpectrum.data(), numberOfBins);
+						input = groupSpectrum.data();
+					}
+				}
+				filter.spectra[0]->MultiplyAccumulate(*fft, filter.firstPartition + p, input, accumulators[0].data());
+				filter.spectra[1]->MultiplyAccumulate(*fft, filter.firstPartition + p, input, accumulators[1].data());
+			}
+			AddToOutput(accumulators[0].data(), outputs[0]);
+			AddToOutput(accumulators[1].data(), outputs[1]);
+			first = end;
+		}
+	}
+	else
+	{
+		// Cells keep being convolved with silence after their last source leaves, until their input history is all zeros
+		for (size_t c = 0; c < activeCells.size(); )
+		{
+			TChannelState & state = cellStates[activeCells[c]];
+			if (++state.silentBlocks > numberOfPartitions)
+			{
+				activeCells[c] = activeCells.back();
+				activeCells.pop_back();
+			}
+			else c++;
+		}
+
+		for (size_t first = 0; first < sourceOrder.size(); )
+		{
+			int cell = sourceCells[sourceOrder[first]];
+			std::fill(cellInput.begin(), cellInput.end(), 0.0f);
+			for (; first < sourceOrder.size() && sourceCells[sourceOrder[first]] == cell; first++)
+			{
+				int s = sourceOrder[first];
+				const float * input = sources[s].buffer->data();
+				float gain = sourceGains[s];
+				for (int n = 0; n < blockSize; n++)
+					cellInput[n] += gain * input[n];
+			}
+
+			TChannelState & state = cellStates[cell];
+			if (state.silentBlocks > numberOfPartitions) activeCells.push_back(cell);		// Not in the list yet
+			state.silentBlocks = 0;
+			TransformInput(state, cellInput.data(), 1.0f);
+			TFilter filter = GetFilter(cell);
+			for (int ear = 0; ear < 2; ear++)
+			{
+				std::fill(accumulators[ear].begin(), accumulators[ear].end(), zero);
+				Accumulate(state, filter, ear, accumulators[ear].data());
+				AddToOutput(accumulators[ear].data(), outputs[ear]);
+			}
+		}
+
+		std::fill(cellInput.begin(), cellInput.end(), 0.0f);
+		for (size_t c = 0; c < activeCells.size(); c++)
+		{
+			int cell = activeCells[c];
+			TChannelState & state = cellStates[cell];
+			if (state.silentBlocks == 0) continue;
+			TransformInput(state, cellInput.data(), 1.0f);
+			TFilter filter = GetFilter(cell);
+			for (int ear = 0; ear < 2; ear++)
+			{
+				std::fill(accumulators[ear].begin(), accumulators[ear].end(), zero);
+				Accumulate(state, filter, ear, accumulators[ear].data());
+				AddToOutput(accumulators[ear].data(), outputs[ear]);
+			}
+		}
+	}
+}
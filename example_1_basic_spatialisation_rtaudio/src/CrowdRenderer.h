@@ -0,0 +1,155 @@
+/**
+*
+* \brief Declaration of CrowdRenderer, which spatialises many sources grouping them by HRTF direction cell
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _CROWDRENDERER_H_
+#define _CROWDRENDERER_H_
+
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+#include "FFT.h"
+#include "HRIRCache.h"
+#include "SpectrumStorage.h"
+#include <complex>
+#include <memory>
+#include <vector>
+
+/** \details Anechoic spatialisation of scenes with many sources, such as crowds. The directions around the listener are split into cells of
+*			 resamplingStep degrees, and each cell is given the HRIR (with its delay) measured closest to its centre. Sources in the same cell
+*			 use the same HRIR, so their convolution can be shared:
+*			 - PER_SOURCE: each source is convolved on its own, as a CSingleSourceDSP does. Reference for the other modes.
+*			 - BATCHED: each source keeps its own input spectra. For each partition, the spectra of all the sources of a cell are added
+*			   together first, so the HRIR partition is multiplied once per cell and ear, and the result is transformed back once per cell.
+*			   Sources moving to another cell bring their whole input history, as in PER_SOURCE.
+*			 - MIXED: the inputs of the sources of a cell are mixed before the convolution, so there is one convolution per occupied cell.
+*			 The convolution is uniformly partitioned, with partitions of blockSize samples. Distance attenuation is applied as a gain.
+*			 With an HRIRCache (see SetHRIRCache), the PER_SOURCE and BATCHED modes use the quantization cells of the cache instead, with the HRIR
+*			 interpolated for their centre, so the cells can be much smaller than the resampling step without precomputing all of them.
+*			 There is no interpolation between cells and no near field effect.
+*/
+class CrowdRenderer
+{
+public:
+	enum TGroupingMode { PER_SOURCE, BATCHED, MIXED };
+
+	/** \brief Input of one source to the renderer
+	*/
+	struct TSourceInput
+	{
+		const CMonoBuffer<float> * buffer;								// blockSize samples of the source
+		Common::CTransform sourceTransform;								// Position of the source
+	};
+
+	/** \param [in] blockSize number of samples of each call to Process. Must be a power of two.
+	*	\param [in] resamplingStep size of the direction cells, in degrees. Must divide 180.
+	*	\param [in] precision format the HRIR spectra of the cells are stored in
+	*/
+	CrowdRenderer(int blockSize, int resamplingStep, SpectrumStorage::TPrecision precision = SpectrumStorage::FLOAT32);
+
+	/** \brief Builds the HRIR spectra of every cell from the HRTF loaded into a listener. To be called once, not from the audio thread.
+	*	\param [in] hrtf HRTF of a listener, for example after HRTF::CreateFromSofa
+	*	\retval false if the HRTF is empty
+	*/
+	bool Setup(Binaural::CHRTF & hrtf);
+
+	/** \brief Selects how sources in the same cell are processed. Not to be called while Process is running.
+	*/
+	void SetGroupingMode(TGroupingMode mode);
+
+	/** \brief Takes the cells and their HRIRs from a cache in PER_SOURCE and BATCHED modes. MIXED mode keeps the cells of resamplingStep degrees.
+	*	\details To be called before Setup, with the cache already set up with the same block size. The cache is looked up from the audio thread.
+	*	\param [in] cache cache of interpolated HRIRs, or nullptr to use the cells of resamplingStep degrees
+	*/
+	void SetHRIRCache(HRIRCache * cache);
+
+	/** \brief Spatialises the sources and writes their mix into the output. To be called from the audio thread.
+	*	\details Memory is only allocated when the number of sources grows.
+	*	\param [in] sources input buffer and position of each source, in the same order in every call
+	*	\param [in] listenerTransform position and orientation of the listener
+	*	\param [out] outputLeft blockSize samples of the left ear
+	*	\param [out] outputRight blockSize samples of the right ear
+	*/
+	void Process(const std::vector<TSourceInput> & sources, const Common::CTransform & listenerTransform, CMonoBuffer<float> & outputLeft, CMonoBuffer<float> & outputRight);
+
+	/** \brief Returns the number of cells with at least one source in the last call to Process, quantization cells of the cache if it is used
+	*/
+	int GetNumberOfOccupiedCells() const;
+
+	int GetNumberOfCells() const;
+	int GetNumberOfPartitions() const;
+
+	/** \brief Returns the memory used by the HRIR spectra of all the cells, in bytes, without the cache
+	*/
+	size_t GetFilterSizeInBytes() const;
+
+private:
+	/** \brief Input history of a source (PER_SOURCE and BATCHED modes) or of a cell (MIXED mode)
+	*/
+	struct TChannelState
+	{
+		std::vector<float> previousInput;							// Last blockSize samples, the first half of the next transform
+		std::vector<std::complex<float>> delayLine;					// Spectra of the last numberOfPartitions transforms
+		int delayLinePosition;										// Partition of delayLine holding the newest spectrum
+		int silentBlocks;											// Blocks since the last input, to stop processing cells whose output has decayed
+	};
+
+	/** \brief HRIR partitions of a cell, in cellSpectra or in an entry of the cache
+	*/
+	struct TFilter
+	{
+		const SpectrumStorage * spectra[2];							// Left and right
+		int firstPartition;
+		int numberOfPartitions;
+	};
+
+	bool UsesHRIRCache() const;
+	int GetCell(const Common::CTransform & sourceTransform, const Common::CTransform & listenerTransform, float & gain) const;
+	TFilter GetFilter(int cell);
+	void ResetChannel(TChannelState & channel);
+	void TransformInput(TChannelState & channel, const float * input, float gain);
+	void Accumulate(const TChannelState & channel, const TFilter & filter, int ear, std::complex<float> * accumulator);
+	void AddToOutput(const std::complex<float> * accumulator, float * output);
+
+	int blockSize;
+	int resamplingStep;
+	int numberOfAzimuths;											// Cells in each ring of elevation
+	int numberOfCells;
+	int numberOfPartitions;
+	int numberOfBins;
+	TGroupingMode mode;
+	SpectrumStorage::TPrecision precision;
+	std::unique_ptr<FFT> fft;										// Transform of size 2 * blockSize
+	SpectrumStorage cellSpectra[2];									// Left and right HRIR partitions of every cell, partition p of cell c at c * numberOfPartitions + p
+	HRIRCache * hrirCache;											// Cells and HRIRs of PER_SOURCE and BATCHED modes, if set
+
+	std::vector<TChannelState> sourceStates;						// PER_SOURCE and BATCHED modes
+	std::vector<TChannelState> cellStates;							// MIXED mode
+	std::vector<int> sourceCells;									// Cell of each source in the current block
+	std::vector<float> sourceGains;									// Distance attenuation of each source in the current block
+	std::vector<int> sourceOrder;									// Sources sorted by cell, BATCHED mode
+	std::vector<float> cellInput;									// Mix of the sources of one cell, MIXED mode
+	std::vector<int> activeCells;									// Cells with sources or still convolving their last input, MIXED mode
+	std::vector<float> transformBuffer;								// 2 * blockSize samples
+	std::vector<std::complex<float>> accumulators[2];
+	std::vector<std::complex<float>> groupSpectrum;					// Sum of the input spectra of the sources of one cell, BATCHED mode
+	int numberOfOccupiedCells;
+	bool ready;
+};
+
+#endif
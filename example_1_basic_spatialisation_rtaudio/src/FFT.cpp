@@ -0,0 +1,97 @@
+/**
+*
+* \brief Implementation of FFT, a real-input fast Fourier transform used by the partitioned convolution of the reverb
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "FFT.h"
+
+FFT::FFT(int size, const FFTBackend * backend)
+	: size{ size }, halfSize{ size / 2 }, plan{ FFTPlan::Get(size / 2) }, backend{ backend != nullptr ? backend : &FFTBackend::GetBest() }
+{
+	work.resize(halfSize);
+	transformed.resize(halfSize);
+}
+
+int FFT::GetSize() const
+{
+	return size;
+}
+
+int FFT::GetNumberOfBins() const
+{
+	return halfSize + 1;
+}
+
+const char * FFT::GetBackendName() const
+{
+	return backend->GetName();
+}
+
+const FFTBackend & FFT::GetBackend() const
+{
+	return *backend;
+}
+
+void FFT::Forward(const float * input, std::complex<float> * spectrum)
+{
+	// Even samples are packed in the real part and odd samples in the imaginary part of a transform of half the size
+	for (int n = 0; n < halfSize; n++)
+		work[n] = std::complex<float>(input[2 * n], input[2 * n + 1]);
+	backend->Transform(*plan, work.data(), transformed.data(), false);
+
+	// Splitting the transforms of the even and odd samples and combining them into the transform of the whole signal
+	for (int k = 0; k <= halfSize; k++)
+	{
+		std::complex<float> z = transformed[k % halfSize];
+		std::complex<float> zMirror = std::conj(transformed[(halfSize - k) % halfSize]);
+		std::complex<float> even = 0.5f * (z + zMirror);
+		std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (z - zMirror);
+		spectrum[k] = even + plan->realTwiddles[k] * odd;
+	}
+}
+
+void FFT::Inverse(const std::complex<float> * spectrum, float * output)
+{
+	for (int k = 0; k < halfSize; k++)
+	{
+		std::complex<float> x = spectrum[k];
+		std::complex<float> xMirror = std::conj(spectrum[halfSize - k]);
+		std::complex<float> even = 0.5f * (x + xMirror);
+		std::complex<float> odd = 0.5f * (x - xMirror) * std::conj(plan->realTwiddles[k]);
+		work[k] = even + std::complex<float>(0.0f, 1.0f) * odd;
+	}
+	backend->Transform(*plan, work.data(), transformed.data(), true);
+
+	float scale = 1.0f / halfSize;
+	for (int n = 0; n < halfSize; n++)
+	{
+		output[2 * n] = transformed[n].real() * scale;
+		output[2 * n + 1] = transformed[n].imag() * scale;
+	}
+}
+
+void FFT::MultiplyAccumulate(const std::complex<float> * a, const std::complex<float> * b, std::complex<float> * accumulator, int numberOfBins) const
+{
+	backend->MultiplyAccumulate(a, b, accumulator, numberOfBins);
+}
+
+void FFT::Accumulate(const std::complex<float> * a, std::complex<float> * accumulator, int numberOfBins) const
+{
+	backend->Accumulate(a, accumulator, numberOfBins);
+}
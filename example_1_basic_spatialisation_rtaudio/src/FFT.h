@@ -0,0 +1,92 @@
+/**
+*
+* \brief Declaration of FFT, a real-input fast Fourier transform used by the partitioned convolution of the reverb
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _FFT_H_
+#define _FFT_H_
+
+#include "FFTBackend.h"
+#include "FFTPlan.h"
+#include <complex>
+#include <memory>
+#include <vector>
+
+class FFT
+{
+public:
+	/** \brief Prepares a transform, sharing the plan of its size with the other transforms of the same size
+	*	\param [in] size number of real samples of the transform. Must be a power of two, 4 or greater.
+	*	\param [in] backend backend computing the transform, or nullptr for the fastest one supported by the CPU
+	*/
+	FFT(int size, const FFTBackend * backend = nullptr);
+
+	/** \brief Transforms size real samples into size / 2 + 1 complex bins
+	*	\param [in] input size real samples
+	*	\param [out] spectrum size / 2 + 1 bins, from DC to Nyquist
+	*/
+	void Forward(const float * input, std::complex<float> * spectrum);
+
+	/** \brief Transforms size / 2 + 1 complex bins back into size real samples, including the 1 / size scale
+	*	\param [in] spectrum size / 2 + 1 bins, from DC to Nyquist
+	*	\param [out] output size real samples
+	*/
+	void Inverse(const std::complex<float> * spectrum, float * output);
+
+	/** \brief Returns the number of real samples of the transform
+	*/
+	int GetSize() const;
+
+	/** \brief Returns the number of complex bins of the spectrum, size / 2 + 1
+	*/
+	int GetNumberOfBins() const;
+
+	/** \brief Returns the name of the backend computing the transform
+	*/
+	const char * GetBackendName() const;
+
+	/** \brief Returns the backend computing the transform
+	*/
+	const FFTBackend & GetBackend() const;
+
+	/** \brief Multiplies two spectra bin by bin and adds the result to a third one
+	*	\param [in] a first spectrum
+	*	\param [in] b second spectrum
+	*	\param [in,out] accumulator spectrum the products are added to
+	*	\param [in] numberOfBins number of bins of the three spectra
+	*/
+	void MultiplyAccumulate(const std::complex<float> * a, const std::complex<float> * b, std::complex<float> * accumulator, int numberOfBins) const;
+
+	/** \brief Adds a spectrum to another one bin by bin
+	*	\param [in] a spectrum to add
+	*	\param [in,out] accumulator spectrum it is added to
+	*	\param [in] numberOfBins number of bins of both spectra
+	*/
+	void Accumulate(const std::complex<float> * a, std::complex<float> * accumulator, int numberOfBins) const;
+
+private:
+	int size;														// Number of real samples
+	int halfSize;													// Size of the complex transform the real one is computed with
+	std::shared_ptr<const FFTPlan> plan;							// Tables of the complex transform, shared by all the transforms of this size
+	const FFTBackend * backend;
+	std::vector<std::complex<float>> work;							// Packed samples of the complex transform
+	std::vector<std::complex<float>> transformed;					// Output of the complex transform, which is computed out of place
+};
+
+#endif
@@ -0,0 +1,261 @@
+/**
+*
+* \brief Implementation of the scalar FFT backends and of the selection of the best one for the CPU
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "FFTBackend.h"
+#include <cmath>
+#include <cstring>
+
+void FFTBackend::MultiplyAccumulate(const std::complex<float> * a, const std::complex<float> * b, std::complex<float> * accumulator, int numberOfBins) const
+{
+	// Written out instead of using std::complex multiplication, which also handles infinities and is much slower
+	const float * x = reinterpret_cast<const float *>(a);
+	const float * y = reinterpret_cast<const float *>(b);
+	float * z = reinterpret_cast<float *>(accumulator);
+	for (int k = 0; k < numberOfBins; k++)
+	{
+		float xr = x[2 * k], xi = x[2 * k + 1];
+		float yr = y[2 * k], yi = y[2 * k + 1];
+		z[2 * k] += xr * yr - xi * yi;
+		z[2 * k + 1] += xr * yi + xi * yr;
+	}
+}
+
+void FFTBackend::Accumulate(const std::complex<float> * a, std::complex<float> * accumulator, int numberOfBins) const
+{
+	const float * x = reinterpret_cast<const float *>(a);
+	float * z = reinterpret_cast<float *>(accumulator);
+	for (int k = 0; k < 2 * numberOfBins; k++)
+		z[k] += x[k];
+}
+
+void FFTBackend::MultiplyAccumulateHalf(const std::complex<float> * a, const uint16_t * b, std::complex<float> * accumulator, int numberOfBins) const
+{
+	const float * x = reinterpret_cast<const float *>(a);
+	float * z = reinterpret_cast<float *>(accumulator);
+	for (int k = 0; k < numberOfBins; k++)
+	{
+		float xr = x[2 * k], xi = x[2 * k + 1];
+		float yr = HalfToFloat(b[2 * k]), yi = HalfToFloat(b[2 * k + 1]);
+		z[2 * k] += xr * yr - xi * yi;
+		z[2 * k + 1] += xr * yi + xi * yr;
+	}
+}
+
+void FFTBackend::MultiplyAccumulateBlockInt16(const std::complex<float> * a, const int16_t * b, const float * blockScales, std::complex<float> * accumulator, int numberOfBins) const
+{
+	const float * x = reinterpret_cast<const float *>(a);
+	float * z = reinterpret_cast<float *>(accumulator);
+	for (int k = 0; k < numberOfBins; k++)
+	{
+		float scale = blockScales[k / SPECTRUM_BLOCK_BINS];
+		float xr = x[2 * k], xi = x[2 * k + 1];
+		float yr = b[2 * k] * scale, yi = b[2 * k + 1] * scale;
+		z[2 * k] += xr * yr - xi * yi;
+		z[2 * k + 1] += xr * yi + xi * yr;
+	}
+}
+
+uint16_t FFTBackend::FloatToHalf(float value)
+{
+	uint32_t x;
+	std::memcpy(&x, &value, sizeof(x));
+	uint32_t sign = (x >> 16) & 0x8000;
+	int32_t exponent = (int32_t)((x >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = x & 0x7fffff;
+
+	if (((x >> 23) & 0xff) == 0xff) return (uint16_t)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));	// Infinity and NaN
+	if (exponent >= 31) return (uint16_t)(sign | 0x7bff);
+	if (exponent <= 0)
+	{
+		// Subnormal half
+		if (exponent < -10) return (uint16_t)sign;
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		uint32_t half = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1))) half++;
+		return (uint16_t)(sign | half);
+	}
+
+	// Rounding may carry into the exponent, which gives the right result
+	uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half++;
+	if (half >= 0x7c00) half = 0x7bff;
+	return (uint16_t)(sign | half);
+}
+
+float FFTBackend::HalfToFloat(uint16_t value)
+{
+	uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+
+	uint32_t x;
+	if (exponent == 0)
+	{
+		float subnormal = std::ldexp((float)mantissa, -24);
+		return sign != 0 ? -subnormal : subnormal;
+	}
+	else if (exponent == 31)
+		x = sign | 0x7f800000 | (mantissa << 13);
+	else
+		x = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	float result;
+	std::memcpy(&result, &x, sizeof(result));
+	return result;
+}
+
+const FFTBackend & FFTBackend::GetBest()
+{
+	static const FFTBackend * best = GetAvailable().back();
+	return *best;
+}
+
+std::vector<const FFTBackend *> FFTBackend::GetAvailable()
+{
+	static FFTBackendRadix2 radix2;
+	static FFTBackendRadix4 radix4;
+
+	// From slowest to fastest
+	std::vector<const FFTBackend *> backends;
+	backends.push_back(&radix2);
+	backends.push_back(&radix4);
+	const FFTBackend * simdBackends[] = { GetFFTBackendNEON(), GetFFTBackendSSE2(), GetFFTBackendAVX2() };
+	for (const FFTBackend * backend : simdBackends)
+		if (backend != nullptr) backends.push_back(backend);
+	return backends;
+}
+
+const FFTBackend * FFTBackend::GetByName(const std::string & name)
+{
+	std::vector<const FFTBackend *> backends = GetAvailable();
+	for (size_t i = 0; i < backends.size(); i++)
+		if (name == backends[i]->GetName()) return backends[i];
+	return nullptr;
+}
+
+const char * FFTBackendRadix2::GetName() const
+{
+	return "radix2";
+}
+
+void FFTBackendRadix2::Transform(const FFTPlan & plan, const std::complex<float> * input, std::complex<float> * output, bool inverse) const
+{
+	// Iterative radix-2 decimation in time
+	int size = plan.size;
+	for (int i = 0; i < size; i++)
+		output[i] = input[plan.bitReversal[i]];
+
+	for (int length = 2; length <= size; length <<= 1)
+	{
+		int half = length >> 1;
+		int twiddleStep = size / length;
+		for (int start = 0; start < size; start += length)
+		{
+			for (int k = 0; k < half; k++)
+			{
+				std::complex<float> w = plan.radix2Twiddles[k * twiddleStep];
+				if (inverse) w = std::conj(w);
+				std::complex<float> & a = output[start + k];
+				std::complex<float> & b = output[start + k + half];
+				float tr = b.real() * w.real() - b.imag() * w.imag();
+				float ti = b.real() * w.imag() + b.imag() * w.real();
+				b = std::complex<float>(a.real() - tr, a.imag() - ti);
+				a = std::complex<float>(a.real() + tr, a.imag() + ti);
+			}
+		}
+	}
+}
+
+const char * FFTBackendRadix4::GetName() const
+{
+	return "radix4";
+}
+
+void FFTBackendRadix4::Transform(const FFTPlan & plan, const std::complex<float> * input, std::complex<float> * output, bool inverse) const
+{
+	int size = plan.size;
+	for (int i = 0; i < size; i++)
+		output[i] = input[plan.radix4Permutation[i]];
+
+	if (plan.radix2FirstStage)
+	{
+		for (int i = 0; i < size; i += 2)
+		{
+			std::complex<float> a = output[i];
+			std::complex<float> b = output[i + 1];
+			output[i] = a + b;
+			output[i + 1] = a - b;
+		}
+	}
+
+	const std::vector<std::complex<float>> & twiddles = inverse ? plan.radix4InverseTwiddles : plan.radix4Twiddles;
+	for (size_t s = 0; s < plan.radix4Stages.size(); s++)
+	{
+		const FFTPlan::TRadix4Stage & stage = plan.radix4Stages[s];
+		const std::complex<float> * w1 = &twiddles[stage.twiddleOffset];
+		Radix4Stage(output, size, stage.quarter, w1, w1 + stage.quarter, w1 + 2 * stage.quarter, inverse);
+	}
+}
+
+void FFTBackendRadix4::Radix4Stage(std::complex<float> * data, int size, int quarter, const std::complex<float> * w1, const std::complex<float> * w2, const std::complex<float> * w3, bool inverse) const
+{
+	ScalarRadix4Stage(data, size, quarter, w1, w2, w3, inverse);
+}
+
+void FFTBackendRadix4::ScalarRadix4Stage(std::complex<float> * data, int size, int quarter, const std::complex<float> * w1, const std::complex<float> * w2, const std::complex<float> * w3, bool inverse)
+{
+	float * d = reinterpret_cast<float *>(data);
+	const float * t1w = reinterpret_cast<const float *>(w1);
+	const float * t2w = reinterpret_cast<const float *>(w2);
+	const float * t3w = reinterpret_cast<const float *>(w3);
+	for (int start = 0; start < size; start += 4 * quarter)
+	{
+		for (int k = 0; k < quarter; k++)
+		{
+			float * x0 = d + 2 * (start + k);
+			float * x1 = x0 + 2 * quarter;
+			float * x2 = x1 + 2 * quarter;
+			float * x3 = x2 + 2 * quarter;
+
+			float a0r = x0[0], a0i = x0[1];
+			float a1r = x1[0] * t1w[2 * k] - x1[1] * t1w[2 * k + 1], a1i = x1[0] * t1w[2 * k + 1] + x1[1] * t1w[2 * k];
+			float a2r = x2[0] * t2w[2 * k] - x2[1] * t2w[2 * k + 1], a2i = x2[0] * t2w[2 * k + 1] + x2[1] * t2w[2 * k];
+			float a3r = x3[0] * t3w[2 * k] - x3[1] * t3w[2 * k + 1], a3i = x3[0] * t3w[2 * k + 1] + x3[1] * t3w[2 * k];
+
+			float s02r = a0r + a2r, s02i = a0i + a2i;
+			float d02r = a0r - a2r, d02i = a0i - a2i;
+			float s13r = a1r + a3r, s13i = a1i + a3i;
+			float d13r = a1r - a3r, d13i = a1i - a3i;
+
+			// d13 multiplied by -i for the forward transform and by i for the inverse one
+			float jr = inverse ? -d13i : d13i;
+			float ji = inverse ? d13r : -d13r;
+
+			x0[0] = s02r + s13r;	x0[1] = s02i + s13i;
+			x1[0] = d02r + jr;		x1[1] = d02i + ji;
+			x2[0] = s02r - s13r;	x2[1] = s02i - s13i;
+			x3[0] = d02r - jr;		x3[1] = d02i - ji;
+		}
+	}
+}
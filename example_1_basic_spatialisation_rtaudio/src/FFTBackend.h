@@ -0,0 +1,128 @@
+/**
+*
+* \brief Declaration of the FFT backends (scalar, SSE2, AVX2 and NEON) and of the selection of the best one for the CPU
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _FFTBACKEND_H_
+#define _FFTBACKEND_H_
+
+#include "FFTPlan.h"
+#include <complex>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define SPECTRUM_BLOCK_BINS	32				// Bins sharing one scale in block floating point int16 spectra
+
+/** \details Complex transforms and spectral products of an FFT. Backends have no state, the same instance is used by all the transforms.
+*/
+class FFTBackend
+{
+public:
+	virtual ~FFTBackend() {}
+
+	/** \brief Returns the name of the backend, as shown by the benchmarks
+	*/
+	virtual const char * GetName() const = 0;
+
+	/** \brief Computes the complex transform of plan.size samples, without scaling
+	*	\param [in] plan tables of the size of the transform
+	*	\param [in] input plan.size complex samples
+	*	\param [out] output plan.size complex bins. Must not overlap with input.
+	*	\param [in] inverse true for the inverse transform
+	*/
+	virtual void Transform(const FFTPlan & plan, const std::complex<float> * input, std::complex<float> * output, bool inverse) const = 0;
+
+	/** \brief Multiplies two spectra bin by bin and adds the result to a third one
+	*/
+	virtual void MultiplyAccumulate(const std::complex<float> * a, const std::complex<float> * b, std::complex<float> * accumulator, int numberOfBins) const;
+
+	/** \brief Adds a spectrum to another one bin by bin
+	*/
+	virtual void Accumulate(const std::complex<float> * a, std::complex<float> * accumulator, int numberOfBins) const;
+
+	/** \brief Same as MultiplyAccumulate, with the second spectrum in half precision, converted inside the product
+	*	\param [in] b 2 * numberOfBins half precision floats, real and imaginary parts interleaved
+	*/
+	virtual void MultiplyAccumulateHalf(const std::complex<float> * a, const uint16_t * b, std::complex<float> * accumulator, int numberOfBins) const;
+
+	/** \brief Same as MultiplyAccumulate, with the second spectrum in block floating point int16, converted inside the product
+	*	\param [in] b 2 * numberOfBins integers, real and imaginary parts interleaved
+	*	\param [in] blockScales scale of each block of SPECTRUM_BLOCK_BINS bins of b, the last one may be shorter
+	*/
+	virtual void MultiplyAccumulateBlockInt16(const std::complex<float> * a, const int16_t * b, const float * blockScales, std::complex<float> * accumulator, int numberOfBins) const;
+
+	/** \brief Converts a float into a half precision float, rounding to nearest even. Values out of range are saturated.
+	*/
+	static uint16_t FloatToHalf(float value);
+
+	/** \brief Converts a half precision float into a float, which is exact
+	*/
+	static float HalfToFloat(uint16_t value);
+
+	/** \brief Returns the fastest backend supported by the CPU running the program. The CPU is checked the first time.
+	*/
+	static const FFTBackend & GetBest();
+
+	/** \brief Returns all the backends supported by the CPU running the program, the radix-2 one first
+	*/
+	static std::vector<const FFTBackend *> GetAvailable();
+
+	/** \brief Returns the backend with the given name, or nullptr if it is not supported by the CPU running the program
+	*/
+	static const FFTBackend * GetByName(const std::string & name);
+};
+
+/** \details Iterative radix-2 transform, the reference for the other backends
+*/
+class FFTBackendRadix2 : public FFTBackend
+{
+public:
+	const char * GetName() const override;
+	void Transform(const FFTPlan & plan, const std::complex<float> * input, std::complex<float> * output, bool inverse) const override;
+};
+
+/** \details Iterative radix-4 transform, with a radix-2 first stage when the size is not a power of four.
+*			 The SIMD backends derive from it and replace the stages with enough butterflies to fill their registers.
+*/
+class FFTBackendRadix4 : public FFTBackend
+{
+public:
+	const char * GetName() const override;
+	void Transform(const FFTPlan & plan, const std::complex<float> * input, std::complex<float> * output, bool inverse) const override;
+
+protected:
+	/** \brief Combines groups of four transforms of quarter samples into transforms of 4 * quarter samples
+	*	\param [in,out] data size complex samples
+	*	\param [in] w1, w2, w3 twiddles w^k, w^2k and w^3k, quarter values each (conjugated for the inverse transform)
+	*/
+	virtual void Radix4Stage(std::complex<float> * data, int size, int quarter, const std::complex<float> * w1, const std::complex<float> * w2, const std::complex<float> * w3, bool inverse) const;
+
+	/** \brief Scalar stage, used by the SIMD backends for the first stages, where quarter is smaller than their registers
+	*/
+	static void ScalarRadix4Stage(std::complex<float> * data, int size, int quarter, const std::complex<float> * w1, const std::complex<float> * w2, const std::complex<float> * w3, bool inverse);
+};
+
+/** \brief Returns the SIMD backends if they are compiled for this architecture and supported by the CPU, nullptr otherwise
+*/
+const FFTBackend * GetFFTBackendSSE2();
+const FFTBackend * GetFFTBackendAVX2();
+const FFTBackend * GetFFTBackendNEON();
+
+#endif
@@ -0,0 +1,205 @@
+/**
+*
+* \brief Implementation of the AVX2 FFT backend
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "FFTBackend.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <algorithm>
+
+// The rest of the program is compiled for the base instruction set, so only these functions use AVX2, FMA and F16C,
+// and they are only called once the CPU has been checked. MSVC does not need the attribute to use the intrinsics.
+#if defined(__GNUC__) || defined(__clang__)
+#define FFT_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#else
+#define FFT_TARGET_AVX2
+#endif
+
+namespace
+{
+	/** \brief Multiplies four pairs of complex numbers stored as re, im, re, im...
+	*/
+	FFT_TARGET_AVX2 inline __m256 ComplexMultiply(__m256 a, __m256 w)
+	{
+		__m256 wr = _mm256_moveldup_ps(w);
+		__m256 wi = _mm256_movehdup_ps(w);
+		__m256 aSwapped = _mm256_permute_ps(a, 0xB1);
+		return _mm256_fmaddsub_ps(a, wr, _mm256_mul_ps(aSwapped, wi));
+	}
+
+	FFT_TARGET_AVX2 void MultiplyAccumulateAVX2(const float * x, const float * y, float * z, int numberOfBins)
+	{
+		for (int k = 0; k < numberOfBins; k += 4)
+			_mm256_storeu_ps(z + 2 * k, _mm256_add_ps(_mm256_loadu_ps(z + 2 * k), ComplexMultiply(_mm256_loadu_ps(x + 2 * k), _mm256_loadu_ps(y + 2 * k))));
+	}
+
+	FFT_TARGET_AVX2 void AccumulateAVX2(const float * x, float * z, int numberOfBins)
+	{
+		for (int k = 0; k < numberOfBins; k += 4)
+			_mm256_storeu_ps(z + 2 * k, _mm256_add_ps(_mm256_loadu_ps(z + 2 * k), _mm256_loadu_ps(x + 2 * k)));
+	}
+
+	FFT_TARGET_AVX2 void MultiplyAccumulateHalfAVX2(const float * x, const uint16_t * y, float * z, int numberOfBins)
+	{
+		for (int k = 0; k < numberOfBins; k += 4)
+		{
+			__m256 w = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + 2 * k)));
+			_mm256_storeu_ps(z + 2 * k, _mm256_add_ps(_mm256_loadu_ps(z + 2 * k), ComplexMultiply(_mm256_loadu_ps(x + 2 * k), w)));
+		}
+	}
+
+	FFT_TARGET_AVX2 void MultiplyAccumulateInt16AVX2(const float * x, const int16_t * y, float scale, float * z, int numberOfBins)
+	{
+		__m256 scales = _mm256_set1_ps(scale);
+		for (int k = 0; k < numberOfBins; k += 4)
+		{
+			__m256i widened = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + 2 * k)));
+			__m256 w = _mm256_mul_ps(_mm256_cvtepi32_ps(widened), scales);
+			_mm256_storeu_ps(z + 2 * k, _mm256_add_ps(_mm256_loadu_ps(z + 2 * k), ComplexMultiply(_mm256_loadu_ps(x + 2 * k), w)));
+		}
+	}
+
+	FFT_TARGET_AVX2 void Radix4StageAVX2(float * d, int size, int quarter, const float * w1, const float * w2, const float * w3, bool inverse)
+	{
+		// Multiplying by -i (forward) or by i (inverse) swaps re and im and changes the sign of one of them
+		const __m256 signs = inverse ? _mm256_castsi256_ps(_mm256_set_epi32(0, (int)0x80000000, 0, (int)0x80000000, 0, (int)0x80000000, 0, (int)0x80000000))
+									 : _mm256_castsi256_ps(_mm256_set_epi32((int)0x80000000, 0, (int)0x80000000, 0, (int)0x80000000, 0, (int)0x80000000, 0));
+		for (int start = 0; start < size; start += 4 * quarter)
+		{
+			for (int k = 0; k < quarter; k += 4)
+			{
+				float * x0 = d + 2 * (start + k);
+				float * x1 = x0 + 2 * quarter;
+				float * x2 = x1 + 2 * quarter;
+				float * x3 = x2 + 2 * quarter;
+
+				__m256 a0 = _mm256_loadu_ps(x0);
+				__m256 a1 = ComplexMultiply(_mm256_loadu_ps(x1), _mm256_loadu_ps(w1 + 2 * k));
+				__m256 a2 = ComplexMultiply(_mm256_loadu_ps(x2), _mm256_loadu_ps(w2 + 2 * k));
+				__m256 a3 = ComplexMultiply(_mm256_loadu_ps(x3), _mm256_loadu_ps(w3 + 2 * k));
+
+				__m256 s02 = _mm256_add_ps(a0, a2), d02 = _mm256_sub_ps(a0, a2);
+				__m256 s13 = _mm256_add_ps(a1, a3);
+				__m256 j13 = _mm256_xor_ps(_mm256_permute_ps(_mm256_sub_ps(a1, a3), 0xB1), signs);
+
+				_mm256_storeu_ps(x0, _mm256_add_ps(s02, s13));
+				_mm256_storeu_ps(x1, _mm256_add_ps(d02, j13));
+				_mm256_storeu_ps(x2, _mm256_sub_ps(s02, s13));
+				_mm256_storeu_ps(x3, _mm256_sub_ps(d02, j13));
+			}
+		}
+	}
+
+	bool IsAVX2Supported()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool fma = (info[2] & (1 << 12)) != 0;
+		bool f16c = (info[2] & (1 << 29)) != 0;
+		if (!osxsave || !fma || !f16c) return false;
+		if ((_xgetbv(0) & 0x6) != 0x6) return false;				// The OS saves the AVX registers
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		unsigned int eax, ebx, ecx, edx;
+		bool f16c = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_F16C) != 0;
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && f16c;
+#endif
+	}
+
+	class FFTBackendAVX2 : public FFTBackendRadix4
+	{
+	public:
+		const char * GetName() const override
+		{
+			return "avx2";
+		}
+
+		void MultiplyAccumulate(const std::complex<float> * a, const std::complex<float> * b, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			int vectorBins = numberOfBins & ~3;
+			MultiplyAccumulateAVX2(reinterpret_cast<const float *>(a), reinterpret_cast<const float *>(b), reinterpret_cast<float *>(accumulator), vectorBins);
+			if (vectorBins < numberOfBins) FFTBackend::MultiplyAccumulate(a + vectorBins, b + vectorBins, accumulator + vectorBins, numberOfBins - vectorBins);
+		}
+
+		void Accumulate(const std::complex<float> * a, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			int vectorBins = numberOfBins & ~3;
+			AccumulateAVX2(reinterpret_cast<const float *>(a), reinterpret_cast<float *>(accumulator), vectorBins);
+			if (vectorBins < numberOfBins) FFTBackend::Accumulate(a + vectorBins, accumulator + vectorBins, numberOfBins - vectorBins);
+		}
+
+		void MultiplyAccumulateHalf(const std::complex<float> * a, const uint16_t * b, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			int vectorBins = numberOfBins & ~3;
+			MultiplyAccumulateHalfAVX2(reinterpret_cast<const float *>(a), b, reinterpret_cast<float *>(accumulator), vectorBins);
+			if (vectorBins < numberOfBins) FFTBackend::MultiplyAccumulateHalf(a + vectorBins, b + 2 * vectorBins, accumulator + vectorBins, numberOfBins - vectorBins);
+		}
+
+		void MultiplyAccumulateBlockInt16(const std::complex<float> * a, const int16_t * b, const float * blockScales, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			for (int blockStart = 0; blockStart < numberOfBins; blockStart += SPECTRUM_BLOCK_BINS)
+			{
+				int blockBins = std::min(SPECTRUM_BLOCK_BINS, numberOfBins - blockStart);
+				int vectorBins = blockBins & ~3;
+				const float * scale = &blockScales[blockStart / SPECTRUM_BLOCK_BINS];
+				MultiplyAccumulateInt16AVX2(reinterpret_cast<const float *>(a + blockStart), b + 2 * blockStart, *scale, reinterpret_cast<float *>(accumulator + blockStart), vectorBins);
+				if (vectorBins < blockBins)
+					FFTBackend::MultiplyAccumulateBlockInt16(a + blockStart + vectorBins, b + 2 * (blockStart + vectorBins), scale, accumulator + blockStart + vectorBins, blockBins - vectorBins);
+			}
+		}
+
+	protected:
+		void Radix4Stage(std::complex<float> * data, int size, int quarter, const std::complex<float> * w1, const std::complex<float> * w2, const std::complex<float> * w3, bool inverse) const override
+		{
+			if (quarter < 4)
+				ScalarRadix4Stage(data, size, quarter, w1, w2, w3, inverse);
+			else
+				Radix4StageAVX2(reinterpret_cast<float *>(data), size, quarter,
+					reinterpret_cast<const float *>(w1), reinterpret_cast<const float *>(w2), reinterpret_cast<const float *>(w3), inverse);
+		}
+	};
+}
+
+const FFTBackend * GetFFTBackendAVX2()
+{
+	static FFTBackendAVX2 backend;
+	static bool supported = IsAVX2Supported();
+	return supported ? &backend : nullptr;
+}
+
+#else
+
+const FFTBackend * GetFFTBackendAVX2()
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,159 @@
+/**
+*
+* \brief Implementation of the NEON FFT backend
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "FFTBackend.h"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+#include <algorithm>
+
+namespace
+{
+	/** \brief Multiplies two pairs of complex numbers stored as re, im, re, im
+	*/
+	inline float32x4_t ComplexMultiply(float32x4_t a, float32x4_t w)
+	{
+		float32x4_t wr = vtrn1q_f32(w, w);							// wr0, wr0, wr1, wr1
+		float32x4_t wi = vtrn2q_f32(w, w);							// wi0, wi0, wi1, wi1
+		float32x4_t aSwapped = vrev64q_f32(a);						// ai0, ar0, ai1, ar1
+		const float signsArray[4] = { -1.0f, 1.0f, -1.0f, 1.0f };
+		return vmlaq_f32(vmulq_f32(a, wr), vmulq_f32(aSwapped, wi), vld1q_f32(signsArray));
+	}
+
+	class FFTBackendNEON : public FFTBackendRadix4
+	{
+	public:
+		const char * GetName() const override
+		{
+			return "neon";
+		}
+
+		void MultiplyAccumulate(const std::complex<float> * a, const std::complex<float> * b, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			const float * x = reinterpret_cast<const float *>(a);
+			const float * y = reinterpret_cast<const float *>(b);
+			float * z = reinterpret_cast<float *>(accumulator);
+			int k = 0;
+			for (; k + 2 <= numberOfBins; k += 2)
+				vst1q_f32(z + 2 * k, vaddq_f32(vld1q_f32(z + 2 * k), ComplexMultiply(vld1q_f32(x + 2 * k), vld1q_f32(y + 2 * k))));
+			if (k < numberOfBins) FFTBackend::MultiplyAccumulate(a + k, b + k, accumulator + k, numberOfBins - k);
+		}
+
+		void Accumulate(const std::complex<float> * a, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			const float * x = reinterpret_cast<const float *>(a);
+			float * z = reinterpret_cast<float *>(accumulator);
+			int k = 0;
+			for (; k + 2 <= numberOfBins; k += 2)
+				vst1q_f32(z + 2 * k, vaddq_f32(vld1q_f32(z + 2 * k), vld1q_f32(x + 2 * k)));
+			if (k < numberOfBins) FFTBackend::Accumulate(a + k, accumulator + k, numberOfBins - k);
+		}
+
+		void MultiplyAccumulateHalf(const std::complex<float> * a, const uint16_t * b, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			const float * x = reinterpret_cast<const float *>(a);
+			float * z = reinterpret_cast<float *>(accumulator);
+			int k = 0;
+			for (; k + 2 <= numberOfBins; k += 2)
+			{
+				float32x4_t y = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(b + 2 * k)));
+				vst1q_f32(z + 2 * k, vaddq_f32(vld1q_f32(z + 2 * k), ComplexMultiply(vld1q_f32(x + 2 * k), y)));
+			}
+			if (k < numberOfBins) FFTBackend::MultiplyAccumulateHalf(a + k, b + 2 * k, accumulator + k, numberOfBins - k);
+		}
+
+		void MultiplyAccumulateBlockInt16(const std::complex<float> * a, const int16_t * b, const float * blockScales, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			const float * x = reinterpret_cast<const float *>(a);
+			float * z = reinterpret_cast<float *>(accumulator);
+			for (int blockStart = 0; blockStart < numberOfBins; blockStart += SPECTRUM_BLOCK_BINS)
+			{
+				int blockEnd = std::min(blockStart + SPECTRUM_BLOCK_BINS, numberOfBins);
+				float scale = blockScales[blockStart / SPECTRUM_BLOCK_BINS];
+				int k = blockStart;
+				for (; k + 2 <= blockEnd; k += 2)
+				{
+					float32x4_t y = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(b + 2 * k))), scale);
+					vst1q_f32(z + 2 * k, vaddq_f32(vld1q_f32(z + 2 * k), ComplexMultiply(vld1q_f32(x + 2 * k), y)));
+				}
+				if (k < blockEnd)
+					FFTBackend::MultiplyAccumulateBlockInt16(a + k, b + 2 * k, &blockScales[blockStart / SPECTRUM_BLOCK_BINS], accumulator + k, blockEnd - k);
+			}
+		}
+
+	protected:
+		void Radix4Stage(std::complex<float> * data, int size, int quarter, const std::complex<float> * w1, const std::complex<float> * w2, const std::complex<float> * w3, bool inverse) const override
+		{
+			if (quarter < 2)
+			{
+				ScalarRadix4Stage(data, size, quarter, w1, w2, w3, inverse);
+				return;
+			}
+
+			// Multiplying by -i (forward) or by i (inverse) swaps re and im and changes the sign of one of them
+			const float forwardSigns[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+			const float inverseSigns[4] = { -1.0f, 1.0f, -1.0f, 1.0f };
+			const float32x4_t signs = vld1q_f32(inverse ? inverseSigns : forwardSigns);
+			float * d = reinterpret_cast<float *>(data);
+			for (int start = 0; start < size; start += 4 * quarter)
+			{
+				for (int k = 0; k < quarter; k += 2)
+				{
+					float * x0 = d + 2 * (start + k);
+					float * x1 = x0 + 2 * quarter;
+					float * x2 = x1 + 2 * quarter;
+					float * x3 = x2 + 2 * quarter;
+
+					float32x4_t a0 = vld1q_f32(x0);
+					float32x4_t a1 = ComplexMultiply(vld1q_f32(x1), vld1q_f32(reinterpret_cast<const float *>(w1 + k)));
+					float32x4_t a2 = ComplexMultiply(vld1q_f32(x2), vld1q_f32(reinterpret_cast<const float *>(w2 + k)));
+					float32x4_t a3 = ComplexMultiply(vld1q_f32(x3), vld1q_f32(reinterpret_cast<const float *>(w3 + k)));
+
+					float32x4_t s02 = vaddq_f32(a0, a2), d02 = vsubq_f32(a0, a2);
+					float32x4_t s13 = vaddq_f32(a1, a3);
+					float32x4_t j13 = vmulq_f32(vrev64q_f32(vsubq_f32(a1, a3)), signs);
+
+					vst1q_f32(x0, vaddq_f32(s02, s13));
+					vst1q_f32(x1, vaddq_f32(d02, j13));
+					vst1q_f32(x2, vsubq_f32(s02, s13));
+					vst1q_f32(x3, vsubq_f32(d02, j13));
+				}
+			}
+		}
+	};
+}
+
+const FFTBackend * GetFFTBackendNEON()
+{
+	// NEON is part of every AArch64 CPU, so it is available whenever it is compiled
+	static FFTBackendNEON backend;
+	return &backend;
+}
+
+#else
+
+const FFTBackend * GetFFTBackendNEON()
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,153 @@
+/**
+*
+* \brief Implementation of the SSE2 FFT backend
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "FFTBackend.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+#include <algorithm>
+
+namespace
+{
+	/** \brief Multiplies two pairs of complex numbers stored as re, im, re, im
+	*/
+	inline __m128 ComplexMultiply(__m128 a, __m128 w)
+	{
+		const __m128 signs = _mm_castsi128_ps(_mm_set_epi32(0, (int)0x80000000, 0, (int)0x80000000));
+		__m128 wr = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0));
+		__m128 wi = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1));
+		__m128 aSwapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+		return _mm_add_ps(_mm_mul_ps(a, wr), _mm_xor_ps(_mm_mul_ps(aSwapped, wi), signs));
+	}
+
+	/** \brief Multiplies by -i (forward) or by i (inverse)
+	*/
+	inline __m128 MultiplyByI(__m128 a, __m128 signs)
+	{
+		return _mm_xor_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), signs);
+	}
+
+	class FFTBackendSSE2 : public FFTBackendRadix4
+	{
+	public:
+		const char * GetName() const override
+		{
+			return "sse2";
+		}
+
+		void MultiplyAccumulate(const std::complex<float> * a, const std::complex<float> * b, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			const float * x = reinterpret_cast<const float *>(a);
+			const float * y = reinterpret_cast<const float *>(b);
+			float * z = reinterpret_cast<float *>(accumulator);
+			int k = 0;
+			for (; k + 2 <= numberOfBins; k += 2)
+				_mm_storeu_ps(z + 2 * k, _mm_add_ps(_mm_loadu_ps(z + 2 * k), ComplexMultiply(_mm_loadu_ps(x + 2 * k), _mm_loadu_ps(y + 2 * k))));
+			if (k < numberOfBins) FFTBackend::MultiplyAccumulate(a + k, b + k, accumulator + k, numberOfBins - k);
+		}
+
+		void Accumulate(const std::complex<float> * a, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			const float * x = reinterpret_cast<const float *>(a);
+			float * z = reinterpret_cast<float *>(accumulator);
+			int k = 0;
+			for (; k + 2 <= numberOfBins; k += 2)
+				_mm_storeu_ps(z + 2 * k, _mm_add_ps(_mm_loadu_ps(z + 2 * k), _mm_loadu_ps(x + 2 * k)));
+			if (k < numberOfBins) FFTBackend::Accumulate(a + k, accumulator + k, numberOfBins - k);
+		}
+
+		void MultiplyAccumulateBlockInt16(const std::complex<float> * a, const int16_t * b, const float * blockScales, std::complex<float> * accumulator, int numberOfBins) const override
+		{
+			const float * x = reinterpret_cast<const float *>(a);
+			float * z = reinterpret_cast<float *>(accumulator);
+			for (int blockStart = 0; blockStart < numberOfBins; blockStart += SPECTRUM_BLOCK_BINS)
+			{
+				int blockEnd = std::min(blockStart + SPECTRUM_BLOCK_BINS, numberOfBins);
+				__m128 scale = _mm_set1_ps(blockScales[blockStart / SPECTRUM_BLOCK_BINS]);
+				int k = blockStart;
+				for (; k + 2 <= blockEnd; k += 2)
+				{
+					// Sign extension of four int16 into int32, by placing them in the high half and shifting them back
+					__m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(b + 2 * k));
+					__m128 y = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16)), scale);
+					_mm_storeu_ps(z + 2 * k, _mm_add_ps(_mm_loadu_ps(z + 2 * k), ComplexMultiply(_mm_loadu_ps(x + 2 * k), y)));
+				}
+				if (k < blockEnd)
+					FFTBackend::MultiplyAccumulateBlockInt16(a + k, b + 2 * k, &blockScales[blockStart / SPECTRUM_BLOCK_BINS], accumulator + k, blockEnd - k);
+			}
+		}
+
+	protected:
+		void Radix4Stage(std::complex<float> * data, int size, int quarter, const std::complex<float> * w1, const std::complex<float> * w2, const std::complex<float> * w3, bool inverse) const override
+		{
+			if (quarter < 2)
+			{
+				ScalarRadix4Stage(data, size, quarter, w1, w2, w3, inverse);
+				return;
+			}
+
+			const __m128 signs = inverse ? _mm_castsi128_ps(_mm_set_epi32(0, (int)0x80000000, 0, (int)0x80000000))
+										 : _mm_castsi128_ps(_mm_set_epi32((int)0x80000000, 0, (int)0x80000000, 0));
+			float * d = reinterpret_cast<float *>(data);
+			for (int start = 0; start < size; start += 4 * quarter)
+			{
+				for (int k = 0; k < quarter; k += 2)
+				{
+					float * x0 = d + 2 * (start + k);
+					float * x1 = x0 + 2 * quarter;
+					float * x2 = x1 + 2 * quarter;
+					float * x3 = x2 + 2 * quarter;
+
+					__m128 a0 = _mm_loadu_ps(x0);
+					__m128 a1 = ComplexMultiply(_mm_loadu_ps(x1), _mm_loadu_ps(reinterpret_cast<const float *>(w1 + k)));
+					__m128 a2 = ComplexMultiply(_mm_loadu_ps(x2), _mm_loadu_ps(reinterpret_cast<const float *>(w2 + k)));
+					__m128 a3 = ComplexMultiply(_mm_loadu_ps(x3), _mm_loadu_ps(reinterpret_cast<const float *>(w3 + k)));
+
+					__m128 s02 = _mm_add_ps(a0, a2), d02 = _mm_sub_ps(a0, a2);
+					__m128 s13 = _mm_add_ps(a1, a3);
+					__m128 j13 = MultiplyByI(_mm_sub_ps(a1, a3), signs);
+
+					_mm_storeu_ps(x0, _mm_add_ps(s02, s13));
+					_mm_storeu_ps(x1, _mm_add_ps(d02, j13));
+					_mm_storeu_ps(x2, _mm_sub_ps(s02, s13));
+					_mm_storeu_ps(x3, _mm_sub_ps(d02, j13));
+				}
+			}
+		}
+	};
+}
+
+const FFTBackend * GetFFTBackendSSE2()
+{
+	// SSE2 is part of every x86-64 CPU, so it is available whenever it is compiled
+	static FFTBackendSSE2 backend;
+	return &backend;
+}
+
+#else
+
+const FFTBackend * GetFFTBackendSSE2()
+{
+	return nullptr;
+}
+
+#endif
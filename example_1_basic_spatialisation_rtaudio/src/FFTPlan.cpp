@@ -0,0 +1,112 @@
+/**
+*
+* \brief Implementation of FFTPlan, the tables of an FFT size, which are computed once and shared by all the transforms of that size
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "FFTPlan.h"
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace
+{
+	const double PI = 3.14159265358979323846;
+
+	std::complex<float> Twiddle(double numerator, double denominator)
+	{
+		return std::complex<float>((float)std::cos(2.0 * PI * numerator / denominator), (float)-std::sin(2.0 * PI * numerator / denominator));
+	}
+
+	/** \brief Input order of an in-place decimation in time transform whose stages have the given radices, first stage first
+	*/
+	std::vector<int> DigitReversal(int size, const std::vector<int> & radices, size_t numberOfStages)
+	{
+		if (numberOfStages == 0) return std::vector<int>(1, 0);
+
+		// The last stage combines radix transforms, the j-th of them over the samples radix * n + j
+		int radix = radices[numberOfStages - 1];
+		int subSize = size / radix;
+		std::vector<int> subPermutation = DigitReversal(subSize, radices, numberOfStages - 1);
+		std::vector<int> permutation(size);
+		for (int j = 0; j < radix; j++)
+			for (int i = 0; i < subSize; i++)
+				permutation[j * subSize + i] = radix * subPermutation[i] + j;
+		return permutation;
+	}
+}
+
+std::shared_ptr<const FFTPlan> FFTPlan::Get(int size)
+{
+	static std::mutex cacheMutex;
+	static std::map<int, std::shared_ptr<const FFTPlan>> cache;		// Plans are kept for the whole run, there are only a few sizes
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	auto found = cache.find(size);
+	if (found != cache.end()) return found->second;
+
+	std::shared_ptr<const FFTPlan> plan(new FFTPlan(size));
+	cache[size] = plan;
+	return plan;
+}
+
+FFTPlan::FFTPlan(int size)
+	: size{ size }
+{
+	int bits = 0;
+	while ((1 << bits) < size) bits++;
+
+	// Radix-2 tables
+	bitReversal.resize(size);
+	for (int i = 0; i < size; i++)
+	{
+		int reversed = 0;
+		for (int b = 0; b < bits; b++)
+			if (i & (1 << b)) reversed |= 1 << (bits - 1 - b);
+		bitReversal[i] = reversed;
+	}
+	radix2Twiddles.resize(size / 2);
+	for (int k = 0; k < size / 2; k++)
+		radix2Twiddles[k] = Twiddle(k, size);
+
+	// Radix-4 tables. An odd number of bits needs one radix-2 stage, done first as it has no twiddles.
+	radix2FirstStage = (bits % 2) == 1;
+	std::vector<int> radices;
+	if (radix2FirstStage) radices.push_back(2);
+	for (int b = radix2FirstStage ? 1 : 0; b < bits; b += 2) radices.push_back(4);
+	radix4Permutation = DigitReversal(size, radices, radices.size());
+
+	for (int quarter = radix2FirstStage ? 2 : 1; quarter * 4 <= size; quarter *= 4)
+	{
+		TRadix4Stage stage;
+		stage.quarter = quarter;
+		stage.twiddleOffset = radix4Twiddles.size();
+		for (int m = 1; m <= 3; m++)
+			for (int k = 0; k < quarter; k++)
+			{
+				radix4Twiddles.push_back(Twiddle((double)m * k, 4.0 * quarter));
+				radix4InverseTwiddles.push_back(std::conj(Twiddle((double)m * k, 4.0 * quarter)));
+			}
+		radix4Stages.push_back(stage);
+	}
+
+	// Twiddles to split the transform of a real signal of twice the size
+	realTwiddles.resize(size + 1);
+	for (int k = 0; k <= size; k++)
+		realTwiddles[k] = Twiddle(k, 2.0 * size);
+}
@@ -0,0 +1,60 @@
+/**
+*
+* \brief Declaration of FFTPlan, the tables of an FFT size, which are computed once and shared by all the transforms of that size
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _FFTPLAN_H_
+#define _FFTPLAN_H_
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+struct FFTPlan
+{
+	/** \brief Twiddles of one radix-4 stage, which combines groups of four transforms of quarter samples
+	*/
+	struct TRadix4Stage
+	{
+		int quarter;
+		size_t twiddleOffset;										// Position of w^k, w^2k and w^3k (quarter values each) in radix4Twiddles
+	};
+
+	/** \brief Returns the plan of a complex transform size, computing it the first time that size is requested. Thread safe.
+	*	\param [in] size number of complex samples of the transform. Must be a power of two, 2 or greater.
+	*/
+	static std::shared_ptr<const FFTPlan> Get(int size);
+
+	int size;														// Number of complex samples
+	std::vector<int> bitReversal;									// Input permutation of the radix-2 transform
+	std::vector<std::complex<float>> radix2Twiddles;				// exp(-2 pi i k / size), k < size / 2
+
+	bool radix2FirstStage;											// True if size is not a power of four: a radix-2 stage goes before the radix-4 ones
+	std::vector<int> radix4Permutation;								// Input permutation of the mixed radix-2 and radix-4 transform
+	std::vector<TRadix4Stage> radix4Stages;
+	std::vector<std::complex<float>> radix4Twiddles;				// Forward twiddles of all the radix-4 stages
+	std::vector<std::complex<float>> radix4InverseTwiddles;			// Conjugated twiddles, so that SIMD code does not conjugate them
+
+	std::vector<std::complex<float>> realTwiddles;					// exp(-2 pi i k / (2 size)), k <= size, to split a real transform of 2 size samples
+
+private:
+	FFTPlan(int size);
+};
+
+#endif
@@ -0,0 +1,70 @@
+/**
+*
+* \brief Implementation of FixedQuantumAdapter, which renders audio in a fixed processing quantum for devices with any buffer size
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+
+#include "FixedQuantumAdapter.h"
+#include <algorithm>
+
+FixedQuantumAdapter::FixedQuantumAdapter(int quantum, TProcessQuantum processQuantum)
+	: quantum{ quantum }, processQuantum{ processQuantum }, readPosition{ quantum }, numberOfQuanta{ 0 }
+{
+	quantumOutput.left.resize(quantum);
+	quantumOutput.right.resize(quantum);
+}
+
+void FixedQuantumAdapter::Process(float * interlacedOutput, unsigned int numberOfFrames)
+{
+	while (numberOfFrames > 0)
+	{
+		if (readPosition == quantum)
+		{
+			processQuantum(quantumOutput);
+			readPosition = 0;
+			numberOfQuanta++;
+		}
+
+		int frames = std::min((int)numberOfFrames, quantum - readPosition);
+		const float * left = quantumOutput.left.data() + readPosition;
+		const float * right = quantumOutput.right.data() + readPosition;
+		for (int n = 0; n < frames; n++)
+		{
+			*interlacedOutput++ = left[n];
+			*interlacedOutput++ = right[n];
+		}
+		readPosition += frames;
+		numberOfFrames -= frames;
+	}
+}
+
+int FixedQuantumAdapter::GetQuantum() const
+{
+	return quantum;
+}
+
+int FixedQuantumAdapter::GetBufferedFrames() const
+{
+	return quantum - readPosition;
+}
+
+unsigned long FixedQuantumAdapter::GetNumberOfQuanta() const
+{
+	return numberOfQuanta;
+}
@@ -0,0 +1,75 @@
+/**
+*
+* \brief Declaration of FixedQuantumAdapter, which renders audio in a fixed processing quantum for devices with any buffer size
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+
+#ifndef _FIXEDQUANTUMADAPTER_H_
+#define _FIXEDQUANTUMADAPTER_H_
+
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+#include <functional>
+
+/** \details The core, the reverb and their HRTF and BRIR partitions are set up for one buffer size, which is therefore the processing
+*			 quantum of the example. This adapter sits between the audio device and the processing: each time the device asks for a
+*			 buffer, of any size, it renders as many quanta as needed and keeps the samples left over for the next buffer. The device
+*			 buffer size can then be anything the device supports, including sizes that are not powers of two or that change between
+*			 callbacks, without setting up the core again.
+*			 Up to quantum - 1 rendered frames wait in the adapter, which adds that much latency in the worst case. The quanta are rendered
+*			 in the callback, so the quantum must not be larger than the device buffer: otherwise some callbacks render several quanta
+*			 while others render none, and the longest ones miss their deadline. With a larger device buffer, each callback renders
+*			 device buffer / quantum quanta rounded down or up.
+*/
+class FixedQuantumAdapter
+{
+public:
+	/** \brief Function rendering one quantum. It receives the stereo buffer to write and must leave quantum samples in each ear.
+	*/
+	typedef std::function<void(Common::CEarPair<CMonoBuffer<float>> &)> TProcessQuantum;
+
+	/** \param [in] quantum number of samples rendered by each call to processQuantum. Not larger than the device buffer.
+	*	\param [in] processQuantum function rendering one quantum, called from the thread calling Process
+	*/
+	FixedQuantumAdapter(int quantum, TProcessQuantum processQuantum);
+
+	/** \brief Fills a device buffer, rendering new quanta when the samples left over are not enough. To be called from the audio thread.
+	*	\param [out] interlacedOutput numberOfFrames stereo frames, left and right interlaced
+	*	\param [in] numberOfFrames frames of the device buffer, any number
+	*/
+	void Process(float * interlacedOutput, unsigned int numberOfFrames);
+
+	int GetQuantum() const;
+
+	/** \brief Returns the number of rendered frames not sent to the device yet
+	*/
+	int GetBufferedFrames() const;
+
+	/** \brief Returns the number of quanta rendered since the adapter was created
+	*/
+	unsigned long GetNumberOfQuanta() const;
+
+private:
+	int quantum;
+	TProcessQuantum processQuantum;
+	Common::CEarPair<CMonoBuffer<float>> quantumOutput;			// Last quantum rendered
+	int readPosition;												// First frame of quantumOutput not sent to the device yet
+	unsigned long numberOfQuanta;
+};
+
+#endif
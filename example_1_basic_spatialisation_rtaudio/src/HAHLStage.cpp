@@ -0,0 +1,204 @@
+/**
+*
+* \brief Implementation of HAHLStage, the hearing loss and hearing aid simulators of the toolkit applied to the binaural mix
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+
+#include "HAHLStage.h"
+#include <algorithm>
+#include <memory>
+
+HAHLStage::HAHLStage(int sampleRate, int blockSize)
+	: sampleRate{ sampleRate }, blockSize{ blockSize }, vectorized{ sampleRate }, implementation{ TOOLKIT }, hearingAidEnabled{ false }, blockPending{ false }, lastBlockToWorker{ false }, stopping{ false }, lateBlocks{ 0 }
+{
+	// Hearing loss, with one Butterworth multiband expander per ear
+	hearingLoss.Setup(sampleRate, HAHL_CALIBRATION_DBSPL, HAHL_NUMBER_OF_BANDS, blockSize);
+	for (Common::T_ear ear : { Common::T_ear::LEFT, Common::T_ear::RIGHT })
+	{
+		std::shared_ptr<HAHLSimulation::CButterworthMultibandExpander> expander = std::make_shared<HAHLSimulation::CButterworthMultibandExpander>();
+		expander->Setup(sampleRate, HAHL_FIRST_BAND_HZ, HAHL_NUMBER_OF_BANDS, true);
+		hearingLoss.SetMultibandExpander(ear, expander);
+	}
+	hearingLoss.EnableHearingLossSimulation(Common::T_ear::BOTH);
+
+	// Hearing aid, in the same bands as the audiogram
+	hearingAid.Setup(sampleRate, HAHL_AID_LEVELS, HAHL_FIRST_BAND_HZ, HAHL_NUMBER_OF_BANDS, 1, HAHL_AID_LPF_HZ, HAHL_AID_HPF_HZ, HAHL_AID_Q_LPF, HAHL_AID_Q_BPF, HAHL_AID_Q_HPF);
+	hearingAid.DisableHearingAidSimulation(Common::T_ear::BOTH);
+
+	aidOutput.left.assign(blockSize, 0.0f);
+	aidOutput.right.assign(blockSize, 0.0f);
+	lossOutput.left.assign(blockSize, 0.0f);
+	lossOutput.right.assign(blockSize, 0.0f);
+	SetHearingLoss(Common::T_ear::BOTH, std::vector<float>());
+}
+
+HAHLStage::~HAHLStage()
+{
+	{
+		std::lock_guard<std::mutex> lock(workerMutex);
+		stopping = true;
+	}
+	workerWakeUp.notify_all();
+	if (workerThread.joinable()) workerThread.join();
+}
+
+void HAHLStage::SetHearingLoss(Common::T_ear ear, const std::vector<float> & hearingLevels)
+{
+	for (int e = 0; e < 2; e++)
+	{
+		if ((e == 0 && ear == Common::T_ear::RIGHT) || (e == 1 && ear == Common::T_ear::LEFT)) continue;
+		audiograms[e].resize(HAHL_NUMBER_OF_BANDS);
+		for (int k = 0; k < HAHL_NUMBER_OF_BANDS; k++)
+		{
+			float loss = hearingLevels.empty() ? 0.0f : hearingLevels[std::min((size_t)k, hearingLevels.size() - 1)];
+			audiograms[e][k] = std::max(loss, 0.0f);
+		}
+
+		Common::T_ear earIndex = e == 0 ? Common::T_ear::LEFT : Common::T_ear::RIGHT;
+		hearingLoss.SetFromAudiometry_dBHL(earIndex, audiograms[e]);
+		hearingAid.SetDynamicEqualizerUsingFig6(earIndex, audiograms[e], HAHL_CALIBRATION_DBSPL);
+		vectorized.SetHearingLoss(earIndex, std::vector<float>(audiograms[e].begin() + 1, audiograms[e].end()));	// From 125 Hz
+	}
+}
+
+void HAHLStage::SetHearingAid(bool enabled)
+{
+	hearingAidEnabled = enabled;
+	if (enabled) hearingAid.EnableHearingAidSimulation(Common::T_ear::BOTH);
+	else hearingAid.DisableHearingAidSimulation(Common::T_ear::BOTH);
+	vectorized.SetHearingAid(enabled);
+}
+
+void HAHLStage::SetImplementation(TImplementation _implementation)
+{
+	implementation = _implementation;
+	vectorized.SetVectorized(implementation == VECTORIZED);
+}
+
+void HAHLStage::StartWorker()
+{
+	if (workerThread.joinable()) return;
+	workerBuffer.left.assign(blockSize, 0.0f);
+	workerBuffer.right.assign(blockSize, 0.0f);
+	passThrough.left.assign(blockSize, 0.0f);
+	passThrough.right.assign(blockSize, 0.0f);
+	nextPassThrough.left.assign(blockSize, 0.0f);
+	nextPassThrough.right.assign(blockSize, 0.0f);
+	blockPending = false;
+	lastBlockToWorker = false;
+	workerThread = std::thread(&HAHLStage::Worker, this);
+}
+
+void HAHLStage::Process(Common::CEarPair<CMonoBuffer<float>> & buffer)
+{
+	if (!workerThread.joinable())
+	{
+		ProcessBlock(buffer);
+		return;
+	}
+
+	// The block is kept unprocessed, in case the worker cannot take it or is late with it
+	std::copy(buffer.left.begin(), buffer.left.begin() + blockSize, nextPassThrough.left.begin());
+	std::copy(buffer.right.begin(), buffer.right.begin() + blockSize, nextPassThrough.right.begin());
+
+	// The worker has had a whole block to process the previous one, so it is normally done. If it is not, it is not waited for:
+	// the previous block is output unprocessed, and this one is not handed to the worker.
+	std::unique_lock<std::mutex> lock(workerMutex);
+	bool late = blockPending;
+	if (late) lateBlocks++;
+	else if (lastBlockToWorker)
+	{
+		buffer.left.swap(workerBuffer.left);
+		buffer.right.swap(workerBuffer.right);
+	}
+	else
+	{
+		std::copy(nextPassThrough.left.begin(), nextPassThrough.left.end(), workerBuffer.left.begin());
+		std::copy(nextPassThrough.right.begin(), nextPassThrough.right.end(), workerBuffer.right.begin());
+	}
+	if (!late) blockPending = true;
+	lock.unlock();
+	if (!late) workerWakeUp.notify_one();
+
+	if (late || !lastBlockToWorker)
+	{
+		std::copy(passThrough.left.begin(), passThrough.left.end(), buffer.left.begin());
+		std::copy(passThrough.right.begin(), passThrough.right.end(), buffer.right.begin());
+	}
+	passThrough.left.swap(nextPassThrough.left);
+	passThrough.right.swap(nextPassThrough.right);
+	lastBlockToWorker = !late;
+}
+
+void HAHLStage::Worker()
+{
+	std::unique_lock<std::mutex> lock(workerMutex);
+	while (true)
+	{
+		workerWakeUp.wait(lock, [this]() { return blockPending || stopping; });
+		if (stopping) return;
+
+		lock.unlock();
+		ProcessBlock(workerBuffer);
+		lock.lock();
+
+		blockPending = false;
+	}
+}
+
+unsigned int HAHLStage::GetNumberOfLateBlocks()
+{
+	std::lock_guard<std::mutex> lock(workerMutex);
+	return lateBlocks;
+}
+
+HAHLStage::TImplementation HAHLStage::GetImplementation() const
+{
+	return implementation;
+}
+
+bool HAHLStage::IsWorkerRunning() const
+{
+	return workerThread.joinable();
+}
+
+int HAHLStage::GetBlockSize() const
+{
+	return blockSize;
+}
+
+void HAHLStage::ProcessBlock(Common::CEarPair<CMonoBuffer<float>> & buffer)
+{
+	if (implementation != TOOLKIT)
+	{
+		vectorized.Process(buffer);
+		return;
+	}
+
+	// The simulators of the toolkit write into a separate output, which is swapped with the block
+	if (hearingAidEnabled)
+	{
+		hearingAid.Process(buffer, aidOutput);
+		hearingLoss.Process(aidOutput, lossOutput);
+	}
+	else
+		hearingLoss.Process(buffer, lossOutput);
+	buffer.left.swap(lossOutput.left);
+	buffer.right.swap(lossOutput.right);
+}
@@ -0,0 +1,132 @@
+/**
+*
+* \brief Declaration of HAHLStage, the hearing loss and hearing aid simulators of the toolkit applied to the binaural mix
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+
+#ifndef _HAHLSTAGE_H_
+#define _HAHLSTAGE_H_
+
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+#include <HAHLSimulation/HearingAidSim.h>
+#include <HAHLSimulation/HearingLossSim.h>
+#include "VectorizedHAHL.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define HAHL_NUMBER_OF_BANDS	9				// Octave bands of the audiogram, centred from 62.5 Hz to 16 kHz, as in the toolkit
+#define HAHL_FIRST_BAND_HZ		62.5f			// Centre of the first band
+#define HAHL_CALIBRATION_DBSPL	100.0f			// Level of a full scale sine, in dB SPL, as the default calibration of the toolkit
+#define HAHL_AID_LEVELS			3				// Levels of the dynamic equalizer of the hearing aid
+#define HAHL_AID_LPF_HZ			12000.0f		// Cutoff frequencies of the filters that limit the band of the hearing aid
+#define HAHL_AID_HPF_HZ			80.0f
+#define HAHL_AID_Q_LPF			0.707f			// Quality factors of the filters of the hearing aid
+#define HAHL_AID_Q_BPF			1.4142f
+#define HAHL_AID_Q_HPF			0.707f
+#define HAHL_EXAMPLE_AUDIOGRAM	{ 10.0f, 10.0f, 10.0f, 15.0f, 25.0f, 40.0f, 55.0f, 65.0f, 70.0f }	// Sloping high frequency loss used by the example and the benchmark, in dB HL
+
+/** \details Hearing loss and hearing aid simulation of the binaural mix, as heard by the listener, with the simulators of the toolkit.
+*			 CHearingLossSim splits each ear into the octave bands of the audiogram with Butterworth filters and runs a downward expander
+*			 in each band. With the hearing aid, CHearingAidSim is applied first, with a dynamic equalizer fitted to the audiogram by
+*			 the Fig6 method. The output buffers are allocated once, so a block is processed without allocations.
+*			 The simulators of the toolkit compute their filterbanks and compressors band by band. VECTORIZED runs VectorizedHAHL
+*			 instead, a simplified model whose bands are computed together with SSE2, for when the cost per listener matters more than
+*			 matching the toolkit.
+*			 The stage can run on a worker thread, which takes it off the audio thread at the cost of one block of latency. The audio
+*			 thread never waits for the worker: a block the worker has not finished in time is output unprocessed instead.
+*/
+class HAHLStage
+{
+public:
+	enum TImplementation { TOOLKIT, VECTORIZED, VECTORIZED_SCALAR };		// VECTORIZED_SCALAR is the scalar reference of VECTORIZED
+
+	/** \param [in] sampleRate sample rate, in Hz
+	*	\param [in] blockSize number of samples of each call to Process
+	*/
+	HAHLStage(int sampleRate, int blockSize);
+
+	/** \brief Stops the worker thread, if it was started
+	*/
+	~HAHLStage();
+
+	/** \brief Sets the audiogram of one or both ears, and fits the hearing aid to it. Not to be called while Process is running.
+	*	\param [in] ear LEFT, RIGHT or BOTH
+	*	\param [in] hearingLevels hearing loss of each band, in dB HL, from 62.5 Hz to 16 kHz. Missing bands take the last value.
+	*/
+	void SetHearingLoss(Common::T_ear ear, const std::vector<float> & hearingLevels);
+
+	/** \brief Enables or disables the hearing aid, fitted to the audiogram of each ear. Not to be called while Process is running.
+	*/
+	void SetHearingAid(bool enabled);
+
+	/** \brief Chooses the simulators of the toolkit (the default) or VectorizedHAHL. Not to be called while Process is running.
+	*	\details VectorizedHAHL has no band below 125 Hz, so it ignores the first band of the audiogram.
+	*/
+	void SetImplementation(TImplementation implementation);
+
+	/** \brief Starts a thread that processes the blocks passed to Process. Not to be called while Process is running.
+	*	\details From then on, each call to Process returns the block of the previous call, so the output is one block late.
+	*			 If the worker is still processing that block, it is returned unprocessed, and the block of this call, which the
+	*			 worker cannot take, is returned unprocessed by the next call too.
+	*/
+	void StartWorker();
+
+	/** \brief Applies the simulation to one block of the binaural mix, in place. To be called from the audio thread.
+	*	\param [in,out] buffer blockSize samples of each ear
+	*/
+	void Process(Common::CEarPair<CMonoBuffer<float>> & buffer);
+
+	/** \brief Returns the number of times the worker thread had not finished a block in time, which was then output unprocessed
+	*/
+	unsigned int GetNumberOfLateBlocks();
+
+	TImplementation GetImplementation() const;
+	bool IsWorkerRunning() const;
+	int GetBlockSize() const;
+
+private:
+	void ProcessBlock(Common::CEarPair<CMonoBuffer<float>> & buffer);
+	void Worker();
+
+	int sampleRate;
+	int blockSize;
+	HAHLSimulation::CHearingLossSim hearingLoss;
+	HAHLSimulation::CHearingAidSim hearingAid;
+	VectorizedHAHL vectorized;
+	TImplementation implementation;
+	std::vector<float> audiograms[2];						// Hearing loss of each band of the left and right ears, in dB HL
+	bool hearingAidEnabled;
+	Common::CEarPair<CMonoBuffer<float>> aidOutput;			// Output of the hearing aid, input of the hearing loss
+	Common::CEarPair<CMonoBuffer<float>> lossOutput;
+
+	std::thread workerThread;
+	std::mutex workerMutex;
+	std::condition_variable workerWakeUp;					// Signalled when a block has been exchanged
+	Common::CEarPair<CMonoBuffer<float>> workerBuffer;		// Block being processed by the worker, or processed and waiting for the next exchange
+	Common::CEarPair<CMonoBuffer<float>> passThrough;		// Copy of the block of the previous call, output if the worker did not process it in time
+	Common::CEarPair<CMonoBuffer<float>> nextPassThrough;	// Copy of the block of the current call
+	bool blockPending;										// A block has been exchanged and is not processed yet
+	bool lastBlockToWorker;									// Whether the block of the previous call was handed to the worker
+	bool stopping;
+	unsigned int lateBlocks;
+};
+
+#endif
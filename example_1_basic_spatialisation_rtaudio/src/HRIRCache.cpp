@@ -0,0 +1,285 @@
+/**
+*
+* \brief Implementation of HRIRCache, a least recently used cache of interpolated HRIR partitions keyed by quantized direction
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+
+#include "HRIRCache.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const double PI = 3.14159265358979323846;
+
+	/** \brief Unit vector of a direction given in degrees, with elevations from -90 to 90
+	*/
+	void DirectionVector(double azimuth, double elevation, double vector[3])
+	{
+		double a = azimuth * PI / 180.0, e = elevation * PI / 180.0;
+		vector[0] = std::cos(a) * std::cos(e);
+		vector[1] = std::sin(a) * std::cos(e);
+		vector[2] = std::sin(e);
+	}
+}
+
+HRIRCache::HRIRCache(int blockSize, float quantizationStep, int capacity, SpectrumStorage::TPrecision precision)
+	: blockSize{ blockSize }, quantizationStep{ quantizationStep }, numberOfAzimuths{ std::max((int)std::lrint(360.0f / quantizationStep), 1) },
+	  numberOfElevations{ (int)std::lrint(180.0f / quantizationStep) + 1 }, capacity{ std::max(capacity, 1) }, numberOfPartitions{ 0 },
+	  numberOfBins{ 0 }, precision{ precision }, numberOfUsedSlots{ 0 }, mostRecentlyUsed{ -1 }, leastRecentlyUsed{ -1 },
+	  hits{ 0 }, misses{ 0 }, ready{ false }
+{
+}
+
+bool HRIRCache::Setup(Binaural::CHRTF & hrtf)
+{
+	const T_HRTFTable & table = hrtf.GetRawHRTFTable();
+	if (table.empty()) return false;
+
+	// Directions of the table, with the elevations of the toolkit (0 to 90 and 270 to 360) moved to -90 to 90
+	measurements.clear();
+	measurementDirections.clear();
+	size_t length = 0;
+	for (auto it = table.begin(); it != table.end(); it++)
+	{
+		double elevation = it->first.elevation > 180 ? it->first.elevation - 360.0 : it->first.elevation;
+		double vector[3];
+		DirectionVector(it->first.azimuth, elevation, vector);
+		measurementDirections.insert(measurementDirections.end(), vector, vector + 3);
+		measurements.push_back(&it->second);
+		length = std::max(length, std::max((size_t)it->second.leftDelay + it->second.leftHRIR.size(), (size_t)it->second.rightDelay + it->second.rightHRIR.size()));
+	}
+
+	fft.reset(new FFT(2 * blockSize));
+	numberOfBins = fft->GetNumberOfBins();
+	numberOfPartitions = (int)((length + blockSize - 1) / blockSize);
+
+	slots.resize(capacity);
+	for (int s = 0; s < capacity; s++)
+	{
+		slots[s].key = -1;
+		slots[s].entry.spectra[0].Setup(precision, numberOfPartitions, numberOfBins);
+		slots[s].entry.spectra[1].Setup(precision, numberOfPartitions, numberOfBins);
+	}
+	uncachedEntry.spectra[0].Setup(precision, numberOfPartitions, numberOfBins);
+	uncachedEntry.spectra[1].Setup(precision, numberOfPartitions, numberOfBins);
+
+	size_t numberOfBuckets = 1;
+	while (numberOfBuckets < 2 * (size_t)capacity) numberOfBuckets *= 2;
+	buckets.assign(numberOfBuckets, -1);
+	numberOfUsedSlots = 0;
+	mostRecentlyUsed = leastRecentlyUsed = -1;
+
+	impulseResponse.resize((size_t)numberOfPartitions * blockSize);
+	paddedPartition.resize(2 * blockSize);
+	spectrum.resize(numberOfBins);
+	ResetStatistics();
+	ready = true;
+	return true;
+}
+
+const HRIRCache::TEntry & HRIRCache::Get(const Common::CTransform & sourceTransform, const Common::CTransform & listenerTransform)
+{
+	Common::CVector3 direction = listenerTransform.GetVectorTo(sourceTransform);		// In the coordinates of the listener
+	if (direction.GetDistance() == 0.0f) return Get(0.0f, 0.0f);
+	return Get(direction.GetAzimuthDegrees(), direction.GetElevationDegrees());
+}
+
+const HRIRCache::TEntry & HRIRCache::Get(float azimuth, float elevation)
+{
+	return Get(GetKey(azimuth, elevation));
+}
+
+const HRIRCache::TEntry & HRIRCache::Get(int key)
+{
+	if (!ready) return uncachedEntry;
+
+	int & bucket = buckets[key & (buckets.size() - 1)];
+	for (int s = bucket; s != -1; s = slots[s].nextInBucket)
+	{
+		if (slots[s].key == key)
+		{
+			hits++;
+			if (s != mostRecentlyUsed)
+			{
+				Unlink(s);
+				PushFront(s);
+			}
+			return slots[s].entry;
+		}
+	}
+
+	// Miss: takes a free slot or the least recently used one, removing it from its bucket
+	misses++;
+	int slot;
+	if (numberOfUsedSlots < capacity) slot = numberOfUsedSlots++;
+	else
+	{
+		slot = leastRecentlyUsed;
+		Unlink(slot);
+		int * link = &buckets[slots[slot].key & (buckets.size() - 1)];
+		while (*link != slot) link = &slots[*link].nextInBucket;
+		*link = slots[slot].nextInBucket;
+	}
+	slots[slot].key = key;
+	slots[slot].nextInBucket = bucket;
+	bucket = slot;
+	PushFront(slot);
+
+	Compute((key % numberOfAzimuths) * quantizationStep, std::min(-90.0f + (key / numberOfAzimuths) * quantizationStep, 90.0f), slots[slot].entry);
+	return slots[slot].entry;
+}
+
+const HRIRCache::TEntry & HRIRCache::Interpolate(float azimuth, float elevation)
+{
+	if (!ready) return uncachedEntry;
+	if (elevation > 180.0f) elevation -= 360.0f;
+	Compute(azimuth, elevation, uncachedEntry);
+	return uncachedEntry;
+}
+
+int HRIRCache::GetKey(float azimuth, float elevation) const
+{
+	if (elevation > 180.0f) elevation -= 360.0f;
+	int azimuthIndex = (int)std::floor(azimuth / quantizationStep + 0.5f) % numberOfAzimuths;
+	if (azimuthIndex < 0) azimuthIndex += numberOfAzimuths;
+	int elevationIndex = std::min(std::max((int)std::floor((elevation + 90.0f) / quantizationStep + 0.5f), 0), numberOfElevations - 1);
+	return elevationIndex * numberOfAzimuths + azimuthIndex;
+}
+
+void HRIRCache::Unlink(int slot)
+{
+	TSlot & s = slots[slot];
+	if (s.previousUsed != -1) slots[s.previousUsed].nextUsed = s.nextUsed;
+	else mostRecentlyUsed = s.nextUsed;
+	if (s.nextUsed != -1) slots[s.nextUsed].previousUsed = s.previousUsed;
+	else leastRecentlyUsed = s.previousUsed;
+}
+
+void HRIRCache::PushFront(int slot)
+{
+	slots[slot].previousUsed = -1;
+	slots[slot].nextUsed = mostRecentlyUsed;
+	if (mostRecentlyUsed != -1) slots[mostRecentlyUsed].previousUsed = slot;
+	else leastRecentlyUsed = slot;
+	mostRecentlyUsed = slot;
+}
+
+void HRIRCache::Compute(float azimuth, float elevation, TEntry & entry)
+{
+	entry.azimuth = azimuth;
+	entry.elevation = elevation;
+
+	// The three measurements closest to the direction, sorted by distance
+	double target[3];
+	DirectionVector(azimuth, elevation, target);
+	int closest[3] = { -1, -1, -1 };
+	double closestDot[3] = { -2.0, -2.0, -2.0 };
+	for (size_t i = 0; i < measurements.size(); i++)
+	{
+		const double * direction = &measurementDirections[3 * i];
+		double dot = target[0] * direction[0] + target[1] * direction[1] + target[2] * direction[2];
+		for (int j = 0; j < 3; j++)
+		{
+			if (dot > closestDot[j])
+			{
+				for (int k = 2; k > j; k--)
+				{
+					closest[k] = closest[k - 1];
+					closestDot[k] = closestDot[k - 1];
+				}
+				closest[j] = (int)i;
+				closestDot[j] = dot;
+				break;
+			}
+		}
+	}
+
+	// Weights inversely proportional to the angle, or only the closest one if the direction was measured
+	float weights[3] = { 1.0f, 0.0f, 0.0f };
+	double angle = std::acos(std::min(closestDot[0], 1.0));
+	if (angle > 1e-6)
+	{
+		double total = 0.0;
+		for (int j = 0; j < 3; j++)
+			if (closest[j] != -1) total += 1.0 / std::acos(std::min(closestDot[j], 1.0));
+		for (int j = 0; j < 3; j++)
+			weights[j] = closest[j] == -1 ? 0.0f : (float)(1.0 / std::acos(std::min(closestDot[j], 1.0)) / total);
+	}
+
+	// HRIRs and delays are interpolated separately, then the delay is added to the impulse response as in CrowdRenderer
+	for (int ear = 0; ear < 2; ear++)
+	{
+		float delay = 0.0f;
+		for (int j = 0; j < 3; j++)
+			if (weights[j] > 0.0f) delay += weights[j] * (ear == 0 ? measurements[closest[j]]->leftDelay : measurements[closest[j]]->rightDelay);
+
+		std::fill(impulseResponse.begin(), impulseResponse.end(), 0.0f);
+		float * start = impulseResponse.data() + std::lrint(delay);
+		for (int j = 0; j < 3; j++)
+		{
+			if (weights[j] == 0.0f) continue;
+			const CMonoBuffer<float> & hrir = ear == 0 ? measurements[closest[j]]->leftHRIR : measurements[closest[j]]->rightHRIR;
+			for (size_t n = 0; n < hrir.size(); n++)
+				start[n] += weights[j] * hrir[n];
+		}
+
+		for (int p = 0; p < numberOfPartitions; p++)
+		{
+			std::fill(paddedPartition.begin() + blockSize, paddedPartition.end(), 0.0f);
+			std::copy(impulseResponse.begin() + (size_t)p * blockSize, impulseResponse.begin() + (size_t)(p + 1) * blockSize, paddedPartition.begin());
+			fft->Forward(paddedPartition.data(), spectrum.data());
+			entry.spectra[ear].Store(p, spectrum.data());
+		}
+	}
+}
+
+uint64_t HRIRCache::GetHits() const
+{
+	return hits;
+}
+
+uint64_t HRIRCache::GetMisses() const
+{
+	return misses;
+}
+
+void HRIRCache::ResetStatistics()
+{
+	hits = 0;
+	misses = 0;
+}
+
+int HRIRCache::GetNumberOfPartitions() const
+{
+	return numberOfPartitions;
+}
+
+int HRIRCache::GetNumberOfEntries() const
+{
+	return numberOfUsedSlots;
+}
+
+size_t HRIRCache::GetSizeInBytes() const
+{
+	size_t size = 0;
+	for (const TSlot & slot : slots)
+		size += slot.entry.spectra[0].GetSizeInBytes() + slot.entry.spectra[1].GetSizeInBytes();
+	return size;
+}
@@ -0,0 +1,152 @@
+/**
+*
+* \brief Declaration of HRIRCache, a least recently used cache of interpolated HRIR partitions keyed by quantized direction
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+
+#ifndef _HRIRCACHE_H_
+#define _HRIRCACHE_H_
+
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+#include "FFT.h"
+#include "SpectrumStorage.h"
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/** \details Moving sources need an HRIR interpolated for a new direction on every block. This cache keeps the HRIRs already
+*			 interpolated, keyed by their azimuth and elevation rounded to quantizationStep degrees, so that slow or repeated trajectories
+*			 reuse them. On a miss, the HRIR of the centre of the quantization cell is interpolated between the three measurements closest
+*			 to it, with weights inversely proportional to their angular distance, and transformed into partitions of blockSize samples
+*			 (see UniformPartitionedConvolver). When the cache is full, the least recently used entry is replaced.
+*			 All the memory is allocated in Setup. The cache belongs to the audio thread, which looks it up without locks or allocations.
+*/
+class HRIRCache
+{
+public:
+	/** \brief Interpolated HRIR of one quantized direction
+	*/
+	struct TEntry
+	{
+		float azimuth;													// Centre of the quantization cell, in degrees
+		float elevation;												// Centre of the quantization cell, in degrees from -90 to 90
+		SpectrumStorage spectra[2];										// Left and right HRIR partitions. The delay is part of the impulse response.
+	};
+
+	/** \param [in] blockSize partition size, in samples. Must be a power of two.
+	*	\param [in] quantizationStep size of the quantization cells, in degrees
+	*	\param [in] capacity maximum number of entries
+	*	\param [in] precision format the HRIR spectra are stored in
+	*/
+	HRIRCache(int blockSize, float quantizationStep, int capacity, SpectrumStorage::TPrecision precision = SpectrumStorage::FLOAT32);
+
+	/** \brief Allocates the entries and indexes the measurements of an HRTF. Empties the cache. Not to be called from the audio thread.
+	*	\param [in] hrtf HRTF of a listener, for example after HRTF::CreateFromSofa
+	*	\retval false if the HRTF is empty
+	*/
+	bool Setup(Binaural::CHRTF & hrtf);
+
+	/** \brief Returns the HRIR of the direction of a source, interpolating it if it is not in the cache. To be called from the audio thread.
+	*	\details The entry is valid until the next call to Get.
+	*	\param [in] sourceTransform position of the source
+	*	\param [in] listenerTransform position and orientation of the listener
+	*/
+	const TEntry & Get(const Common::CTransform & sourceTransform, const Common::CTransform & listenerTransform);
+
+	/** \brief Returns the HRIR of a direction, interpolating it if it is not in the cache. To be called from the audio thread.
+	*	\param [in] azimuth azimuth in degrees
+	*	\param [in] elevation elevation in degrees, from -90 to 90 or with the toolkit convention (0 to 90 and 270 to 360)
+	*/
+	const TEntry & Get(float azimuth, float elevation);
+
+	/** \brief Returns the HRIR of a quantized direction, interpolating it if it is not in the cache. To be called from the audio thread.
+	*	\param [in] key quantized direction, as returned by GetKey
+	*/
+	const TEntry & Get(int key);
+
+	/** \brief Returns the quantized direction of an azimuth and elevation, which identifies its entry
+	*	\param [in] azimuth azimuth in degrees
+	*	\param [in] elevation elevation in degrees, from -90 to 90 or with the toolkit convention (0 to 90 and 270 to 360)
+	*/
+	int GetKey(float azimuth, float elevation) const;
+
+	/** \brief Interpolates the HRIR of a direction without quantizing it nor using the cache, as done on every block without it
+	*	\details The entry is valid until the next call to Interpolate.
+	*/
+	const TEntry & Interpolate(float azimuth, float elevation);
+
+	/** \brief Returns the number of lookups found in the cache and interpolated since Setup or ResetStatistics
+	*/
+	uint64_t GetHits() const;
+	uint64_t GetMisses() const;
+	void ResetStatistics();
+
+	int GetNumberOfPartitions() const;
+	int GetNumberOfEntries() const;
+
+	/** \brief Returns the memory used by the HRIR spectra of all the entries, in bytes
+	*/
+	size_t GetSizeInBytes() const;
+
+private:
+	/** \brief Entry with the links of the hash table and of the list of entries from the most to the least recently used
+	*/
+	struct TSlot
+	{
+		TEntry entry;
+		int key;														// Quantized direction, -1 if the slot is free
+		int nextInBucket;
+		int previousUsed;
+		int nextUsed;
+	};
+
+	void Unlink(int slot);
+	void PushFront(int slot);
+	void Compute(float azimuth, float elevation, TEntry & entry);
+
+	int blockSize;
+	float quantizationStep;
+	int numberOfAzimuths;											// Quantization cells in each ring of elevation
+	int numberOfElevations;
+	int capacity;
+	int numberOfPartitions;
+	int numberOfBins;
+	SpectrumStorage::TPrecision precision;
+	std::unique_ptr<FFT> fft;										// Transform of size 2 * blockSize
+
+	std::vector<const THRIRStruct *> measurements;					// HRIRs of the HRTF
+	std::vector<double> measurementDirections;						// Unit vector of each measurement, three values each
+
+	std::vector<TSlot> slots;
+	std::vector<int> buckets;										// First slot of each bucket of the hash table, -1 if empty
+	int numberOfUsedSlots;
+	int mostRecentlyUsed;
+	int leastRecentlyUsed;
+	TEntry uncachedEntry;											// Result of Interpolate
+
+	std::vector<float> impulseResponse;								// numberOfPartitions * blockSize samples
+	std::vector<float> paddedPartition;								// 2 * blockSize samples
+	std::vector<std::complex<float>> spectrum;
+	uint64_t hits;
+	uint64_t misses;
+	bool ready;
+};
+
+#endif
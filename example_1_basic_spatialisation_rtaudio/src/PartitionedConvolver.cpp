@@ -0,0 +1,230 @@
+/**
+*
+* \brief Implementation of the uniform and non-uniform partitioned convolvers used by the reverb
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "PartitionedConvolver.h"
+#include <algorithm>
+
+UniformPartitionedConvolver::UniformPartitionedConvolver()
+	: partitionSize{ 0 }, numberOfPartitions{ 0 }, numberOfBins{ 0 }, delayLinePosition{ 0 }
+{
+}
+
+void UniformPartitionedConvolver::Setup(const std::vector<std::vector<float>> & impulseResponses, size_t offset, size_t length, int partitionSize, SpectrumStorage::TPrecision precision)
+{
+	this->partitionSize = partitionSize;
+	numberOfPartitions = (int)((length + partitionSize - 1) / partitionSize);
+	fft.reset(new FFT(2 * partitionSize));
+	numberOfBins = fft->GetNumberOfBins();
+
+	inputBuffer.assign(2 * partitionSize, 0.0f);
+	delayLine.assign((size_t)numberOfPartitions * numberOfBins, std::complex<float>(0.0f, 0.0f));
+	delayLinePosition = 0;
+	accumulator.resize(numberOfBins);
+	timeBuffer.resize(2 * partitionSize);
+
+	// Each partition is zero padded to twice its size, so that the circular convolution of overlap-save gives partitionSize valid samples
+	filterSpectra.resize(impulseResponses.size());
+	std::vector<float> paddedPartition(2 * partitionSize);
+	std::vector<std::complex<float>> spectrum(numberOfBins);
+	for (size_t ir = 0; ir < impulseResponses.size(); ir++)
+	{
+		const std::vector<float> & impulseResponse = impulseResponses[ir];
+		filterSpectra[ir].Setup(precision, numberOfPartitions, numberOfBins);
+		for (int p = 0; p < numberOfPartitions; p++)
+		{
+			std::fill(paddedPartition.begin(), paddedPartition.end(), 0.0f);
+			for (int n = 0; n < partitionSize; n++)
+			{
+				size_t sample = offset + (size_t)p * partitionSize + n;
+				if (sample < offset + length && sample < impulseResponse.size())
+					paddedPartition[n] = impulseResponse[sample];
+			}
+			fft->Forward(paddedPartition.data(), spectrum.data());
+			filterSpectra[ir].Store(p, spectrum.data());
+		}
+	}
+}
+
+void UniformPartitionedConvolver::Process(const float * input, float * const * outputs)
+{
+	if (numberOfPartitions == 0) return;
+
+	// Sliding the input buffer by one partition and transforming it into the newest slot of the delay line
+	std::copy(inputBuffer.begin() + partitionSize, inputBuffer.end(), inputBuffer.begin());
+	std::copy(input, input + partitionSize, inputBuffer.begin() + partitionSize);
+	delayLinePosition = (delayLinePosition + 1) % numberOfPartitions;
+	fft->Forward(inputBuffer.data(), &delayLine[(size_t)delayLinePosition * numberOfBins]);
+
+	for (size_t ir = 0; ir < filterSpectra.size(); ir++)
+	{
+		// Partition p of the impulse response is multiplied by the input spectrum of p partitions ago
+		std::fill(accumulator.begin(), accumulator.end(), std::complex<float>(0.0f, 0.0f));
+		for (int p = 0; p < numberOfPartitions; p++)
+		{
+			int slot = (delayLinePosition - p + numberOfPartitions) % numberOfPartitions;
+			filterSpectra[ir].MultiplyAccumulate(*fft, p, &delayLine[(size_t)slot * numberOfBins], accumulator.data());
+		}
+		fft->Inverse(accumulator.data(), timeBuffer.data());
+
+		// The first half is aliased by the circular convolution, the second half is the result
+		float * output = outputs[ir];
+		for (int n = 0; n < partitionSize; n++)
+			output[n] += timeBuffer[partitionSize + n];
+	}
+}
+
+int UniformPartitionedConvolver::GetPartitionSize() const
+{
+	return partitionSize;
+}
+
+int UniformPartitionedConvolver::GetNumberOfPartitions() const
+{
+	return numberOfPartitions;
+}
+
+size_t UniformPartitionedConvolver::GetFilterSizeInBytes() const
+{
+	size_t size = 0;
+	for (size_t ir = 0; ir < filterSpectra.size(); ir++)
+		size += filterSpectra[ir].GetSizeInBytes();
+	return size;
+}
+
+NonUniformConvolver::NonUniformConvolver(int blockSize, int tailPartitionFactor, SpectrumStorage::TPrecision precision)
+	: blockSize{ blockSize }, tailPartitionFactor{ tailPartitionFactor }, precision{ precision }, numberOfOutputs{ 0 }, hasTail{ false }, tailPosition{ 0 },
+	  tailFrameSkipped{ false }, tailWorkerFrameSkipped{ false }
+{
+}
+
+void NonUniformConvolver::Setup(const std::vector<std::vector<float>> & impulseResponses)
+{
+	size_t length = 0;
+	for (size_t ir = 0; ir < impulseResponses.size(); ir++)
+		length = std::max(length, impulseResponses[ir].size());
+	numberOfOutputs = (int)impulseResponses.size();
+
+	// The head covers two tail partitions: the tail result of a frame is needed one tail partition after the frame is complete
+	size_t tailPartitionSize = (size_t)tailPartitionFactor * blockSize;
+	size_t headLength = std::min(length, 2 * tailPartitionSize);
+	head.Setup(impulseResponses, 0, headLength, blockSize, precision);
+
+	hasTail = length > headLength;
+	tailPosition = 0;
+	tailFrameSkipped = false;
+	tailWorkerFrameSkipped = false;
+	if (!hasTail) return;
+
+	tail.Setup(impulseResponses, headLength, length - headLength, (int)tailPartitionSize, precision);
+	tailInput.assign(tailPartitionSize, 0.0f);
+	tailWorkerInput.assign(tailPartitionSize, 0.0f);
+	tailOutput.assign(numberOfOutputs, std::vector<float>(tailPartitionSize, 0.0f));
+	tailWorkerOutput.assign(numberOfOutputs, std::vector<float>(tailPartitionSize, 0.0f));
+	tailWorkerOutputPointers.resize(numberOfOutputs);
+	for (int ir = 0; ir < numberOfOutputs; ir++)
+		tailWorkerOutputPointers[ir] = tailWorkerOutput[ir].data();
+	tailSilence.assign(tailPartitionSize, 0.0f);
+	tailDiscardedOutput.assign(numberOfOutputs, std::vector<float>(tailPartitionSize, 0.0f));
+	tailDiscardedOutputPointers.resize(numberOfOutputs);
+	for (int ir = 0; ir < numberOfOutputs; ir++)
+		tailDiscardedOutputPointers[ir] = tailDiscardedOutput[ir].data();
+}
+
+bool NonUniformConvolver::Process(const float * input, float * const * outputs)
+{
+	head.Process(input, outputs);
+	if (!hasTail) return false;
+
+	size_t blockStart = (size_t)tailPosition * blockSize;
+	std::copy(input, input + blockSize, tailInput.begin() + blockStart);
+	for (int ir = 0; ir < numberOfOutputs; ir++)
+	{
+		const float * tailBlock = &tailOutput[ir][blockStart];
+		for (int n = 0; n < blockSize; n++)
+			outputs[ir][n] += tailBlock[n];
+	}
+
+	tailPosition++;
+	if (tailPosition < tailPartitionFactor) return false;
+	tailPosition = 0;
+	return true;
+}
+
+void NonUniformConvolver::ExchangeTailFrame()
+{
+	if (!hasTail) return;
+	tailInput.swap(tailWorkerInput);
+	tailOutput.swap(tailWorkerOutput);
+	for (int ir = 0; ir < numberOfOutputs; ir++)
+		tailWorkerOutputPointers[ir] = tailWorkerOutput[ir].data();
+	// After a dropped frame, the result taken here was due one frame earlier, so it is replaced by silence too
+	if (tailFrameSkipped)
+	{
+		for (int ir = 0; ir < numberOfOutputs; ir++)
+			std::fill(tailOutput[ir].begin(), tailOutput[ir].end(), 0.0f);
+	}
+	tailWorkerFrameSkipped = tailFrameSkipped;
+	tailFrameSkipped = false;
+}
+
+void NonUniformConvolver::SkipTailFrame()
+{
+	if (!hasTail) return;
+	for (int ir = 0; ir < numberOfOutputs; ir++)
+		std::fill(tailOutput[ir].begin(), tailOutput[ir].end(), 0.0f);
+	tailFrameSkipped = true;
+}
+
+void NonUniformConvolver::ProcessTail()
+{
+	if (!hasTail) return;
+	if (tailWorkerFrameSkipped)
+	{
+		// The delay line of the tail moves one partition forward, the result is the output of the dropped frame, which was silent
+		for (int ir = 0; ir < numberOfOutputs; ir++)
+			std::fill(tailDiscardedOutput[ir].begin(), tailDiscardedOutput[ir].end(), 0.0f);
+		tail.Process(tailSilence.data(), tailDiscardedOutputPointers.data());
+		tailWorkerFrameSkipped = false;
+	}
+	for (int ir = 0; ir < numberOfOutputs; ir++)
+		std::fill(tailWorkerOutput[ir].begin(), tailWorkerOutput[ir].end(), 0.0f);
+	tail.Process(tailWorkerInput.data(), tailWorkerOutputPointers.data());
+}
+
+bool NonUniformConvolver::HasTail() const
+{
+	return hasTail;
+}
+
+int NonUniformConvolver::GetBlockSize() const
+{
+	return blockSize;
+}
+
+int NonUniformConvolver::GetTailPartitionSize() const
+{
+	return tailPartitionFactor * blockSize;
+}
+
+size_t NonUniformConvolver::GetFilterSizeInBytes() const
+{
+	return head.GetFilterSizeInBytes() + (hasTail ? tail.GetFilterSizeInBytes() : 0);
+}
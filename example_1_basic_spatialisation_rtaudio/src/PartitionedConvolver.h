@@ -0,0 +1,152 @@
+/**
+*
+* \brief Declaration of the uniform and non-uniform partitioned convolvers used by the reverb
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _PARTITIONEDCONVOLVER_H_
+#define _PARTITIONEDCONVOLVER_H_
+
+#include "FFT.h"
+#include "SpectrumStorage.h"
+#include <complex>
+#include <memory>
+#include <vector>
+
+/** \details Uniformly partitioned overlap-save convolution of one input with one or more impulse responses, which share the frequency domain
+*			 delay line of the input. Each call processes one partition of input and produces one partition of each output.
+*/
+class UniformPartitionedConvolver
+{
+public:
+	/** \brief Creates an empty convolver, Setup must be called before Process
+	*/
+	UniformPartitionedConvolver();
+
+	/** \brief Partitions a segment of the impulse responses and transforms the partitions. Not to be called from the audio thread.
+	*	\param [in] impulseResponses impulse responses, one per output
+	*	\param [in] offset first sample of the segment of the impulse responses convolved by this convolver
+	*	\param [in] length number of samples of the segment. Samples past the end of an impulse response are taken as zero.
+	*	\param [in] partitionSize number of samples of each call to Process. Must be a power of two.
+	*	\param [in] precision format the spectra of the partitions are stored in
+	*/
+	void Setup(const std::vector<std::vector<float>> & impulseResponses, size_t offset, size_t length, int partitionSize, SpectrumStorage::TPrecision precision = SpectrumStorage::FLOAT32);
+
+	/** \brief Convolves one partition of input and adds the result to the outputs
+	*	\param [in] input partitionSize samples
+	*	\param [in,out] outputs one pointer per impulse response to partitionSize samples the result is added to
+	*/
+	void Process(const float * input, float * const * outputs);
+
+	int GetPartitionSize() const;
+	int GetNumberOfPartitions() const;
+
+	/** \brief Returns the memory used by the spectra of the impulse responses, in bytes
+	*/
+	size_t GetFilterSizeInBytes() const;
+
+private:
+	int partitionSize;
+	int numberOfPartitions;
+	int numberOfBins;
+	std::unique_ptr<FFT> fft;										// Transform of size 2 * partitionSize, created by Setup
+	std::vector<float> inputBuffer;									// Previous and current input partitions
+	std::vector<std::complex<float>> delayLine;						// Spectra of the last numberOfPartitions input buffers
+	int delayLinePosition;											// Partition of delayLine holding the newest spectrum
+	std::vector<SpectrumStorage> filterSpectra;						// Spectra of the partitions of each impulse response
+	std::vector<std::complex<float>> accumulator;
+	std::vector<float> timeBuffer;
+};
+
+/** \details Convolution with long impulse responses at a small block size. The first 2 * tailPartitionFactor * blockSize samples (head)
+*			 are convolved in blocks of blockSize samples, and the rest (tail) in partitions of tailPartitionFactor * blockSize samples.
+*			 Every tailPartitionFactor blocks a tail frame is complete: the owner calls ExchangeTailFrame from the audio thread and then
+*			 ProcessTail from a background thread, which has until the next exchange to finish. As the head covers two tail partitions,
+*			 the tail output is always ready before it is needed and the convolution has no latency. If ProcessTail has not finished
+*			 by then, the owner calls SkipTailFrame instead, so the audio thread never waits for it.
+*/
+class NonUniformConvolver
+{
+public:
+	/** \param [in] blockSize number of samples of each call to Process. Must be a power of two.
+	*	\param [in] tailPartitionFactor size of the tail partitions, in blocks. Must be a power of two.
+	*	\param [in] precision format the spectra of the impulse responses are stored in
+	*/
+	NonUniformConvolver(int blockSize, int tailPartitionFactor, SpectrumStorage::TPrecision precision = SpectrumStorage::FLOAT32);
+
+	/** \brief Partitions and transforms the impulse responses. Not to be called from the audio thread.
+	*	\param [in] impulseResponses impulse responses, one per output
+	*/
+	void Setup(const std::vector<std::vector<float>> & impulseResponses);
+
+	/** \brief Convolves one block of input with the head of the impulse responses, and adds the head and tail results to the outputs
+	*	\param [in] input blockSize samples
+	*	\param [in,out] outputs one pointer per impulse response to blockSize samples the result is added to
+	*	\retval true if a tail frame has been completed, and ExchangeTailFrame must be called before the next block
+	*/
+	bool Process(const float * input, float * const * outputs);
+
+	/** \brief Hands the completed tail frame to ProcessTail and takes the result of the previous one. ProcessTail must not be running.
+	*/
+	void ExchangeTailFrame();
+
+	/** \brief Drops the completed tail frame, instead of ExchangeTailFrame, when ProcessTail is still running on the previous one
+	*	\details The tail output of the next two frames is silent: the result due for the first one is not ready, and the second one
+	*			 would be the result of the dropped frame. The next ProcessTail convolves a silent frame in place of the dropped one first,
+	*			 so that the later tail frames stay in time. If several frames in a row are dropped, only one is replaced.
+	*/
+	void SkipTailFrame();
+
+	/** \brief Convolves the last exchanged tail frame with the tail of the impulse responses. To be called from a background thread.
+	*/
+	void ProcessTail();
+
+	/** \brief Returns true if the impulse responses are longer than the head
+	*/
+	bool HasTail() const;
+
+	int GetBlockSize() const;
+	int GetTailPartitionSize() const;
+
+	/** \brief Returns the memory used by the spectra of the impulse responses, in bytes
+	*/
+	size_t GetFilterSizeInBytes() const;
+
+private:
+	int blockSize;
+	int tailPartitionFactor;
+	SpectrumStorage::TPrecision precision;
+	int numberOfOutputs;
+	bool hasTail;
+	UniformPartitionedConvolver head;
+	UniformPartitionedConvolver tail;
+
+	int tailPosition;												// Blocks of the current tail frame received so far
+	std::vector<float> tailInput;									// Tail frame being received by Process
+	std::vector<float> tailWorkerInput;								// Tail frame being convolved by ProcessTail
+	std::vector<std::vector<float>> tailOutput;						// Tail result being added to the outputs by Process
+	std::vector<std::vector<float>> tailWorkerOutput;				// Tail result being computed by ProcessTail
+	std::vector<float *> tailWorkerOutputPointers;
+	bool tailFrameSkipped;											// A frame has been dropped by SkipTailFrame since the last exchange
+	bool tailWorkerFrameSkipped;									// ProcessTail must convolve a silent frame before its own one
+	std::vector<float> tailSilence;									// Silent frame convolved in place of a dropped one
+	std::vector<std::vector<float>> tailDiscardedOutput;			// Output of that frame, which was due while it was dropped
+	std::vector<float *> tailDiscardedOutputPointers;
+};
+
+#endif
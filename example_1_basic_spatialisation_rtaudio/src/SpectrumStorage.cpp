@@ -0,0 +1,145 @@
+/**
+*
+* \brief Implementation of SpectrumStorage, which keeps the partitions of a filter in float, half precision or block floating point int16
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "SpectrumStorage.h"
+#include <algorithm>
+#include <cmath>
+
+SpectrumStorage::SpectrumStorage()
+	: precision{ FLOAT32 }, numberOfPartitions{ 0 }, numberOfBins{ 0 }, blocksPerPartition{ 0 }
+{
+}
+
+void SpectrumStorage::Setup(TPrecision _precision, int _numberOfPartitions, int _numberOfBins)
+{
+	precision = _precision;
+	numberOfPartitions = _numberOfPartitions;
+	numberOfBins = _numberOfBins;
+	blocksPerPartition = (numberOfBins + SPECTRUM_BLOCK_BINS - 1) / SPECTRUM_BLOCK_BINS;
+	size_t values = (size_t)numberOfPartitions * numberOfBins;
+
+	floatSpectra.clear();
+	halfSpectra.clear();
+	intSpectra.clear();
+	blockScales.clear();
+	switch (precision)
+	{
+	case FLOAT32:		floatSpectra.assign(values, std::complex<float>(0.0f, 0.0f));	break;
+	case FLOAT16:		halfSpectra.assign(2 * values, 0);									break;
+	case BLOCK_INT16:
+		intSpectra.assign(2 * values, 0);
+		blockScales.assign((size_t)numberOfPartitions * blocksPerPartition, 0.0f);
+		break;
+	}
+}
+
+void SpectrumStorage::Store(int partition, const std::complex<float> * spectrum)
+{
+	size_t offset = (size_t)partition * numberOfBins;
+	if (precision == FLOAT32)
+	{
+		std::copy(spectrum, spectrum + numberOfBins, floatSpectra.begin() + offset);
+	}
+	else if (precision == FLOAT16)
+	{
+		for (int k = 0; k < numberOfBins; k++)
+		{
+			halfSpectra[2 * (offset + k)] = FFTBackend::FloatToHalf(spectrum[k].real());
+			halfSpectra[2 * (offset + k) + 1] = FFTBackend::FloatToHalf(spectrum[k].imag());
+		}
+	}
+	else
+	{
+		for (int block = 0; block < blocksPerPartition; block++)
+		{
+			int first = block * SPECTRUM_BLOCK_BINS;
+			int end = std::min(first + SPECTRUM_BLOCK_BINS, numberOfBins);
+			float largest = 0.0f;
+			for (int k = first; k < end; k++)
+				largest = std::max(largest, std::max(std::abs(spectrum[k].real()), std::abs(spectrum[k].imag())));
+
+			float scale = largest / 32767.0f;
+			float inverseScale = largest > 0.0f ? 1.0f / scale : 0.0f;
+			blockScales[(size_t)partition * blocksPerPartition + block] = scale;
+			for (int k = first; k < end; k++)
+			{
+				intSpectra[2 * (offset + k)] = (int16_t)std::lrint(spectrum[k].real() * inverseScale);
+				intSpectra[2 * (offset + k) + 1] = (int16_t)std::lrint(spectrum[k].imag() * inverseScale);
+			}
+		}
+	}
+}
+
+void SpectrumStorage::Load(int partition, std::complex<float> * spectrum) const
+{
+	size_t offset = (size_t)partition * numberOfBins;
+	for (int k = 0; k < numberOfBins; k++)
+	{
+		if (precision == FLOAT32)
+			spectrum[k] = floatSpectra[offset + k];
+		else if (precision == FLOAT16)
+			spectrum[k] = std::complex<float>(FFTBackend::HalfToFloat(halfSpectra[2 * (offset + k)]), FFTBackend::HalfToFloat(halfSpectra[2 * (offset + k) + 1]));
+		else
+		{
+			float scale = blockScales[(size_t)partition * blocksPerPartition + k / SPECTRUM_BLOCK_BINS];
+			spectrum[k] = std::complex<float>(intSpectra[2 * (offset + k)] * scale, intSpectra[2 * (offset + k) + 1] * scale);
+		}
+	}
+}
+
+void SpectrumStorage::MultiplyAccumulate(const FFT & fft, int partition, const std::complex<float> * input, std::complex<float> * accumulator) const
+{
+	size_t offset = (size_t)partition * numberOfBins;
+	const FFTBackend & backend = fft.GetBackend();
+	switch (precision)
+	{
+	case FLOAT32:
+		backend.MultiplyAccumulate(input, &floatSpectra[offset], accumulator, numberOfBins);
+		break;
+	case FLOAT16:
+		backend.MultiplyAccumulateHalf(input, &halfSpectra[2 * offset], accumulator, numberOfBins);
+		break;
+	case BLOCK_INT16:
+		backend.MultiplyAccumulateBlockInt16(input, &intSpectra[2 * offset], &blockScales[(size_t)partition * blocksPerPartition], accumulator, numberOfBins);
+		break;
+	}
+}
+
+size_t SpectrumStorage::GetSizeInBytes() const
+{
+	return floatSpectra.size() * sizeof(std::complex<float>) + halfSpectra.size() * sizeof(uint16_t) + intSpectra.size() * sizeof(int16_t) + blockScales.size() * sizeof(float);
+}
+
+SpectrumStorage::TPrecision SpectrumStorage::GetPrecision() const
+{
+	return precision;
+}
+
+const char * SpectrumStorage::GetPrecisionName(TPrecision precision)
+{
+	switch (precision)
+	{
+	case FLOAT32:		return "float32";
+	case FLOAT16:		return "float16";
+	case BLOCK_INT16:	return "int16 block";
+	}
+	return "";
+}
@@ -0,0 +1,90 @@
+/**
+*
+* \brief Declaration of SpectrumStorage, which keeps the partitions of a filter in float, half precision or block floating point int16
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _SPECTRUMSTORAGE_H_
+#define _SPECTRUMSTORAGE_H_
+
+#include "FFT.h"
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+/** \details Filter partitions are read once per block by the convolution, so with long or many filters their memory traffic limits the speed.
+*			 Storing them with 16 bits per value halves that traffic. The conversion back to float is done by the FFT backend inside the product:
+*			 - FLOAT16: half precision, with about 11 bits of precision relative to each value
+*			 - BLOCK_INT16: int16 with one scale per SPECTRUM_BLOCK_BINS bins, with 15 bits of precision relative to the largest value of each block
+*/
+class SpectrumStorage
+{
+public:
+	enum TPrecision { FLOAT32, FLOAT16, BLOCK_INT16 };
+
+	SpectrumStorage();
+
+	/** \brief Allocates the storage of a filter. Not to be called from the audio thread.
+	*	\param [in] precision format of the stored values
+	*	\param [in] numberOfPartitions number of spectra of the filter
+	*	\param [in] numberOfBins number of complex bins of each spectrum
+	*/
+	void Setup(TPrecision precision, int numberOfPartitions, int numberOfBins);
+
+	/** \brief Converts a spectrum into the format of the storage
+	*	\param [in] partition index of the spectrum
+	*	\param [in] spectrum numberOfBins complex bins
+	*/
+	void Store(int partition, const std::complex<float> * spectrum);
+
+	/** \brief Converts a stored spectrum back into float
+	*	\param [in] partition index of the spectrum
+	*	\param [out] spectrum numberOfBins complex bins
+	*/
+	void Load(int partition, std::complex<float> * spectrum) const;
+
+	/** \brief Multiplies a spectrum by a stored one bin by bin and adds the result to a third one
+	*	\param [in] fft transform whose backend computes the product
+	*	\param [in] partition index of the stored spectrum
+	*	\param [in] input numberOfBins complex bins
+	*	\param [in,out] accumulator numberOfBins complex bins the product is added to
+	*/
+	void MultiplyAccumulate(const FFT & fft, int partition, const std::complex<float> * input, std::complex<float> * accumulator) const;
+
+	/** \brief Returns the memory used by the stored spectra, in bytes
+	*/
+	size_t GetSizeInBytes() const;
+
+	TPrecision GetPrecision() const;
+
+	/** \brief Returns the name of a precision, as shown by the benchmarks
+	*/
+	static const char * GetPrecisionName(TPrecision precision);
+
+private:
+	TPrecision precision;
+	int numberOfPartitions;
+	int numberOfBins;
+	int blocksPerPartition;											// Scales of each partition in BLOCK_INT16
+	std::vector<std::complex<float>> floatSpectra;					// FLOAT32
+	std::vector<uint16_t> halfSpectra;								// FLOAT16, real and imaginary parts interleaved
+	std::vector<int16_t> intSpectra;								// BLOCK_INT16, real and imaginary parts interleaved
+	std::vector<float> blockScales;									// BLOCK_INT16
+};
+
+#endif
@@ -0,0 +1,120 @@
+/**
+*
+* \brief Implementation of a small pool of worker threads used to split work in independent jobs
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "ThreadPool.h"
+
+#define JOB_INDEX_MASK 0xFFFFFFFFull
+
+ThreadPool::ThreadPool(unsigned int numberOfWorkers)
+	: currentJob{ nullptr }, numberOfJobs{ 0 }, jobState{ 0 }, finishedJobs{ 0 }, batch{ 0 }, stopping{ false }
+{
+	if (numberOfWorkers == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		numberOfWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+	for (unsigned int i = 0; i < numberOfWorkers; i++)
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+unsigned int ThreadPool::GetNumberOfThreads() const
+{
+	return (unsigned int)workers.size() + 1;
+}
+
+void ThreadPool::ParallelFor(unsigned int _numberOfJobs, const std::function<void(unsigned int)> & job)
+{
+	if (_numberOfJobs == 0) return;
+	if (_numberOfJobs == 1)												// Not worth waking up anybody
+	{
+		job(0);
+		return;
+	}
+
+	std::lock_guard<std::mutex> callerLock(callerMutex);
+	unsigned long long jobBatch;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentJob = &job;
+		numberOfJobs = _numberOfJobs;
+		finishedJobs.store(0);
+		jobBatch = ++batch;
+		jobState.store((jobBatch & JOB_INDEX_MASK) << 32);
+	}
+	wakeUp.notify_all();
+
+	RunJobs(jobBatch, &job, _numberOfJobs);								// The caller works too, taking every job not started yet
+
+	// Only the jobs that workers took and are still running are waited for
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this, _numberOfJobs] { return finishedJobs.load() == _numberOfJobs; });
+	currentJob = nullptr;
+}
+
+void ThreadPool::RunJobs(unsigned long long jobBatch, const std::function<void(unsigned int)> * job, unsigned int jobs)
+{
+	// A job is taken only while the batch is still the one the thread was woken up for, so a late worker never takes the jobs
+	// of a later batch with the job of an earlier one
+	unsigned long long batchTag = (jobBatch & JOB_INDEX_MASK) << 32;
+	unsigned long long state = jobState.load();
+	while ((state & ~JOB_INDEX_MASK) == batchTag && (state & JOB_INDEX_MASK) < jobs)
+	{
+		if (!jobState.compare_exchange_weak(state, state + 1)) continue;
+		(*job)((unsigned int)(state & JOB_INDEX_MASK));
+		if (finishedJobs.fetch_add(1) + 1 == jobs)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.notify_one();
+		}
+		state = jobState.load();
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	unsigned long long lastBatch = 0;
+	while (true)
+	{
+		const std::function<void(unsigned int)> * job;
+		unsigned int jobs;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeUp.wait(lock, [this, lastBatch] { return stopping || batch != lastBatch; });
+			if (stopping) return;
+			lastBatch = batch;
+			job = currentJob;
+			jobs = numberOfJobs;
+		}
+
+		RunJobs(lastBatch, job, jobs);
+	}
+}
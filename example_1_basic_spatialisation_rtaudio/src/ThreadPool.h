@@ -0,0 +1,76 @@
+/**
+*
+* \brief Declaration of a small pool of worker threads used to split work in independent jobs
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+class ThreadPool
+{
+public:
+	/** \brief Creates the worker threads
+	*	\param [in] numberOfWorkers number of worker threads. If 0, one less than the number of hardware threads is used,
+	*				as the thread calling ParallelFor also runs jobs.
+	*/
+	ThreadPool(unsigned int numberOfWorkers = 0);
+
+	/** \brief Stops and joins all the worker threads
+	*/
+	~ThreadPool();
+
+	/** \brief Runs job(0) ... job(numberOfJobs - 1) spread over the workers and the calling thread, and returns when all of them have finished
+	*	\details Jobs are taken in increasing index order but may run in any order and concurrently, so they must not depend on each other.
+	*			 No memory is allocated, so it can be called from the audio thread once per block. The calling thread takes every job
+	*			 the workers have not started, so it only waits for the jobs running on a worker: a worker that is woken up late does
+	*			 not delay the batch, but a worker preempted in the middle of a job still does.
+	*	\param [in] numberOfJobs number of jobs to run
+	*	\param [in] job function to be called with the index of each job
+	*/
+	void ParallelFor(unsigned int numberOfJobs, const std::function<void(unsigned int)> & job);
+
+	/** \brief Returns the number of threads that run jobs, including the thread calling ParallelFor
+	*/
+	unsigned int GetNumberOfThreads() const;
+
+private:
+	void WorkerLoop();
+	void RunJobs(unsigned long long jobBatch, const std::function<void(unsigned int)> * job, unsigned int jobs);
+
+	std::vector<std::thread> workers;									// Worker threads
+	std::mutex callerMutex;												// Serializes concurrent calls to ParallelFor
+	std::mutex mutex;													// Protects the state below
+	std::condition_variable wakeUp;										// Signals the workers that there is a new batch of jobs
+	std::condition_variable finished;									// Signals the caller that all the jobs of the batch have finished
+	const std::function<void(unsigned int)> * currentJob;				// Job of the current batch
+	unsigned int numberOfJobs;											// Number of jobs of the current batch
+	std::atomic<unsigned long long> jobState;							// Low 32 bits of the batch counter in the upper half, index of the next job to be taken in the lower half
+	std::atomic<unsigned int> finishedJobs;								// Jobs of the current batch that have finished
+	unsigned long long batch;											// Batch counter, to wake up workers only once per batch
+	bool stopping;														// Set when the pool is being destroyed
+};
+
+#endif
@@ -0,0 +1,348 @@
+/**
+*
+* \brief Implementation of VectorizedHAHL, a simplified hearing loss and hearing aid simulation computed with SSE2
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+
+#include "VectorizedHAHL.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAHL_SSE2
+#endif
+
+#define POWER_FLOOR				1e-12f			// Smallest band power, about -120 dBFS, which keeps the detectors away from denormals
+#define DB_TO_LOG2				0.16609640f		// log2(10) / 20, to turn a gain in dB into a power of two
+#define POWER_TO_DB				3.01029996f		// 10 * log10(2), to turn log2 of a power into dB
+
+// Cubic fits of log2(m) for m in [1, 2) and of 2^f for f in [0, 1), the latter exact at 0 so that a gain of 0 dB is exactly 1.
+// Errors below 0.001 and 0.00014 respectively, that is, below 0.003 dB in the level and 0.0012 dB in the gain.
+#define LOG2_C3					0.15544866f
+#define LOG2_C2					-1.0392759f
+#define LOG2_C1					3.0295121f
+#define LOG2_C0					-2.1449607f
+#define EXP2_C3					0.07914497f
+#define EXP2_C2					0.22499818f
+#define EXP2_C1					0.69585685f
+
+namespace
+{
+	inline float FastLog2(float x)
+	{
+		int32_t bits;
+		std::memcpy(&bits, &x, sizeof(bits));
+		float exponent = (float)((bits >> 23) - 127);
+		bits = (bits & 0x007FFFFF) | 0x3F800000;
+		float m;
+		std::memcpy(&m, &bits, sizeof(m));
+		return exponent + (((LOG2_C3 * m + LOG2_C2) * m + LOG2_C1) * m + LOG2_C0);
+	}
+
+	inline float FastExp2(float x)
+	{
+		x = std::min(std::max(x, -126.0f), 126.0f);
+		float floorX = std::floor(x);
+		float f = x - floorX;
+		int32_t bits = ((int32_t)floorX + 127) << 23;
+		float scale;
+		std::memcpy(&scale, &bits, sizeof(scale));
+		return (((EXP2_C3 * f + EXP2_C2) * f + EXP2_C1) * f + 1.0f) * scale;
+	}
+
+	/** \brief Gain of each band, as a power of two, from the power of the band
+	*	\details The hearing aid gain falls from aidGain below VECTORIZED_HAHL_AID_KNEE_DBSPL to 0 at VECTORIZED_HAHL_RECRUITMENT_DBSPL, and the hearing loss
+	*			 attenuation falls from loss at 0 dB SPL to 0 at VECTORIZED_HAHL_RECRUITMENT_DBSPL, measured on the level after the hearing aid.
+	*/
+	inline float BandGainLog2(float power, float loss, float aidGain, bool hearingAid)
+	{
+		float level = (VECTORIZED_HAHL_CALIBRATION_DBSPL + POWER_TO_DB) + POWER_TO_DB * FastLog2(power);
+		float gainAid = 0.0f;
+		if (hearingAid)
+			gainAid = aidGain * std::min(std::max((VECTORIZED_HAHL_RECRUITMENT_DBSPL - level) * (1.0f / (VECTORIZED_HAHL_RECRUITMENT_DBSPL - VECTORIZED_HAHL_AID_KNEE_DBSPL)), 0.0f), 1.0f);
+		float gainLoss = -loss * std::min(std::max((VECTORIZED_HAHL_RECRUITMENT_DBSPL - (level + gainAid)) * (1.0f / VECTORIZED_HAHL_RECRUITMENT_DBSPL), 0.0f), 1.0f);
+		return (gainAid + gainLoss) * DB_TO_LOG2;
+	}
+
+	/** \brief Weight of each lowpass output: gain of band k minus gain of band k + 1, as the bands are differences of lowpass outputs
+	*/
+	void ComputeWeights(const float * power, const float * loss, const float * aidGain, bool hearingAid, float * weights)
+	{
+		float gains[VECTORIZED_HAHL_NUMBER_OF_BANDS + 1];
+		for (int k = 0; k < VECTORIZED_HAHL_NUMBER_OF_BANDS; k++)
+			gains[k] = FastExp2(BandGainLog2(power[k], loss[k], aidGain[k], hearingAid));
+		gains[VECTORIZED_HAHL_NUMBER_OF_BANDS] = 0.0f;
+		for (int k = 0; k < VECTORIZED_HAHL_NUMBER_OF_BANDS; k++)
+			weights[k] = gains[k] - gains[k + 1];
+	}
+
+#ifdef HAHL_SSE2
+	static_assert(VECTORIZED_HAHL_NUMBER_OF_BANDS == 8, "The SSE2 implementation holds the bands of an ear in two registers");
+
+	inline __m128 Clamp01(__m128 x)
+	{
+		return _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	}
+
+	inline __m128 FastLog2(__m128 x)
+	{
+		__m128i bits = _mm_castps_si128(x);
+		__m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+		__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+		__m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(LOG2_C3), m), _mm_set1_ps(LOG2_C2));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(LOG2_C1));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(LOG2_C0));
+		return _mm_add_ps(exponent, p);
+	}
+
+	inline __m128 FastExp2(__m128 x)
+	{
+		x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(126.0f));
+		__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+		__m128 floorX = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+		__m128 f = _mm_sub_ps(x, floorX);
+		__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(floorX), _mm_set1_epi32(127)), 23));
+		__m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(EXP2_C3), f), _mm_set1_ps(EXP2_C2));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(EXP2_C1));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+		return _mm_mul_ps(p, scale);
+	}
+
+	inline __m128 BandGainLog2(__m128 power, __m128 loss, __m128 aidGain, bool hearingAid)
+	{
+		const __m128 recruitment = _mm_set1_ps(VECTORIZED_HAHL_RECRUITMENT_DBSPL);
+		__m128 level = _mm_add_ps(_mm_set1_ps(VECTORIZED_HAHL_CALIBRATION_DBSPL + POWER_TO_DB), _mm_mul_ps(_mm_set1_ps(POWER_TO_DB), FastLog2(power)));
+		__m128 gainAid = _mm_setzero_ps();
+		if (hearingAid)
+			gainAid = _mm_mul_ps(aidGain, Clamp01(_mm_mul_ps(_mm_sub_ps(recruitment, level), _mm_set1_ps(1.0f / (VECTORIZED_HAHL_RECRUITMENT_DBSPL - VECTORIZED_HAHL_AID_KNEE_DBSPL)))));
+		__m128 gainLoss = _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), loss),
+									 Clamp01(_mm_mul_ps(_mm_sub_ps(recruitment, _mm_add_ps(level, gainAid)), _mm_set1_ps(1.0f / VECTORIZED_HAHL_RECRUITMENT_DBSPL))));
+		return _mm_mul_ps(_mm_add_ps(gainAid, gainLoss), _mm_set1_ps(DB_TO_LOG2));
+	}
+
+	inline void ComputeWeights(__m128 powerLow, __m128 powerHigh, const float * loss, const float * aidGain, bool hearingAid, __m128 & weightsLow, __m128 & weightsHigh)
+	{
+		float gains[VECTORIZED_HAHL_NUMBER_OF_BANDS + 4];
+		_mm_storeu_ps(gains, FastExp2(BandGainLog2(powerLow, _mm_loadu_ps(loss), _mm_loadu_ps(aidGain), hearingAid)));
+		_mm_storeu_ps(gains + 4, FastExp2(BandGainLog2(powerHigh, _mm_loadu_ps(loss + 4), _mm_loadu_ps(aidGain + 4), hearingAid)));
+		gains[VECTORIZED_HAHL_NUMBER_OF_BANDS] = 0.0f;
+		weightsLow = _mm_sub_ps(_mm_loadu_ps(gains), _mm_loadu_ps(gains + 1));
+		weightsHigh = _mm_sub_ps(_mm_loadu_ps(gains + 4), _mm_loadu_ps(gains + 5));
+	}
+#endif
+}
+
+VectorizedHAHL::VectorizedHAHL(int sampleRate)
+	: hearingAid{ false }, vectorized{ false }
+{
+	// Second order Butterworth lowpass filters at the upper edge of each band but the last one, whose "filter" is the input itself
+	const float pi = 3.14159265f;
+	for (int k = 0; k < VECTORIZED_HAHL_NUMBER_OF_BANDS; k++)
+	{
+		if (k == VECTORIZED_HAHL_NUMBER_OF_BANDS - 1)
+		{
+			b0[k] = 1.0f; b1[k] = 0.0f; b2[k] = 0.0f; a1[k] = 0.0f; a2[k] = 0.0f;
+			continue;
+		}
+		float edge = VECTORIZED_HAHL_FIRST_BAND_HZ * std::pow(2.0f, k + 0.5f);
+		float w = 2.0f * pi * edge / sampleRate;
+		float alpha = std::sin(w) / (2.0f * 0.70710678f);
+		float cosw = std::cos(w);
+		float a0 = 1.0f + alpha;
+		b0[k] = (1.0f - cosw) / 2.0f / a0;
+		b1[k] = (1.0f - cosw) / a0;
+		b2[k] = b0[k];
+		a1[k] = -2.0f * cosw / a0;
+		a2[k] = (1.0f - alpha) / a0;
+	}
+	attack = 1.0f - std::exp(-1000.0f / (VECTORIZED_HAHL_ATTACK_MS * sampleRate));
+	release = 1.0f - std::exp(-1000.0f / (VECTORIZED_HAHL_RELEASE_MS * sampleRate));
+
+	for (TEarState & ear : ears)
+	{
+		std::fill(ear.z1, ear.z1 + VECTORIZED_HAHL_NUMBER_OF_BANDS, 0.0f);
+		std::fill(ear.z2, ear.z2 + VECTORIZED_HAHL_NUMBER_OF_BANDS, 0.0f);
+		std::fill(ear.power, ear.power + VECTORIZED_HAHL_NUMBER_OF_BANDS, POWER_FLOOR);
+		std::fill(ear.loss, ear.loss + VECTORIZED_HAHL_NUMBER_OF_BANDS, 0.0f);
+		std::fill(ear.aidGain, ear.aidGain + VECTORIZED_HAHL_NUMBER_OF_BANDS, 0.0f);
+		ComputeWeights(ear.power, ear.loss, ear.aidGain, hearingAid, ear.weights);
+	}
+	SetVectorized(true);
+}
+
+void VectorizedHAHL::SetHearingLoss(Common::T_ear ear, const std::vector<float> & hearingLevels)
+{
+	for (int e = 0; e < 2; e++)
+	{
+		if ((e == 0 && ear == Common::T_ear::RIGHT) || (e == 1 && ear == Common::T_ear::LEFT)) continue;
+		for (int k = 0; k < VECTORIZED_HAHL_NUMBER_OF_BANDS; k++)
+		{
+			float loss = hearingLevels.empty() ? 0.0f : hearingLevels[std::min((size_t)k, hearingLevels.size() - 1)];
+			ears[e].loss[k] = std::max(loss, 0.0f);
+			ears[e].aidGain[k] = VECTORIZED_HAHL_AID_GAIN_FACTOR * ears[e].loss[k];
+		}
+		ComputeWeights(ears[e].power, ears[e].loss, ears[e].aidGain, hearingAid, ears[e].weights);
+	}
+}
+
+void VectorizedHAHL::SetHearingAid(bool enabled)
+{
+	hearingAid = enabled;
+	for (TEarState & ear : ears)
+		ComputeWeights(ear.power, ear.loss, ear.aidGain, hearingAid, ear.weights);
+}
+
+void VectorizedHAHL::SetVectorized(bool _vectorized)
+{
+#ifdef HAHL_SSE2
+	vectorized = _vectorized;
+#else
+	vectorized = false;
+#endif
+}
+
+bool VectorizedHAHL::IsVectorized() const
+{
+	return vectorized;
+}
+
+void VectorizedHAHL::Process(Common::CEarPair<CMonoBuffer<float>> & buffer)
+{
+#ifdef HAHL_SSE2
+	// The filters decay into denormals after the input goes silent, which would slow down both implementations
+	unsigned int controlStatus = _mm_getcsr();
+	_mm_setcsr(controlStatus | 0x8040);								// Flush to zero and denormals are zero
+#endif
+	CMonoBuffer<float> * channels[2] = { &buffer.left, &buffer.right };
+	for (int e = 0; e < 2; e++)
+	{
+#ifdef HAHL_SSE2
+		if (vectorized)
+		{
+			ProcessEarSSE2(ears[e], channels[e]->data(), (int)channels[e]->size());
+			continue;
+		}
+#endif
+		ProcessEarScalar(ears[e], channels[e]->data(), (int)channels[e]->size());
+	}
+#ifdef HAHL_SSE2
+	_mm_setcsr(controlStatus);
+#endif
+}
+
+void VectorizedHAHL::ProcessEarScalar(TEarState & ear, float * samples, int size)
+{
+	// Same operations, in the same order, as the SSE2 implementation, lane by lane
+	const int N = VECTORIZED_HAHL_NUMBER_OF_BANDS;
+	for (int start = 0; start < size; start += VECTORIZED_HAHL_GAIN_INTERVAL)
+	{
+		int length = std::min(VECTORIZED_HAHL_GAIN_INTERVAL, size - start);
+		float target[N], step[N];
+		ComputeWeights(ear.power, ear.loss, ear.aidGain, hearingAid, target);
+		for (int k = 0; k < N; k++) step[k] = (target[k] - ear.weights[k]) * (1.0f / length);
+
+		for (int n = start; n < start + length; n++)
+		{
+			float x = samples[n], y[N], sum[N / 2];
+			for (int k = 0; k < N; k++)
+			{
+				y[k] = b0[k] * x + ear.z1[k];
+				ear.z1[k] = (b1[k] * x - a1[k] * y[k]) + ear.z2[k];
+				ear.z2[k] = b2[k] * x - a2[k] * y[k];
+			}
+			for (int k = 0; k < N; k++)
+			{
+				float band = y[k] - (k > 0 ? y[k - 1] : 0.0f);
+				float power = band * band;
+				float alpha = power > ear.power[k] ? attack : release;
+				ear.power[k] = std::max(ear.power[k] + alpha * (power - ear.power[k]), POWER_FLOOR);
+				ear.weights[k] += step[k];
+			}
+			for (int k = 0; k < N / 2; k++) sum[k] = ear.weights[k] * y[k] + ear.weights[k + N / 2] * y[k + N / 2];
+			samples[n] = (sum[0] + sum[2]) + (sum[1] + sum[3]);
+		}
+		std::copy(target, target + N, ear.weights);
+	}
+}
+
+void VectorizedHAHL::ProcessEarSSE2(TEarState & ear, float * samples, int size)
+{
+#ifdef HAHL_SSE2
+	// Lanes 0 to 3 hold the lowpass outputs of bands 0 to 3 (low), lanes 4 to 7 those of bands 4 to 7 (high)
+	const __m128 b0Low = _mm_loadu_ps(b0), b1Low = _mm_loadu_ps(b1), b2Low = _mm_loadu_ps(b2), a1Low = _mm_loadu_ps(a1), a2Low = _mm_loadu_ps(a2);
+	const __m128 b0High = _mm_loadu_ps(b0 + 4), b1High = _mm_loadu_ps(b1 + 4), b2High = _mm_loadu_ps(b2 + 4), a1High = _mm_loadu_ps(a1 + 4), a2High = _mm_loadu_ps(a2 + 4);
+	const __m128 attackV = _mm_set1_ps(attack), releaseV = _mm_set1_ps(release), floorV = _mm_set1_ps(POWER_FLOOR);
+	__m128 z1Low = _mm_loadu_ps(ear.z1), z1High = _mm_loadu_ps(ear.z1 + 4), z2Low = _mm_loadu_ps(ear.z2), z2High = _mm_loadu_ps(ear.z2 + 4);
+	__m128 powerLow = _mm_loadu_ps(ear.power), powerHigh = _mm_loadu_ps(ear.power + 4);
+	__m128 weightsLow = _mm_loadu_ps(ear.weights), weightsHigh = _mm_loadu_ps(ear.weights + 4);
+
+	for (int start = 0; start < size; start += VECTORIZED_HAHL_GAIN_INTERVAL)
+	{
+		int length = std::min(VECTORIZED_HAHL_GAIN_INTERVAL, size - start);
+		__m128 targetLow, targetHigh;
+		ComputeWeights(powerLow, powerHigh, ear.loss, ear.aidGain, hearingAid, targetLow, targetHigh);
+		const __m128 inverseLength = _mm_set1_ps(1.0f / length);
+		const __m128 stepLow = _mm_mul_ps(_mm_sub_ps(targetLow, weightsLow), inverseLength);
+		const __m128 stepHigh = _mm_mul_ps(_mm_sub_ps(targetHigh, weightsHigh), inverseLength);
+
+		for (int n = start; n < start + length; n++)
+		{
+			__m128 x = _mm_set1_ps(samples[n]);
+			__m128 yLow = _mm_add_ps(_mm_mul_ps(b0Low, x), z1Low);
+			__m128 yHigh = _mm_add_ps(_mm_mul_ps(b0High, x), z1High);
+			z1Low = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1Low, x), _mm_mul_ps(a1Low, yLow)), z2Low);
+			z1High = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1High, x), _mm_mul_ps(a1High, yHigh)), z2High);
+			z2Low = _mm_sub_ps(_mm_mul_ps(b2Low, x), _mm_mul_ps(a2Low, yLow));
+			z2High = _mm_sub_ps(_mm_mul_ps(b2High, x), _mm_mul_ps(a2High, yHigh));
+
+			// Band k is lowpass k minus lowpass k - 1: the previous lowpass of each lane is obtained by shifting the lanes up by one
+			__m128 previousLow = _mm_move_ss(_mm_shuffle_ps(yLow, yLow, _MM_SHUFFLE(2, 1, 0, 0)), _mm_setzero_ps());
+			__m128 previousHigh = _mm_move_ss(_mm_shuffle_ps(yHigh, yHigh, _MM_SHUFFLE(2, 1, 0, 0)), _mm_shuffle_ps(yLow, yLow, _MM_SHUFFLE(3, 3, 3, 3)));
+			__m128 bandLow = _mm_sub_ps(yLow, previousLow), bandHigh = _mm_sub_ps(yHigh, previousHigh);
+			bandLow = _mm_mul_ps(bandLow, bandLow);
+			bandHigh = _mm_mul_ps(bandHigh, bandHigh);
+
+			__m128 rising = _mm_cmpgt_ps(bandLow, powerLow);
+			__m128 alpha = _mm_or_ps(_mm_and_ps(rising, attackV), _mm_andnot_ps(rising, releaseV));
+			powerLow = _mm_max_ps(_mm_add_ps(powerLow, _mm_mul_ps(alpha, _mm_sub_ps(bandLow, powerLow))), floorV);
+			rising = _mm_cmpgt_ps(bandHigh, powerHigh);
+			alpha = _mm_or_ps(_mm_and_ps(rising, attackV), _mm_andnot_ps(rising, releaseV));
+			powerHigh = _mm_max_ps(_mm_add_ps(powerHigh, _mm_mul_ps(alpha, _mm_sub_ps(bandHigh, powerHigh))), floorV);
+
+			weightsLow = _mm_add_ps(weightsLow, stepLow);
+			weightsHigh = _mm_add_ps(weightsHigh, stepHigh);
+			__m128 sum = _mm_add_ps(_mm_mul_ps(weightsLow, yLow), _mm_mul_ps(weightsHigh, yHigh));
+			sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+			sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+			_mm_store_ss(samples + n, sum);
+		}
+		weightsLow = targetLow;
+		weightsHigh = targetHigh;
+	}
+
+	_mm_storeu_ps(ear.z1, z1Low); _mm_storeu_ps(ear.z1 + 4, z1High);
+	_mm_storeu_ps(ear.z2, z2Low); _mm_storeu_ps(ear.z2 + 4, z2High);
+	_mm_storeu_ps(ear.power, powerLow); _mm_storeu_ps(ear.power + 4, powerHigh);
+	_mm_storeu_ps(ear.weights, weightsLow); _mm_storeu_ps(ear.weights + 4, weightsHigh);
+#else
+	ProcessEarScalar(ear, samples, size);
+#endif
+}
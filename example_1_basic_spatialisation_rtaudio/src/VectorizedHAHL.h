@@ -0,0 +1,103 @@
+/**
+*
+* \brief Declaration of VectorizedHAHL, a simplified hearing loss and hearing aid simulation computed with SSE2
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+
+#ifndef _VECTORIZEDHAHL_H_
+#define _VECTORIZEDHAHL_H_
+
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+#include <vector>
+
+#define VECTORIZED_HAHL_NUMBER_OF_BANDS		8				// Octave bands centred from 125 Hz to 16 kHz
+#define VECTORIZED_HAHL_FIRST_BAND_HZ		125.0f			// Centre of the first band. The others are one octave apart.
+#define VECTORIZED_HAHL_CALIBRATION_DBSPL	100.0f			// Level of a full scale sine, in dB SPL, as the default calibration of the toolkit
+#define VECTORIZED_HAHL_GAIN_INTERVAL		16				// Samples between two evaluations of the band gains, which are interpolated in between
+#define VECTORIZED_HAHL_ATTACK_MS			5.0f			// Time constants of the level detector of each band
+#define VECTORIZED_HAHL_RELEASE_MS			50.0f
+#define VECTORIZED_HAHL_RECRUITMENT_DBSPL	100.0f			// Level from which the hearing loss does not attenuate and the hearing aid does not amplify
+#define VECTORIZED_HAHL_AID_KNEE_DBSPL		40.0f			// Level below which the hearing aid applies its whole gain
+#define VECTORIZED_HAHL_AID_GAIN_FACTOR		0.5f			// Gain of the hearing aid for soft sounds, as a fraction of the hearing loss (half gain rule)
+
+/** \details Same idea as the hearing loss and hearing aid simulators of the toolkit (HAHLSimulation), reduced to what can run on every
+*			 block of the mix at a small cost. It is not the model of the toolkit and does not give the same output. Each ear is split
+*			 into octave bands by seven second order lowpass filters at the band edges: band k is the difference between lowpass k and
+*			 lowpass k - 1, so the bands add up exactly to the input. The level of each band drives a downward expander that attenuates
+*			 soft sounds by the hearing loss of the band and leaves sounds of VECTORIZED_HAHL_RECRUITMENT_DBSPL untouched, which models
+*			 loudness recruitment. The optional hearing aid amplifies soft sounds by half the loss, compressing that gain away towards
+*			 loud sounds, before the loss is applied.
+*			 The eight lowpass outputs of an ear (the eighth "filter" is the input itself) fill two SSE registers, so the filters, the
+*			 level detectors and the gains of all the bands are computed together on every sample. The gains are evaluated every
+*			 VECTORIZED_HAHL_GAIN_INTERVAL samples, with fast polynomial log2 and exp2, and interpolated linearly in between.
+*/
+class VectorizedHAHL
+{
+public:
+	/** \param [in] sampleRate sample rate, in Hz
+	*/
+	VectorizedHAHL(int sampleRate);
+
+	/** \brief Sets the audiogram of one or both ears. Not to be called while Process is running.
+	*	\param [in] ear LEFT, RIGHT or BOTH
+	*	\param [in] hearingLevels hearing loss of each band, in dB HL, from 125 Hz to 16 kHz. Missing bands take the last value.
+	*/
+	void SetHearingLoss(Common::T_ear ear, const std::vector<float> & hearingLevels);
+
+	/** \brief Enables or disables the hearing aid, fitted to the audiogram of each ear. Not to be called while Process is running.
+	*/
+	void SetHearingAid(bool enabled);
+
+	/** \brief Chooses between the SSE2 implementation and the scalar one, kept as a reference. Not to be called while Process is running.
+	*	\details Without SSE2 support at compile time the scalar implementation is always used.
+	*/
+	void SetVectorized(bool vectorized);
+
+	/** \brief Applies the simulation to one block of the binaural mix, in place
+	*/
+	void Process(Common::CEarPair<CMonoBuffer<float>> & buffer);
+
+	bool IsVectorized() const;
+
+private:
+	/** \brief State of the filters, level detectors and gains of the bands of one ear, one lane per band
+	*/
+	struct TEarState
+	{
+		float z1[VECTORIZED_HAHL_NUMBER_OF_BANDS];			// Transposed direct form II state of the lowpass filters
+		float z2[VECTORIZED_HAHL_NUMBER_OF_BANDS];
+		float power[VECTORIZED_HAHL_NUMBER_OF_BANDS];		// Smoothed power of each band
+		float weights[VECTORIZED_HAHL_NUMBER_OF_BANDS];		// Gain of band k minus gain of band k + 1, applied to lowpass k
+		float loss[VECTORIZED_HAHL_NUMBER_OF_BANDS];		// Audiogram, in dB HL
+		float aidGain[VECTORIZED_HAHL_NUMBER_OF_BANDS];		// Gain of the hearing aid for soft sounds, in dB
+	};
+
+	void ProcessEarScalar(TEarState & ear, float * samples, int size);
+	void ProcessEarSSE2(TEarState & ear, float * samples, int size);
+
+	float b0[VECTORIZED_HAHL_NUMBER_OF_BANDS], b1[VECTORIZED_HAHL_NUMBER_OF_BANDS], b2[VECTORIZED_HAHL_NUMBER_OF_BANDS];	// Lowpass coefficients, shared by both ears
+	float a1[VECTORIZED_HAHL_NUMBER_OF_BANDS], a2[VECTORIZED_HAHL_NUMBER_OF_BANDS];
+	float attack;											// Smoothing coefficients of the level detectors
+	float release;
+	TEarState ears[2];
+	bool hearingAid;
+	bool vectorized;
+};
+
+#endif
@@ -0,0 +1,245 @@
+/**
+*
+* \brief Implementation of VirtualAmbisonicReverb, a low-latency virtual Ambisonic reverb using non-uniform partitioned convolution
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "VirtualAmbisonicReverb.h"
+#include <algorithm>
+#include <cmath>
+
+#define W_CHANNEL_GAIN						0.7071f		// Gain of the omnidirectional channel, in both encoding and ABIR
+#define REVERB_ATTENUATION_DB_PER_DOUBLING	-3.01f		// Distance attenuation of the reverb of a source
+#define REVERB_REFERENCE_DISTANCE			1.0f		// Distance without attenuation, in meters
+#define REVERB_MINIMUM_DISTANCE				0.1f		// Closer sources are attenuated as if they were at this distance
+
+VirtualAmbisonicReverb::VirtualAmbisonicReverb(int blockSize, TReverberationOrder order, int tailPartitionFactor, SpectrumStorage::TPrecision precision)
+	: blockSize{ blockSize }, order{ order }, tailPartitionFactor{ tailPartitionFactor }, precision{ precision }, threadPool{ nullptr }, ready{ false }, tailPending{ false }, stopping{ false }, lateTails{ 0 }
+{
+}
+
+VirtualAmbisonicReverb::~VirtualAmbisonicReverb()
+{
+	{
+		std::lock_guard<std::mutex> lock(tailMutex);
+		stopping = true;
+	}
+	tailWakeUp.notify_all();
+	if (tailThread.joinable()) tailThread.join();
+}
+
+bool VirtualAmbisonicReverb::Setup(Binaural::CBRIR & brir)
+{
+	std::vector<VirtualSpeakerPosition> speakers = { NORTH, SOUTH, EAST, WEST };
+	if (order == TReverberationOrder::THREEDIMENSIONAL)
+	{
+		speakers.push_back(ZENIT);
+		speakers.push_back(NADIR);
+	}
+
+	size_t length = 0;
+	for (size_t s = 0; s < speakers.size(); s++)
+	{
+		const TImpulseResponse & left = brir.GetBRIR(speakers[s], Common::T_ear::LEFT);
+		const TImpulseResponse & right = brir.GetBRIR(speakers[s], Common::T_ear::RIGHT);
+		if (left.empty() || right.empty()) return false;
+		length = std::max(length, std::max(left.size(), right.size()));
+	}
+
+	// ABIRs: the BRIR of each virtual speaker weighted by the decoding gain of the channel for that speaker
+	int numberOfChannels = GetNumberOfChannels();
+	std::vector<std::vector<std::vector<float>>> abirs(numberOfChannels, std::vector<std::vector<float>>(2, std::vector<float>(length, 0.0f)));
+	Common::T_ear ears[2] = { Common::T_ear::LEFT, Common::T_ear::RIGHT };
+	for (int ear = 0; ear < 2; ear++)
+	{
+		for (size_t s = 0; s < speakers.size(); s++)
+		{
+			const TImpulseResponse & speakerBRIR = brir.GetBRIR(speakers[s], ears[ear]);
+			float gains[4] = { W_CHANNEL_GAIN, 0.0f, 0.0f, 0.0f };		// W, X (front), Y (left) and Z (up)
+			switch (speakers[s])
+			{
+			case NORTH: gains[1] = 1.0f;	break;
+			case SOUTH: gains[1] = -1.0f;	break;
+			case WEST:	gains[2] = 1.0f;	break;
+			case EAST:	gains[2] = -1.0f;	break;
+			case ZENIT: gains[3] = 1.0f;	break;
+			case NADIR: gains[3] = -1.0f;	break;
+			default:						break;
+			}
+			for (int channel = 0; channel < numberOfChannels; channel++)
+			{
+				if (gains[channel] == 0.0f) continue;
+				std::vector<float> & abir = abirs[channel][ear];
+				for (size_t n = 0; n < speakerBRIR.size(); n++)
+					abir[n] += gains[channel] * speakerBRIR[n];
+			}
+		}
+	}
+
+	channelConvolvers.clear();
+	for (int channel = 0; channel < numberOfChannels; channel++)
+	{
+		channelConvolvers.push_back(NonUniformConvolver(blockSize, tailPartitionFactor, precision));
+		channelConvolvers.back().Setup(abirs[channel]);
+	}
+	channelBuffers.assign(numberOfChannels, std::vector<float>(blockSize, 0.0f));
+	channelOutputs.assign(2 * numberOfChannels, std::vector<float>(blockSize, 0.0f));
+	channelTailFrameComplete.assign(numberOfChannels, 0);
+
+	tailThread = std::thread(&VirtualAmbisonicReverb::TailWorker, this);
+	ready = true;
+	return true;
+}
+
+void VirtualAmbisonicReverb::SetThreadPool(ThreadPool * pool)
+{
+	threadPool = pool;
+}
+
+void VirtualAmbisonicReverb::Process(const std::vector<TSourceInput> & sources, const Common::CTransform & listenerTransform, CMonoBuffer<float> & outputLeft, CMonoBuffer<float> & outputRight)
+{
+	outputLeft.assign(blockSize, 0.0f);
+	outputRight.assign(blockSize, 0.0f);
+	if (!ready) return;
+
+	// Encoding gains of the sources, shared by all the channels
+	if (sourceGains.size() < 4 * sources.size()) sourceGains.resize(4 * sources.size());	// Only allocates when sources are added
+	for (size_t s = 0; s < sources.size(); s++)
+	{
+		Common::CVector3 direction = listenerTransform.GetVectorTo(sources[s].sourceTransform);		// In the coordinates of the listener
+		float distance = direction.GetDistance();
+		float attenuation = std::pow(10.0f, REVERB_ATTENUATION_DB_PER_DOUBLING * std::log2(std::max(distance, REVERB_MINIMUM_DISTANCE) / REVERB_REFERENCE_DISTANCE) / 20.0f);
+		float * gains = &sourceGains[4 * s];
+		gains[0] = W_CHANNEL_GAIN * attenuation;
+		gains[1] = gains[2] = gains[3] = 0.0f;
+		if (distance > 0.0f)
+		{
+			// Azimuth and elevation, rather than the coordinates, keep the encoding independent of the axis convention of the toolkit
+			float azimuth = direction.GetAzimuthRadians();
+			float elevation = direction.GetElevationRadians();
+			gains[1] = attenuation * std::cos(azimuth) * std::cos(elevation);		// Front
+			gains[2] = attenuation * std::sin(azimuth) * std::cos(elevation);		// Left
+			gains[3] = attenuation * std::sin(elevation);							// Up
+		}
+	}
+
+	// Encoding each channel and convolving it with its ABIRs. All the convolvers complete their tail frames in the same block.
+	bool tailFrameComplete = false;
+	if (threadPool != nullptr && channelConvolvers.size() > 1)
+	{
+		// Each job writes into its own output, so the jobs do not share anything but the read-only inputs
+		threadPool->ParallelFor((unsigned int)channelConvolvers.size(), [this, &sources](unsigned int channel) {
+			float * outputs[2] = { channelOutputs[2 * channel].data(), channelOutputs[2 * channel + 1].data() };
+			std::fill(outputs[0], outputs[0] + blockSize, 0.0f);
+			std::fill(outputs[1], outputs[1] + blockSize, 0.0f);
+			channelTailFrameComplete[channel] = ProcessChannel(channel, sources, outputs);
+		});
+		for (size_t channel = 0; channel < channelConvolvers.size(); channel++)
+		{
+			const float * left = channelOutputs[2 * channel].data();
+			const float * right = channelOutputs[2 * channel + 1].data();
+			for (int n = 0; n < blockSize; n++)
+			{
+				outputLeft[n] += left[n];
+				outputRight[n] += right[n];
+			}
+			tailFrameComplete = channelTailFrameComplete[channel] || tailFrameComplete;
+		}
+	}
+	else
+	{
+		float * outputs[2] = { outputLeft.data(), outputRight.data() };
+		for (size_t channel = 0; channel < channelConvolvers.size(); channel++)
+			tailFrameComplete = ProcessChannel(channel, sources, outputs) || tailFrameComplete;
+	}
+
+	if (tailFrameComplete)
+	{
+		// The background thread has had a whole tail partition to convolve the previous frame, so it is normally done. If it is not,
+		// the frame is dropped rather than waited for, and the tail is silent for two tail partitions.
+		std::unique_lock<std::mutex> lock(tailMutex);
+		if (tailPending)
+		{
+			lateTails++;
+			for (size_t channel = 0; channel < channelConvolvers.size(); channel++)
+				channelConvolvers[channel].SkipTailFrame();
+			return;
+		}
+		for (size_t channel = 0; channel < channelConvolvers.size(); channel++)
+			channelConvolvers[channel].ExchangeTailFrame();
+		tailPending = true;
+		lock.unlock();
+		tailWakeUp.notify_one();
+	}
+}
+
+bool VirtualAmbisonicReverb::ProcessChannel(size_t channel, const std::vector<TSourceInput> & sources, float * const * outputs)
+{
+	float * channelBuffer = channelBuffers[channel].data();
+	std::fill(channelBuffer, channelBuffer + blockSize, 0.0f);
+	for (size_t s = 0; s < sources.size(); s++)
+	{
+		const CMonoBuffer<float> & input = *sources[s].buffer;
+		if ((int)input.size() < blockSize) continue;
+		float gain = sourceGains[4 * s + channel];
+		for (int n = 0; n < blockSize; n++)
+			channelBuffer[n] += gain * input[n];
+	}
+	return channelConvolvers[channel].Process(channelBuffer, outputs);
+}
+
+void VirtualAmbisonicReverb::TailWorker()
+{
+	std::unique_lock<std::mutex> lock(tailMutex);
+	while (true)
+	{
+		tailWakeUp.wait(lock, [this]() { return tailPending || stopping; });
+		if (stopping) return;
+
+		lock.unlock();
+		for (size_t channel = 0; channel < channelConvolvers.size(); channel++)
+			channelConvolvers[channel].ProcessTail();
+		lock.lock();
+
+		tailPending = false;
+	}
+}
+
+unsigned int VirtualAmbisonicReverb::GetNumberOfLateTails()
+{
+	std::lock_guard<std::mutex> lock(tailMutex);
+	return lateTails;
+}
+
+int VirtualAmbisonicReverb::GetBlockSize() const
+{
+	return blockSize;
+}
+
+int VirtualAmbisonicReverb::GetNumberOfChannels() const
+{
+	return order == TReverberationOrder::ADIMENSIONAL ? 1 : (order == TReverberationOrder::BIDIMENSIONAL ? 3 : 4);
+}
+
+size_t VirtualAmbisonicReverb::GetFilterSizeInBytes() const
+{
+	size_t size = 0;
+	for (size_t channel = 0; channel < channelConvolvers.size(); channel++)
+		size += channelConvolvers[channel].GetFilterSizeInBytes();
+	return size;
+}
@@ -0,0 +1,121 @@
+/**
+*
+* \brief Declaration of VirtualAmbisonicReverb, a low-latency virtual Ambisonic reverb using non-uniform partitioned convolution
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _VIRTUALAMBISONICREVERB_H_
+#define _VIRTUALAMBISONICREVERB_H_
+
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+#include "PartitionedConvolver.h"
+#include "ThreadPool.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** \details Same processing as CEnvironment::ProcessVirtualAmbisonicReverb: the sources are encoded into the W, X, Y (and Z) Ambisonic channels,
+*			 and each channel is convolved with its Ambisonic BRIR (ABIR) for each ear, obtained from the BRIRs of the virtual speakers.
+*			 The convolution uses NonUniformConvolver, so the block size can be small without shortening the BRIR. The tail partitions of
+*			 all the channels are convolved in a background thread owned by the reverb, which the audio thread never waits for: a tail
+*			 frame that is not ready in time is dropped (see NonUniformConvolver::SkipTailFrame). Optionally, the encoding and the head convolution
+*			 of each channel can be spread over the threads of a ThreadPool, joined at the end of every block.
+*/
+class VirtualAmbisonicReverb
+{
+public:
+	/** \brief Input of one source to the reverb
+	*/
+	struct TSourceInput
+	{
+		const CMonoBuffer<float> * buffer;								// blockSize samples of the source
+		Common::CTransform sourceTransform;								// Position of the source
+	};
+
+	/** \param [in] blockSize number of samples of each call to Process. Must be a power of two.
+	*	\param [in] order number of Ambisonic channels: W (ADIMENSIONAL), W, X and Y (BIDIMENSIONAL) or W, X, Y and Z (THREEDIMENSIONAL)
+	*	\param [in] tailPartitionFactor size of the tail partitions, in blocks. Must be a power of two.
+	*	\param [in] precision format the spectra of the ABIRs are stored in
+	*/
+	VirtualAmbisonicReverb(int blockSize, TReverberationOrder order, int tailPartitionFactor = 8, SpectrumStorage::TPrecision precision = SpectrumStorage::FLOAT32);
+
+	/** \brief Stops the background thread
+	*/
+	~VirtualAmbisonicReverb();
+
+	/** \brief Builds the ABIRs from the BRIRs of the virtual speakers and starts the background thread. To be called once, not from the audio thread.
+	*	\param [in] brir BRIR loaded into an environment, for example with BRIR::CreateFromSofa
+	*	\retval false if some of the BRIRs needed by the reverberation order is empty
+	*/
+	bool Setup(Binaural::CBRIR & brir);
+
+	/** \brief Processes each Ambisonic channel as a job of a thread pool, or all of them in the calling thread. Not to be called while Process is running.
+	*	\details The thread pool is only worth it with several channels and enough CPU cores for them, as the threads are woken up in every block.
+	*	\param [in] pool thread pool used by Process, or nullptr to process the channels serially (default). It must outlive the reverb.
+	*/
+	void SetThreadPool(ThreadPool * pool);
+
+	/** \brief Encodes the sources, convolves the Ambisonic channels and writes the reverb into the output. To be called from the audio thread.
+	*	\param [in] sources input buffer and position of each source
+	*	\param [in] listenerTransform position and orientation of the listener
+	*	\param [out] outputLeft blockSize samples of the left ear
+	*	\param [out] outputRight blockSize samples of the right ear
+	*/
+	void Process(const std::vector<TSourceInput> & sources, const Common::CTransform & listenerTransform, CMonoBuffer<float> & outputLeft, CMonoBuffer<float> & outputRight);
+
+	/** \brief Returns the number of tail frames dropped because the background thread had not finished the previous one
+	*	\details The reverb tail is silent for two tail partitions, 2 * tailPartitionFactor blocks, after each of them
+	*/
+	unsigned int GetNumberOfLateTails();
+
+	int GetBlockSize() const;
+
+	/** \brief Returns the number of Ambisonic channels of the reverberation order, which is the number of jobs of each block in parallel mode
+	*/
+	int GetNumberOfChannels() const;
+
+	/** \brief Returns the memory used by the spectra of the ABIRs, in bytes
+	*/
+	size_t GetFilterSizeInBytes() const;
+
+private:
+	bool ProcessChannel(size_t channel, const std::vector<TSourceInput> & sources, float * const * outputs);
+	void TailWorker();
+
+	int blockSize;
+	TReverberationOrder order;
+	int tailPartitionFactor;
+	SpectrumStorage::TPrecision precision;
+	std::vector<NonUniformConvolver> channelConvolvers;				// One per Ambisonic channel, with the left and right ABIRs
+	std::vector<std::vector<float>> channelBuffers;					// Encoded input of each Ambisonic channel
+	std::vector<std::vector<float>> channelOutputs;					// Left and right output of each channel in parallel mode, mixed after the join
+	std::vector<char> channelTailFrameComplete;						// Value returned by the convolver of each channel in the current block
+	std::vector<float> sourceGains;									// W, X, Y and Z gains of each source in the current block
+	ThreadPool * threadPool;										// Pool processing the channels, nullptr for serial processing
+	bool ready;														// True once Setup has succeeded
+
+	std::thread tailThread;
+	std::mutex tailMutex;
+	std::condition_variable tailWakeUp;								// Signalled when a tail frame has been exchanged
+	bool tailPending;												// A tail frame has been exchanged and is not convolved yet
+	bool stopping;
+	unsigned int lateTails;
+};
+
+#endif
@@ -29,6 +29,7 @@
 static double iSampleRate;
 int iBufferSize;
 bool bEnableReverb;
+std::atomic<bool> bReverbReady(false);		// Set when the BRIR has been loaded, as the stream may start before
 int main()
 {
 	///////////////////////////////////////////////////////////////////////////////////////////////
@@ -104,21 +105,11 @@ int main()
 	listenerPosition.SetPosition(Common::CVector3(0, 0, 0));
 	listener->SetListenerTransform(listenerPosition);
 	listener->DisableCustomizedITD();												// Disabling custom head radius
-	///////////////////////////////////////////////////////////////////////////////////////////////
-	//	HRTF can be loaded in either SOFA (more info in https://sofacoustics.org/) or 3dti-hrtf format.
-	//	These HRTF files are provided with 3DTI Audio Toolkit. They can be found in 3dti_AudioToolkit/resources/HRTF 
-	//	Comment the following line and uncomment next two lines to load the default HRTF in 3dti-hrtf format instead of in SOFA format
-	//HRTF::CreateFrom3dti("hrtf.3dti-hrtf", listener);								
-	bool specifiedDelays;
-	HRTF::CreateFromSofa("hrtf.sofa", listener, specifiedDelays);	
-	///////////////////////////////////////////////////////////////////////////////////////////////
 	// Environment setup
 	environment = myCore.CreateEnvironment();											// Creating environment to have reverberated sound
 	environment->SetReverberationOrder(TReverberationOrder::BIDIMENSIONAL);				// Setting number of ambisonic channels to use in reverberation processing
-	BRIR::CreateFromSofa("brir.sofa", environment);										// Loading SOFAcoustics BRIR file and applying it to the environment
 	// Speech source setup
 	sourceSpeech = myCore.CreateSingleSourceDSP();										 // Creating audio source
-	LoadWav(samplesVectorSpeech, "speech.wav");											 // Loading .wav file
 	Common::CTransform sourceSpeechPosition = Common::CTransform();
 	sourceSpeechPosition.SetPosition(Common::CVector3(0, 2, 0));						 // Setting source in x=0,y=2,z=0 (on the left)
 	sourceSpeech->SetSourceTransform(sourceSpeechPosition);
@@ -129,7 +120,6 @@ int main()
 	sourceSpeech->EnableDistanceAttenuationReverb();
 	// Steps source setup
 	sourceSteps = myCore.CreateSingleSourceDSP();										 // Creating audio source
-	LoadWav(samplesVectorSteps, "steps.wav");											   // Loading .wav file
 	Common::CTransform sourceStepsPosition = Common::CTransform();
 	t = 0;
 	//sourceStepsPosition.SetPosition(Common::CVector3(-3, 10, -10));						 // Setting source in position
@@ -144,27 +134,59 @@ int main()
 	// Declaration and initialization of stereo buffer
 	outputBufferStereo.left.resize(iBufferSize);
 	outputBufferStereo.right.resize(iBufferSize);
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	//	Loading of resources. HRTF, BRIR and wav files do not depend on each other, so each one is loaded in its own thread
+	//	while the stream is opened in this one. The HRTF and BRIR SOFA files are parsed one after the other, as the SOFA
+	//	libraries are not thread safe (see StartupPipeline::GetSofaMutex). The stream starts as soon as the HRTF and the wav
+	//	files are ready; the reverb is added to the mix later, when the BRIR has been loaded (see bReverbReady).
+	//
+	//	HRTF can be loaded in either SOFA (more info in https://sofacoustics.org/) or 3dti-hrtf format.
+	//	These HRTF files are provided with 3DTI Audio Toolkit. They can be found in 3dti_AudioToolkit/resources/HRTF 
+	//	The SOFA file is only parsed on the first run, later runs load the HRTF table from an on-disk cache (see HRTFCache.h)
+	//	Replace the call in the HRTF stage by HRTF::CreateFrom3dti("hrtf.3dti-hrtf", listener) to load the default HRTF in 3dti-hrtf format instead of in SOFA format
+	bool specifiedDelays;
+	StartupPipeline startup;															// Must be declared after everything its stages use, as its destructor waits for them
+	startup.LaunchStage("HRTF", true, [&]() { return HRTFCache::CreateFromSofa("hrtf.sofa", listener, specifiedDelays, myCore); });
+	if (bEnableReverb)																	// Loading SOFAcoustics BRIR file and applying it to the environment
+		startup.LaunchStage("BRIR", false, [&]() {
+			std::lock_guard<std::mutex> sofaLock(StartupPipeline::GetSofaMutex());		// The toolkit partitions the BRIR inside CreateFromSofa, so it is done under the lock too
+			return BRIR::CreateFromSofa("brir.sofa", environment);
+		}, [&]() { bReverbReady = true; });
+	startup.LaunchStage("speech.wav", true, [&]() { LoadWav(samplesVectorSpeech, "speech.wav"); return !samplesVectorSpeech.empty(); });	// Loading .wav files
+	startup.LaunchStage("steps.wav", true, [&]() { LoadWav(samplesVectorSteps, "steps.wav"); return !samplesVectorSteps.empty(); });
+	///////////////////////////////////////////////////////////////////////////////////////////////
 	// Opening of audio stream
 	unsigned int frameSize = iBufferSize;       // Declaring and initializing frame size variable because next statement needs it
 	outputParameters.hostApiSpecificStreamInfo = NULL;
-	err = Pa_OpenStream(
-		&stream,						// stream to be open
-		NULL,							// Unspecified input parameters because there will not be input stream
-		&outputParameters,				// Specified output parameters			                  
-		iSampleRate,			        // Sample rate will be 44.1 kHz, 48kHz...
-		frameSize,		                // Frame size will be iBufferSize samples
-		paClipOff,						// we won't output out of range samples so don't bother clipping them
-		&paCallback,					// Pointer to the function that will be called every time RtAudio needs the buffer to be filled
-		nullptr		                    // Unused pointer to get feedback
-		);
-	if (err != paNoError) {
+	bool streamOpened = startup.RunStage("Audio device", [&]() {
+		err = Pa_OpenStream(
+			&stream,						// stream to be open
+			NULL,							// Unspecified input parameters because there will not be input stream
+			&outputParameters,				// Specified output parameters			                  
+			iSampleRate,			        // Sample rate will be 44.1 kHz, 48kHz...
+			frameSize,		                // Frame size will be iBufferSize samples
+			paClipOff,						// we won't output out of range samples so don't bother clipping them
+			&paCallback,					// Pointer to the function that will be called every time RtAudio needs the buffer to be filled
+			nullptr		                    // Unused pointer to get feedback
+			);
+		return err == paNoError;
+	});
+	if (!streamOpened) {
 		cout << "\nERROR WITH PORTAUDIO WHILE STREAM IS BEING OPENED\t" << endl;
+		startup.WaitForAllStages();					// exit() does not run the destructor of startup, so the stages still running are joined here
 		exit(1);
 	}
 	// Informing user by the console to press any key to start the execution
 	cout << "\nPress ENTER to start\n";
 	cin.ignore();
+	// Waiting for the minimum set of resources needed to render audio
+	if (!startup.WaitForRequiredStages()) {
+		cout << "\nERROR: THE HRTF OR THE WAV FILES COULD NOT BE LOADED\t" << endl;
+		startup.WaitForAllStages();					// The BRIR may still be loading
+		exit(1);
+	}
 	Pa_StartStream(stream);
+	cout << "[startup] Audio started after " << startup.GetElapsedMilliseconds() << " ms" << endl;
 	// Informing user by the console to press any key to end the execution
 	cout << "\nPress ENTER to stop and exit...\n";
 	cin.ignore();
@@ -259,7 +281,7 @@ void audioProcess(Common::CEarPair<CMonoBuffer<float>> & bufferOutput, int uiBuf
 
 	// Reverberation processing of all sources
 	Common::CEarPair<CMonoBuffer<float>> bufferReverb;			// Declaration and initialization of separate buffer needed for the reverb
-	if (bEnableReverb) {
+	if (bEnableReverb && bReverbReady) {
 		environment->ProcessVirtualAmbisonicReverb(bufferReverb.left, bufferReverb.right);
 		bufferOutput.left += bufferReverb.left;					// Adding reverberated sound to the output mix
 		bufferOutput.right += bufferReverb.right;
@@ -24,12 +24,15 @@
 
 #include <cstdio>
 #include <cstring>
+#include <atomic>
 #include <HRTF/HRTFFactory.h>
 #include <HRTF/HRTFCereal.h>
 #include <BRIR/BRIRFactory.h>
 #include <BRIR/BRIRCereal.h>
 #include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
 #include "../../third_party_libraries/portaudio/include/portaudio.h"
+#include "HRTFCache.h"
+#include "StartupPipeline.h"
 
 PaStream *								stream;					
 Binaural::CCore							myCore;												 // Core interface
@@ -0,0 +1,136 @@
+/**
+*
+* \brief Implementation of HRTFHotSwap, which replaces the HRTF of a running spatialisation without glitches
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "HRTFHotSwap.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+HRTFHotSwap::HRTFHotSwap(std::unique_ptr<SpatialisationSession> initialSession)
+	: currentSession{ std::move(initialSession) }, pendingSession{ nullptr }, retiredSession{ nullptr }, warmingSession{ nullptr }, warmupBlocksLeft{ 0 },
+	  swapInProgress{ false }
+{
+	audioState = currentSession->GetAudioState();
+	resamplingStep = currentSession->GetResamplingStep();
+	numberOfSources = currentSession->GetNumberOfSources();
+
+	// Allocated here so that the crossfade does not allocate memory in the audio thread
+	bufferFadeIn.left.resize(audioState.bufferSize);
+	bufferFadeIn.right.resize(audioState.bufferSize);
+	bufferFadeOut.left.resize(audioState.bufferSize);
+	bufferFadeOut.right.resize(audioState.bufferSize);
+}
+
+HRTFHotSwap::~HRTFHotSwap()
+{
+	if (loader.joinable()) loader.join();
+	delete pendingSession.exchange(nullptr);
+	delete warmingSession;
+	delete retiredSession.exchange(nullptr);
+}
+
+bool HRTFHotSwap::RequestSwap(const std::string & hrtfFileName)
+{
+	if (swapInProgress) return false;
+	if (loader.joinable()) loader.join();			// The previous loader has already finished, as its swap is over
+
+	swapInProgress = true;
+	requestedHRTFFileName = hrtfFileName;
+	loader = std::thread(&HRTFHotSwap::LoadSession, this, hrtfFileName);
+	return true;
+}
+
+void HRTFHotSwap::LoadSession(std::string hrtfFileName)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::unique_ptr<SpatialisationSession> newSession(new SpatialisationSession(audioState, resamplingStep));
+	for (size_t i = 0; i < numberOfSources; i++)
+		newSession->AddSource(Common::CTransform());	// Transforms are copied from the current session when the swap takes place
+	if (!newSession->LoadHRTF(hrtfFileName)) {
+		cout << "ERROR: Error trying to load the HRTF file " << hrtfFileName << ", the current HRTF is kept" << endl << endl;
+		swapInProgress = false;
+		return;
+	}
+
+	double loadTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	cout << "HRTF " << hrtfFileName << " loaded in background in " << loadTime << " ms" << endl;
+	newSession->WriteMemoryReport(cout);
+	pendingSession = newSession.release();				// Published, the audio thread takes it at the next block
+}
+
+void HRTFHotSwap::Process(const std::vector<CMonoBuffer<float>> & inputs, Common::CEarPair<CMonoBuffer<float>> & bufferOutput)
+{
+	if (warmingSession == nullptr) {
+		warmingSession = pendingSession.exchange(nullptr);
+		if (warmingSession != nullptr)					// One block per partition of the HRIRs, so that all of them hold real input
+			warmupBlocksLeft = (warmingSession->GetHRIRLength() + audioState.bufferSize - 1) / audioState.bufferSize;
+	}
+	if (warmingSession == nullptr) {
+		currentSession->Process(inputs, bufferOutput);
+		return;
+	}
+
+	// The new session starts with an empty convolution history, so its output is discarded until the history is full
+	warmingSession->CopyTransformsFrom(*currentSession);
+	std::fill(bufferFadeIn.left.begin(), bufferFadeIn.left.end(), 0.0f);
+	std::fill(bufferFadeIn.right.begin(), bufferFadeIn.right.end(), 0.0f);
+	warmingSession->Process(inputs, bufferFadeIn);
+	if (warmupBlocksLeft > 0) {
+		warmupBlocksLeft--;
+		currentSession->Process(inputs, bufferOutput);
+		return;
+	}
+
+	// Swapping at the block boundary: this block is crossfaded from the old session to the new one
+	std::fill(bufferFadeOut.left.begin(), bufferFadeOut.left.end(), 0.0f);
+	std::fill(bufferFadeOut.right.begin(), bufferFadeOut.right.end(), 0.0f);
+	currentSession->Process(inputs, bufferFadeOut);
+
+	size_t blockSize = std::min(bufferOutput.left.size(), bufferFadeIn.left.size());
+	for (size_t i = 0; i < blockSize; i++)
+	{
+		float gainIn = float(i + 1) / float(blockSize);		// Linear crossfade, as both sessions render the same signals
+		bufferOutput.left[i] += gainIn * bufferFadeIn.left[i] + (1.0f - gainIn) * bufferFadeOut.left[i];
+		bufferOutput.right[i] += gainIn * bufferFadeIn.right[i] + (1.0f - gainIn) * bufferFadeOut.right[i];
+	}
+
+	// The replaced session is not destroyed here, as freeing a core would block the audio thread
+	retiredSession = currentSession.release();
+	currentSession.reset(warmingSession);
+	warmingSession = nullptr;
+}
+
+bool HRTFHotSwap::ReclaimRetiredSession()
+{
+	SpatialisationSession * oldSession = retiredSession.exchange(nullptr);
+	if (oldSession == nullptr) return false;
+
+	delete oldSession;
+	cout << "HRTF changed to " << requestedHRTFFileName << endl;
+	swapInProgress = false;
+	return true;
+}
+
+bool HRTFHotSwap::IsSwapInProgress() const
+{
+	return swapInProgress;
+}
@@ -0,0 +1,87 @@
+/**
+*
+* \brief Declaration of HRTFHotSwap, which replaces the HRTF of a running spatialisation without glitches
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#pragma once
+
+#include "SpatialisationSession.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/** \details Loading an HRTF into a listener modifies tables the audio thread is reading, so the HRTF is never changed in place.
+*			 Instead, a new session with the same sources is created and loaded in a background thread. The audio thread picks it up
+*			 at the start of a block and renders both sessions, keeping the output of the old one, until the convolution history of
+*			 the new one covers the length of its HRIRs. The next block is crossfaded from the old output to the new one, and the
+*			 old session is then handed back to be destroyed outside the audio thread.
+*/
+class HRTFHotSwap {
+
+public:
+
+	/** \brief Takes ownership of the session used until the first swap
+	*	\param [in] initialSession session with its sources created. Its HRTF may still be loading, but it must be loaded before Process is called.
+	*/
+	HRTFHotSwap(std::unique_ptr<SpatialisationSession> initialSession);
+
+	/** \brief Waits for the background load, if any. The audio thread must not be calling Process anymore.
+	*/
+	~HRTFHotSwap();
+
+	/** \brief Starts loading a new HRTF in a background thread. To be called from the main thread.
+	*	\param [in] hrtfFileName name of the HRTF file, in SOFA or 3dti-hrtf format
+	*	\retval false if the previous swap has not finished yet
+	*/
+	bool RequestSwap(const std::string & hrtfFileName);
+
+	/** \brief Spatialises one buffer of each source. To be called from the audio thread.
+	*	\param [in] inputs one mono buffer per source
+	*	\param [in,out] bufferOutput stereo mix the processed sources are added to
+	*/
+	void Process(const std::vector<CMonoBuffer<float>> & inputs, Common::CEarPair<CMonoBuffer<float>> & bufferOutput);
+
+	/** \brief Destroys the session replaced by the last swap, if any, which finishes that swap. To be called from the main thread, e.g. in update().
+	*	\retval true if a swap has finished, so the HRTF requested by the last RequestSwap is now in use
+	*/
+	bool ReclaimRetiredSession();
+
+	/** \brief Returns true from RequestSwap until the replaced session has been reclaimed
+	*/
+	bool IsSwapInProgress() const;
+
+private:
+
+	void LoadSession(std::string hrtfFileName);
+
+	std::unique_ptr<SpatialisationSession>	currentSession;		// Session rendering the audio, only used by the audio thread after construction
+	std::atomic<SpatialisationSession *>	pendingSession;		// Session loaded in background, waiting for the next block boundary
+	std::atomic<SpatialisationSession *>	retiredSession;		// Session replaced in the last swap, waiting to be destroyed
+	SpatialisationSession *					warmingSession;		// Session taken by the audio thread, filling its convolution history
+	int										warmupBlocksLeft;	// Blocks warmingSession still has to render before the crossfade
+	std::atomic<bool>						swapInProgress;
+	std::thread								loader;				// Background thread creating the new session
+	std::string								requestedHRTFFileName;	// HRTF of the swap in progress, only used by the main thread
+
+	Common::TAudioStateStruct				audioState;			// Configuration copied into every new session
+	int										resamplingStep;
+	size_t									numberOfSources;
+	Common::CEarPair<CMonoBuffer<float>>	bufferFadeIn;		// Output of the new session during the crossfade
+	Common::CEarPair<CMonoBuffer<float>>	bufferFadeOut;		// Output of the replaced session during the crossfade
+};
@@ -0,0 +1,149 @@
+/**
+*
+* \brief Implementation of SpatialisationSession, which groups a core, its listener and the source DSPs using one HRTF
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "SpatialisationSession.h"
+#include <HRTF/HRTFFactory.h>
+#include <HRTF/HRTFCereal.h>
+
+SpatialisationSession::SpatialisationSession(Common::TAudioStateStruct audioState, int resamplingStep)
+	: rawTableSize{ 0 }, resampledDirections{ 0 }, partitionedTableSize{ 0 }
+{
+	core.SetAudioState(audioState);								// Applying configuration to core
+	core.SetHRTFResamplingStep(resamplingStep);					// Setting resampling step for HRTF
+
+	listener = core.CreateListener();							// First step is creating listener
+	Common::CTransform listenerPosition = Common::CTransform();	// Setting listener in (0,0,0)
+	listenerPosition.SetPosition(Common::CVector3(0, 0, 0));
+	listener->SetListenerTransform(listenerPosition);
+	listener->DisableCustomizedITD();							// Disabling custom head radius
+}
+
+bool SpatialisationSession::LoadHRTF(const std::string & fileName)
+{
+	const std::string sofaExtension = ".sofa";
+	bool isSofa = fileName.size() >= sofaExtension.size() &&
+				  fileName.compare(fileName.size() - sofaExtension.size(), sofaExtension.size(), sofaExtension) == 0;
+	bool loadResult;
+	if (isSofa) {
+		bool specifiedDelays;
+		loadResult = HRTF::CreateFromSofa(fileName, listener, specifiedDelays);
+	}
+	else {
+		loadResult = HRTF::CreateFrom3dti(fileName, listener);
+	}
+	if (!loadResult) return false;
+	hrtfFileName = fileName;
+
+	Binaural::CHRTF * hrtf = listener->GetHRTF();
+	rawTableSize = 0;
+	const T_HRTFTable & rawTable = hrtf->GetRawHRTFTable();
+	for (auto it = rawTable.begin(); it != rawTable.end(); it++)
+		rawTableSize += (it->second.leftHRIR.size() + it->second.rightHRIR.size()) * sizeof(float);
+
+	// The toolkit resamples the HRTF to a grid of the resampling step, with elevations from 0 up to 90 degrees and from 360 down to
+	// 270 degrees below the horizon, and keeps each direction as the spectra of the partitions of both ears plus their delays.
+	// The partitions the HRTF returns for each direction of the grid are added up, so their sizes are measured, not assumed.
+	int step = GetResamplingStep();
+	Common::T_ear ears[] = { Common::T_ear::LEFT, Common::T_ear::RIGHT };
+	resampledDirections = 0;
+	partitionedTableSize = 0;
+	for (int azimuth = 0; azimuth < 360; azimuth += step)
+	{
+		for (int k = -(90 / step); k <= 90 / step; k++)
+		{
+			float elevation = (float)(k < 0 ? 360 + k * step : k * step);
+			for (Common::T_ear ear : ears)
+			{
+				std::vector<CMonoBuffer<float>> partitions = hrtf->GetHRIR_partitioned(ear, (float)azimuth, elevation, false);
+				for (const CMonoBuffer<float> & partition : partitions) partitionedTableSize += partition.size() * sizeof(float);
+				partitionedTableSize += sizeof(uint64_t);			// Delay of the ear
+			}
+			resampledDirections++;
+		}
+	}
+	return true;
+}
+
+void SpatialisationSession::AddSource(const Common::CTransform & sourceTransform)
+{
+	shared_ptr<Binaural::CSingleSourceDSP> source = core.CreateSingleSourceDSP();	// Creating audio source
+	source->SetSourceTransform(sourceTransform);
+	source->SetSpatializationMode(Binaural::TSpatializationMode::HighQuality);		// Choosing high quality mode for anechoic processing
+	source->DisableNearFieldEffect();												// Audio source will not be close to listener, so we don't need near field effect
+	source->EnableAnechoicProcess();												// Enable anechoic processing for this source
+	source->EnableDistanceAttenuationAnechoic();									// Perform distance simulation
+	sources.push_back(source);
+}
+
+void SpatialisationSession::CopyTransformsFrom(SpatialisationSession & other)
+{
+	listener->SetListenerTransform(other.listener->GetListenerTransform());
+	for (size_t i = 0; i < sources.size() && i < other.sources.size(); i++)
+		sources[i]->SetSourceTransform(other.sources[i]->GetSourceTransform());
+}
+
+void SpatialisationSession::Process(const std::vector<CMonoBuffer<float>> & inputs, Common::CEarPair<CMonoBuffer<float>> & bufferOutput)
+{
+	for (size_t i = 0; i < sources.size() && i < inputs.size(); i++)
+	{
+		sources[i]->SetBuffer(inputs[i]);
+		sources[i]->ProcessAnechoic(bufferProcessed.left, bufferProcessed.right);
+		// Adding anechoic processed source to the output mix
+		bufferOutput.left += bufferProcessed.left;
+		bufferOutput.right += bufferProcessed.right;
+	}
+}
+
+void SpatialisationSession::WriteMemoryReport(std::ostream & out) const
+{
+	if (hrtfFileName.empty()) {
+		out << "Session without HRTF" << std::endl;
+		return;
+	}
+	out << "Session with HRTF " << hrtfFileName << ": " << rawTableSize / 1024 << " KB read from the file, "
+		<< partitionedTableSize / 1024 << " KB resampled and partitioned (" << resampledDirections << " directions), "
+		<< (rawTableSize + partitionedTableSize) / 1024 << " KB in total" << std::endl;
+}
+
+Common::TAudioStateStruct SpatialisationSession::GetAudioState() const
+{
+	return core.GetAudioState();
+}
+
+int SpatialisationSession::GetResamplingStep() const
+{
+	return core.GetHRTFResamplingStep();
+}
+
+size_t SpatialisationSession::GetNumberOfSources() const
+{
+	return sources.size();
+}
+
+int SpatialisationSession::GetHRIRLength() const
+{
+	return listener->GetHRTF()->GetHRIRLength();
+}
+
+const std::string & SpatialisationSession::GetHRTFFileName() const
+{
+	return hrtfFileName;
+}
@@ -0,0 +1,83 @@
+/**
+*
+* \brief Declaration of SpatialisationSession, which groups a core, its listener and the source DSPs using one HRTF
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#pragma once
+
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class SpatialisationSession {
+
+public:
+
+	/** \brief Creates a core with the given audio state and its listener. The HRTF is not loaded yet.
+	*	\param [in] audioState sample rate and buffer size of the core
+	*	\param [in] resamplingStep HRTF resampling step, in degrees
+	*/
+	SpatialisationSession(Common::TAudioStateStruct audioState, int resamplingStep);
+
+	/** \brief Loads an HRTF into the listener of this session
+	*	\details Files ending in ".sofa" are loaded as SOFA, any other file is loaded as 3dti-hrtf
+	*	\param [in] fileName name of the HRTF file
+	*	\retval true if the HRTF was loaded
+	*/
+	bool LoadHRTF(const std::string & fileName);
+
+	/** \brief Creates a source DSP, configured for high quality anechoic processing with distance attenuation
+	*	\param [in] sourceTransform position of the new source
+	*/
+	void AddSource(const Common::CTransform & sourceTransform);
+
+	/** \brief Copies the listener and source transforms of another session with the same number of sources
+	*	\param [in] other session to copy the transforms from
+	*/
+	void CopyTransformsFrom(SpatialisationSession & other);
+
+	/** \brief Spatialises one buffer of each source and adds them to the output
+	*	\param [in] inputs one mono buffer per source, in the order the sources were added
+	*	\param [in,out] bufferOutput stereo mix the processed sources are added to
+	*/
+	void Process(const std::vector<CMonoBuffer<float>> & inputs, Common::CEarPair<CMonoBuffer<float>> & bufferOutput);
+
+	/** \brief Writes the memory used by the HRTF of this session: the table read from the file and the resampled, partitioned table the sources are convolved with
+	*	\param [in,out] out stream the report is written to
+	*/
+	void WriteMemoryReport(std::ostream & out) const;
+
+	Common::TAudioStateStruct GetAudioState() const;
+	int GetResamplingStep() const;
+	size_t GetNumberOfSources() const;
+	int GetHRIRLength() const;
+	const std::string & GetHRTFFileName() const;
+
+private:
+
+	Binaural::CCore										core;						// Core interface
+	shared_ptr<Binaural::CListener>						listener;					// Pointer to listener interface
+	std::vector<shared_ptr<Binaural::CSingleSourceDSP>>	sources;					// Pointers to each audio source interface
+	std::string											hrtfFileName;				// Name of the HRTF loaded, empty if none
+	size_t												rawTableSize;				// Memory used by the HRIRs read from the file, in bytes
+	size_t												resampledDirections;		// Directions of the resampled grid, each one counted once
+	size_t												partitionedTableSize;		// Memory used by the resampled and partitioned HRIRs of those directions, in bytes
+	Common::CEarPair<CMonoBuffer<float>>				bufferProcessed;			// Output of one source, reused in every call to Process
+};
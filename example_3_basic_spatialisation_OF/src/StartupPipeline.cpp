@@ -0,0 +1,98 @@
+/**
+*
+* \brief Implementation of StartupPipeline, which runs the independent loading stages of the example concurrently
+* \details Copy of common/StartupPipeline.cpp, as openFrameworks projects only build the files in their src folder
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#include "StartupPipeline.h"
+#include <iostream>
+
+StartupPipeline::StartupPipeline()
+	: startTime{ std::chrono::steady_clock::now() }
+{
+}
+
+StartupPipeline::~StartupPipeline()
+{
+	WaitForAllStages();
+}
+
+double StartupPipeline::GetElapsedMilliseconds() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void StartupPipeline::LaunchStage(const std::string & name, bool required, std::function<bool()> stage, std::function<void()> onReady)
+{
+	TStage newStage;
+	newStage.name = name;
+	newStage.required = required;
+	newStage.finished = false;
+	newStage.succeeded = false;
+	newStage.result = std::async(std::launch::async, [this, name, stage, onReady]() {
+		bool succeeded = Execute(name, stage);
+		if (succeeded && onReady) onReady();
+		return succeeded;
+	});
+	stages.push_back(std::move(newStage));
+}
+
+bool StartupPipeline::RunStage(const std::string & name, std::function<bool()> stage)
+{
+	return Execute(name, stage);
+}
+
+bool StartupPipeline::WaitForRequiredStages()
+{
+	return Wait(true);
+}
+
+bool StartupPipeline::WaitForAllStages()
+{
+	return Wait(false);
+}
+
+bool StartupPipeline::Execute(const std::string & name, const std::function<bool()> & stage)
+{
+	double begin = GetElapsedMilliseconds();
+	bool succeeded = stage();
+	double end = GetElapsedMilliseconds();
+
+	std::lock_guard<std::mutex> lock(logMutex);
+	std::cout << "[startup] " << name << (succeeded ? " ready" : " FAILED") << " in " << (end - begin) << " ms"
+			  << " (from " << begin << " ms to " << end << " ms)" << std::endl;
+	return succeeded;
+}
+
+bool StartupPipeline::Wait(bool onlyRequired)
+{
+	bool allSucceeded = true;
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		TStage & stage = stages[i];
+		if (onlyRequired && !stage.required) continue;
+		if (!stage.finished)
+		{
+			stage.succeeded = stage.result.get();
+			stage.finished = true;
+		}
+		allSucceeded = allSucceeded && stage.succeeded;
+	}
+	return allSucceeded;
+}
@@ -0,0 +1,93 @@
+/**
+*
+* \brief Declaration of StartupPipeline, which runs the independent loading stages of the example concurrently
+* \details Copy of common/StartupPipeline.h, as openFrameworks projects only build the files in their src folder
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: 3DTI (3D-games for TUNing and lEarnINg about hearing aids) ||
+* \b Website: http://3d-tune-in.eu/
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from the European Union's Horizon 2020 research and innovation programme under grant agreement No 644051
+*
+*/
+
+#ifndef _STARTUPPIPELINE_H_
+#define _STARTUPPIPELINE_H_
+
+#include <string>
+#include <vector>
+#include <future>
+#include <mutex>
+#include <chrono>
+#include <functional>
+
+class StartupPipeline
+{
+public:
+	/** \brief Creates an empty pipeline. Stage times are reported from this moment.
+	*/
+	StartupPipeline();
+
+	/** \brief Waits for all the stages that are still running
+	*/
+	~StartupPipeline();
+
+	/** \brief Starts a stage in a background thread
+	*	\details The stage must not depend on any other stage. When it finishes, its duration is logged through the console and,
+	*			 if it succeeded, onReady is called from the same background thread.
+	*	\param [in] name name of the stage, used in the log
+	*	\param [in] required true if the stage belongs to the minimum set needed to start audio (see WaitForRequiredStages)
+	*	\param [in] stage function doing the work of the stage, returning false if it failed
+	*	\param [in] onReady optional function called when the stage has succeeded
+	*/
+	void LaunchStage(const std::string & name, bool required, std::function<bool()> stage, std::function<void()> onReady = nullptr);
+
+	/** \brief Runs a stage in the calling thread, while the launched stages keep running, and logs its duration
+	*	\param [in] name name of the stage, used in the log
+	*	\param [in] stage function doing the work of the stage, returning false if it failed
+	*	\retval value returned by the stage
+	*/
+	bool RunStage(const std::string & name, std::function<bool()> stage);
+
+	/** \brief Blocks until all the required stages have finished
+	*	\retval true if all the required stages succeeded
+	*/
+	bool WaitForRequiredStages();
+
+	/** \brief Blocks until all the stages have finished
+	*	\retval true if all the stages succeeded
+	*/
+	bool WaitForAllStages();
+
+	/** \brief Returns the time since the pipeline was created, in milliseconds
+	*/
+	double GetElapsedMilliseconds() const;
+
+private:
+	struct TStage
+	{
+		std::string name;
+		bool required;
+		std::future<bool> result;
+		bool finished;
+		bool succeeded;
+	};
+
+	bool Execute(const std::string & name, const std::function<bool()> & stage);
+	bool Wait(bool onlyRequired);
+
+	std::vector<TStage> stages;											// Stages launched in background threads
+	std::chrono::steady_clock::time_point startTime;					// Creation time of the pipeline
+	std::mutex logMutex;												// Keeps log lines of different stages apart
+};
+
+#endif
@@ -10,56 +10,61 @@ void ofApp::setup(){
 	Common::TAudioStateStruct audioState;	    // Audio State struct declaration
 	audioState.bufferSize = BUFFERSIZE;			// Setting buffer size 
 	audioState.sampleRate = SAMPLERATE;			// Setting frame rate 
-	myCore.SetAudioState(audioState);		    // Applying configuration to core
-	myCore.SetHRTFResamplingStep(15);		    // Setting 15-degree resampling step for HRTF
+	// The core, the listener and the sources are grouped in a session, so that the HRTF can be replaced later on (see HRTFHotSwap.h)
+	std::unique_ptr<SpatialisationSession> session(new SpatialisationSession(audioState, 15));	// Setting 15-degree resampling step for HRTF
+	SpatialisationSession * initialSession = session.get();
 
-
-	// Listener setup
-	listener = myCore.CreateListener();								 // First step is creating listener
-	Common::CTransform listenerPosition = Common::CTransform();		 // Setting listener in (0,0,0)
-	listenerPosition.SetPosition(Common::CVector3(0, 0, 0));
-	listener->SetListenerTransform(listenerPosition);
-	listener->DisableCustomizedITD();								 // Disabling custom head radius
-	// HRTF can be loaded in SOFA (more info in https://sofacoustics.org/) Some examples of HRTF files can be found in 3dti_AudioToolkit/resources/HRTF
-	bool specifiedDelays;
-	bool sofaLoadResult = HRTF::CreateFromSofa("hrtf.sofa", listener, specifiedDelays);			
-	if (!sofaLoadResult) { 
-		cout << "ERROR: Error trying to load the SOFA file" << endl<<endl;
-	}																			
-
-	// Source 1 setup
-	source1DSP = myCore.CreateSingleSourceDSP();									// Creating audio source
-	LoadWavFile(source1Wav, "speech_female.wav");											// Loading .wav file										   
+	// Source 1 setup. The sources are created before launching the HRTF stage, which works on the same core
 	Common::CTransform source1Position = Common::CTransform();
 	source1Position.SetPosition(Common::CVector3(0, 2, 0));							//Set source position on the listener left side				 
-	source1DSP->SetSourceTransform(source1Position);
-	source1DSP->SetSpatializationMode(Binaural::TSpatializationMode::HighQuality);	// Choosing high quality mode for anechoic processing
-	source1DSP->DisableNearFieldEffect();											// Audio source will not be close to listener, so we don't need near field effect
-	source1DSP->EnableAnechoicProcess();											// Enable anechoic processing for this source
-	source1DSP->EnableDistanceAttenuationAnechoic();								// Do not perform distance simulation
+	session->AddSource(source1Position);											// High quality anechoic processing, without near field effect
 
 	// Source 2 setup
-	source2DSP = myCore.CreateSingleSourceDSP();									// Creating audio source
-	LoadWavFile(source2Wav, "speech_male.wav");											// Loading .wav file										  
 	Common::CTransform source2Position = Common::CTransform();
 	source2Position.SetPosition(Common::CVector3(0, -2, 0));						//Set source position on the listener right side
-	source2DSP->SetSourceTransform(source2Position);
-	source2DSP->SetSpatializationMode(Binaural::TSpatializationMode::HighQuality);	// Choosing high quality mode for anechoic processing
-	source2DSP->DisableNearFieldEffect();											// Audio source will not be close to listener, so we don't need near field effect
-	source2DSP->EnableAnechoicProcess();											// Enable anechoic processing for this source
-	source2DSP->EnableDistanceAttenuationAnechoic();								// Do not perform distance simulation
+	session->AddSource(source2Position);
+
+	hrtfSwap.reset(new HRTFHotSwap(std::move(session)));
+	sourceInputs.assign(2, CMonoBuffer<float>(BUFFERSIZE));							// Input buffers of both sources, so that the audio thread does not allocate them
+
+	// HRTF can be loaded in SOFA (more info in https://sofacoustics.org/) Some examples of HRTF files can be found in 3dti_AudioToolkit/resources/HRTF
+	// The HRTF and the wav files are loaded in background threads while the user selects the audio device
+	audioReady = false;
+	hrtfFileName = "hrtf.sofa";
+	startup.LaunchStage("HRTF", true, [this, initialSession]() {
+		bool sofaLoadResult = initialSession->LoadHRTF(hrtfFileName);
+		if (!sofaLoadResult) { 
+			cout << "ERROR: Error trying to load the SOFA file" << endl<<endl;
+		}
+		else {
+			initialSession->WriteMemoryReport(cout);
+		}
+		return sofaLoadResult;
+	});
+
+	startup.LaunchStage("speech_female.wav", true, [this]() { return LoadWavFile(source1Wav, "speech_female.wav"); });	// Loading .wav files
+	startup.LaunchStage("speech_male.wav", true, [this]() { return LoadWavFile(source2Wav, "speech_male.wav"); });
 
 	//AudioDevice Setup
 	//// Before getting the devices list for the second time, the strean must be closed. Otherwise,
 	//// the app crashes when systemSoundStream.start(); or stop() are called.
 	systemSoundStream.close();
-	SetDeviceAndAudio(audioState);
+	startup.RunStage("Audio device", [this, audioState]() { SetDeviceAndAudio(audioState); return true; });
 
+	// The stream may already be running, audioOut outputs silence until this point
+	if (startup.WaitForRequiredStages()) {
+		audioReady = true;
+		cout << "[startup] Audio started after " << startup.GetElapsedMilliseconds() << " ms" << endl;
+	}
+	else {
+		cout << "ERROR: The audio will stay silent because some of the resources could not be loaded" << endl << endl;
+	}
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
-
+	// The HRTF replaced by the last swap is freed here, outside the audio thread. If the new one failed to load, the name is kept.
+	if (hrtfSwap->ReclaimRetiredSession()) hrtfFileName = requestedHRTFFileName;
 }
 
 //--------------------------------------------------------------
@@ -69,7 +74,21 @@ void ofApp::draw(){
 
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
-
+	switch (key)
+	{
+	case 'h':		// Switching between the SOFA and the 3dti-hrtf versions of the HRTF while the audio is running
+	{
+		if (!audioReady) break;
+		std::string nextHRTFFileName = (hrtfFileName == "hrtf.sofa") ? "hrtf.3dti-hrtf" : "hrtf.sofa";
+		if (hrtfSwap->RequestSwap(nextHRTFFileName)) {			// The HRTF is loaded in background and crossfaded in when ready
+			requestedHRTFFileName = nextHRTFFileName;
+			cout << "Loading HRTF " << requestedHRTFFileName << "..." << endl;
+		}
+		break;
+	}
+	default:
+		break;
+	}
 }
 
 //--------------------------------------------------------------
@@ -215,9 +234,15 @@ int ofApp::GetAudioDeviceIndex(std::vector<ofSoundDevice> list)
 void ofApp::audioOut(float * output, int bufferSize, int nChannels) {
 
 	// The requested frame size is not allways supported by the audio driver:
-	if (myCore.GetAudioState().bufferSize != bufferSize)
+	if (BUFFERSIZE != bufferSize)
 		return;
 
+	// Silence until the HRTF and the wav files have been loaded
+	if (!audioReady) {
+		std::fill(output, output + bufferSize * nChannels, 0.0f);
+		return;
+	}
+
 	// Prepare output chunk
 	Common::CEarPair<CMonoBuffer<float>> bOutput;
 	bOutput.left.resize(bufferSize);
@@ -239,34 +264,22 @@ void ofApp::audioOut(float * output, int bufferSize, int nChannels) {
 /// Process audio using the 3DTI Toolkit methods
 void ofApp::audioProcess(Common::CEarPair<CMonoBuffer<float>> & bufferOutput, int uiBufferSize)
 {
-	// Declaration, initialization and filling mono buffers
-	CMonoBuffer<float> source1(uiBufferSize);
-	source1Wav.FillBuffer(source1);
-	CMonoBuffer<float> source2(uiBufferSize);
-	source2Wav.FillBuffer(source2);
-
-	// Declaration of stereo buffer
-	Common::CEarPair<CMonoBuffer<float>> bufferProcessed;
-	// Anechoic process of first source
-	source1DSP->SetBuffer(source1);
-	source1DSP->ProcessAnechoic(bufferProcessed.left, bufferProcessed.right);
-	// Adding anechoic processed first source to the output mix
-	bufferOutput.left += bufferProcessed.left;
-	bufferOutput.right += bufferProcessed.right;
-	// Anechoic process of second source
-	source2DSP->SetBuffer(source2);
-	source2DSP->ProcessAnechoic(bufferProcessed.left, bufferProcessed.right);
-	// Adding anechoic processed second source to the output mix
-	bufferOutput.left += bufferProcessed.left;
-	bufferOutput.right += bufferProcessed.right;
+	// Filling the mono buffers allocated in setup
+	source1Wav.FillBuffer(sourceInputs[0]);
+	source2Wav.FillBuffer(sourceInputs[1]);
+
+	// Anechoic process of both sources, adding them to the output mix
+	hrtfSwap->Process(sourceInputs, bufferOutput);
 }
 
 
 
-void ofApp::LoadWavFile(SoundSource & source, const char* filePath)
+bool ofApp::LoadWavFile(SoundSource & source, const char* filePath)
 {	
 	if (!source.LoadWav(filePath)) {
 		cout << "ERROR: file " << filePath << " doesn't exist." << endl<<endl;
+		return false;
 	}
+	return true;
 }
 
@@ -5,6 +5,9 @@
 #include <HRTF/HRTFFactory.h>
 #include <HRTF/HRTFCereal.h>
 #include "SoundSource.h"
+#include "HRTFHotSwap.h"
+#include "StartupPipeline.h"
+#include <atomic>
 
 
 class ofApp : public ofBaseApp{
@@ -28,20 +31,23 @@ class ofApp : public ofBaseApp{
 		
 	private:	
 
-		Binaural::CCore							myCore;												 // Core interface
-		shared_ptr<Binaural::CListener>			listener;											 // Pointer to listener interface
+		std::unique_ptr<HRTFHotSwap>			hrtfSwap;											 // Core, listener and sources, with the HRTF that can be replaced while running
+		std::string								hrtfFileName;										 // HRTF in use, or being loaded at startup
+		std::string								requestedHRTFFileName;								 // HRTF of the last swap requested, in use once the swap finishes
 
 		std::vector<ofSoundDevice> deviceList;
 		ofSoundStream systemSoundStream;
 
 		SoundSource source1Wav;
 		SoundSource source2Wav;
-		shared_ptr<Binaural::CSingleSourceDSP>	source1DSP;							 // Pointers to each audio source interface
-		shared_ptr<Binaural::CSingleSourceDSP>	source2DSP;							 // Pointers to each audio source interface
+		std::vector<CMonoBuffer<float>>			sourceInputs;										 // One buffer per source, filled from the wav files in every block
+
+		StartupPipeline							startup;											 // Loads the HRTF and the wav files concurrently. Declared after everything its stages use
+		std::atomic<bool>						audioReady;											 // False until the HRTF and the wav files have been loaded
 
 		int GetAudioDeviceIndex(std::vector<ofSoundDevice> list);
 		void SetDeviceAndAudio(Common::TAudioStateStruct audioState);
 		void audioOut(float * output, int bufferSize, int nChannels);
 		void audioProcess(Common::CEarPair<CMonoBuffer<float>> & bufferOutput, int uiBufferSize);
-		void LoadWavFile(SoundSource & source, const char* filePath);
+		bool LoadWavFile(SoundSource & source, const char* filePath);
 };
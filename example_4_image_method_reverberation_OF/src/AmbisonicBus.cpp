@@ -0,0 +1,141 @@
+#include "AmbisonicBus.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const float goldenRatio = 1.6180339887f;
+
+	// Vertices of the octahedron and the icosahedron, not normalised
+	const float octahedron[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	const float icosahedron[12][3] = {
+		{ 0, 1, goldenRatio }, { 0, 1, -goldenRatio }, { 0, -1, goldenRatio }, { 0, -1, -goldenRatio },
+		{ 1, goldenRatio, 0 }, { 1, -goldenRatio, 0 }, { -1, goldenRatio, 0 }, { -1, -goldenRatio, 0 },
+		{ goldenRatio, 0, 1 }, { goldenRatio, 0, -1 }, { -goldenRatio, 0, 1 }, { -goldenRatio, 0, -1 } };
+}
+
+void AmbisonicBus::setup(Binaural::CCore & core, int _order, int _bufferSize)
+{
+	order = std::min(std::max(_order, 1), AMBISONIC_MAX_ORDER);
+	numberOfChannels = (order + 1) * (order + 1);
+	bufferSize = _bufferSize;
+	blockCount = 0;
+	channels.assign(numberOfChannels, CMonoBuffer<float>(bufferSize, 0.0f));
+	speakerBuffer.assign(bufferSize, 0.0f);
+
+	const float (*layout)[3] = order == 1 ? octahedron : icosahedron;
+	int numberOfSpeakers = order == 1 ? 6 : 12;
+	speakerDirections.clear();
+	for (int s = 0; s < numberOfSpeakers; s++)
+	{
+		Common::CVector3 direction(layout[s][0], layout[s][1], layout[s][2]);
+		float length = direction.GetDistance();
+		speakerDirections.push_back(Common::CVector3(direction.x / length, direction.y / length, direction.z / length));
+	}
+
+	// Sampling decoder. With N3D harmonics, the sum over the loudspeakers of the square of their gains for a plane wave is then 1.
+	float harmonics[AMBISONIC_MAX_CHANNELS];
+	float scale = 1.0f / ((order + 1) * std::sqrt((float)numberOfSpeakers));
+	decoder.resize((size_t)numberOfSpeakers * numberOfChannels);
+	for (int s = 0; s < numberOfSpeakers; s++)
+	{
+		getSphericalHarmonics(speakerDirections[s], harmonics);
+		for (int c = 0; c < numberOfChannels; c++) decoder[s * numberOfChannels + c] = harmonics[c] * scale;
+	}
+
+	speakerDSPs.clear();
+	for (int s = 0; s < numberOfSpeakers; s++)
+	{
+		shared_ptr<Binaural::CSingleSourceDSP> speakerDSP = core.CreateSingleSourceDSP();
+		speakerDSP->SetSpatializationMode(Binaural::TSpatializationMode::HighQuality);
+		speakerDSP->DisableNearFieldEffect();
+		speakerDSP->EnableAnechoicProcess();
+		speakerDSP->DisableDistanceAttenuationAnechoic();			// Applied by the gain of each source when it is encoded
+		speakerDSP->DisablePropagationDelay();						// Applied to each source before it is encoded
+		speakerDSPs.push_back(speakerDSP);
+	}
+}
+
+void AmbisonicBus::getSphericalHarmonics(Common::CVector3 direction, float * harmonics)
+{
+	float x = direction.x, y = direction.y, z = direction.z;
+	const float sqrt3 = 1.7320508f, sqrt5 = 2.2360680f, sqrt15 = 3.8729833f;
+	harmonics[0] = 1.0f;
+	harmonics[1] = sqrt3 * y;
+	harmonics[2] = sqrt3 * z;
+	harmonics[3] = sqrt3 * x;
+	harmonics[4] = sqrt15 * x * y;
+	harmonics[5] = sqrt15 * y * z;
+	harmonics[6] = sqrt5 / 2.0f * (3.0f * z * z - 1.0f);
+	harmonics[7] = sqrt15 * x * z;
+	harmonics[8] = sqrt15 / 2.0f * (x * x - y * y);
+}
+
+void AmbisonicBus::encode(TState & state, const CMonoBuffer<float> & input, Common::CVector3 direction, float gain)
+{
+	float length = direction.GetDistance();
+	if (length > 0.0f) direction = Common::CVector3(direction.x / length, direction.y / length, direction.z / length);
+	else direction = Common::CVector3(1, 0, 0);						// A source at the listener is encoded in front of it
+
+	float targetGains[AMBISONIC_MAX_CHANNELS];
+	getSphericalHarmonics(direction, targetGains);
+	for (int c = 0; c < numberOfChannels; c++) targetGains[c] *= gain;
+	if (state.nextBlock != blockCount)								// New or silent source, which fades in from silence
+		std::fill(state.gains, state.gains + numberOfChannels, 0.0f);
+
+	size_t size = std::min(input.size(), (size_t)bufferSize);
+	for (int c = 0; c < numberOfChannels; c++)
+	{
+		float * channel = channels[c].data();
+		float step = (targetGains[c] - state.gains[c]) / bufferSize;
+		float first = state.gains[c] + step;
+		for (size_t n = 0; n < size; n++) channel[n] += (first + n * step) * input[n];
+		state.gains[c] = targetGains[c];
+	}
+	state.nextBlock = blockCount + 1;
+}
+
+void AmbisonicBus::decode(Common::CVector3 listenerLocation, Common::CEarPair<CMonoBuffer<float>> & bufferOutput)
+{
+	Common::CEarPair<CMonoBuffer<float>> bufferProcessed;
+	for (size_t s = 0; s < speakerDSPs.size(); s++)
+	{
+		std::fill(speakerBuffer.begin(), speakerBuffer.end(), 0.0f);
+		for (int c = 0; c < numberOfChannels; c++)
+		{
+			float gain = decoder[s * numberOfChannels + c];
+			const float * channel = channels[c].data();
+			for (int n = 0; n < bufferSize; n++) speakerBuffer[n] += gain * channel[n];
+		}
+
+		// The loudspeakers follow the listener, so their directions stay the ones the sources were encoded with
+		Common::CVector3 direction = speakerDirections[s];
+		Common::CTransform speakerPosition;
+		speakerPosition.SetPosition(Common::CVector3(listenerLocation.x + direction.x * AMBISONIC_SPEAKER_DISTANCE,
+													 listenerLocation.y + direction.y * AMBISONIC_SPEAKER_DISTANCE,
+													 listenerLocation.z + direction.z * AMBISONIC_SPEAKER_DISTANCE));
+		speakerDSPs[s]->SetSourceTransform(speakerPosition);
+		speakerDSPs[s]->SetBuffer(speakerBuffer);
+		speakerDSPs[s]->ProcessAnechoic(bufferProcessed.left, bufferProcessed.right);
+		bufferOutput.left += bufferProcessed.left;
+		bufferOutput.right += bufferProcessed.right;
+	}
+
+	for (int c = 0; c < numberOfChannels; c++) std::fill(channels[c].begin(), channels[c].end(), 0.0f);
+	blockCount++;
+}
+
+int AmbisonicBus::getOrder()
+{
+	return order;
+}
+
+int AmbisonicBus::getNumberOfChannels()
+{
+	return numberOfChannels;
+}
+
+int AmbisonicBus::getNumberOfSpeakers()
+{
+	return (int)speakerDSPs.size();
+}
@@ -0,0 +1,98 @@
+/**
+* \class AmbisonicBus
+*
+* \brief Declaration of AmbisonicBus, a higher order ambisonic bus into which the image sources are encoded, decoded binaurally once per block
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: SAVLab (Spatial Audio Virtual Laboratory) ||
+* \b Website:
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from Spanish Ministerio de Ciencia e Innovacin under the SAVLab project (PID2019-107854GB-I00)
+*
+*/#pragma once
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+#include <Common/Vector3.h>
+#include <vector>
+
+#define AMBISONIC_MAX_ORDER 2						// Highest order with a uniform layout of virtual loudspeakers, the icosahedron
+#define AMBISONIC_MAX_CHANNELS 9					// (AMBISONIC_MAX_ORDER + 1)^2
+#define AMBISONIC_SPEAKER_DISTANCE 1.0f				// Distance of the virtual loudspeakers to the listener, in meters, at which the toolkit does not attenuate them
+
+/** \details Rendering each image source with its own source DSP costs one HRTF convolution per image. Instead, the delayed signal of
+*			 each image is encoded, with its gain, into the channels of an ambisonic bus (real spherical harmonics, ACN order and N3D
+*			 normalisation), which only costs one multiply-add per channel and sample. Once per block, the bus is decoded into a fixed
+*			 layout of virtual loudspeakers around the listener, the octahedron for first order and the icosahedron for second order,
+*			 and each loudspeaker is rendered by a source DSP. The cost of the HRTF convolutions is then that of 6 or 12 sources, whatever
+*			 the number of images. Both layouts sample the sphere uniformly enough for the order, so the decoder is just the spherical
+*			 harmonics at each loudspeaker, scaled to keep the energy of a plane wave.
+*			 When the direction or the gain of an image changes, its encoding gains move linearly along the block, as the delays of
+*			 PropagationDelayLine do, to avoid clicks. An image that starts to be encoded fades in from silence, and one that stops is
+*			 faded out by encoding it with a gain of 0 in one more block.
+*/
+class AmbisonicBus
+{
+public:
+	/** \brief Encoding state of one source
+	*/
+	struct TState
+	{
+		TState() : nextBlock{ 0 } {}
+		float gains[AMBISONIC_MAX_CHANNELS];				// Encoding gains reached at the end of the last block encoded
+		unsigned long nextBlock;							// Block in which the source must be encoded again to keep gliding from those gains
+	};
+
+	AmbisonicBus() : order{ 0 }, numberOfChannels{ 0 }, bufferSize{ 0 }, blockCount{ 0 } {}
+
+	/** \brief Creates the virtual loudspeakers and allocates the channels of the bus
+	*	\param [in] core core where the source DSPs of the virtual loudspeakers are created
+	*	\param [in] _order ambisonic order, from 1 to AMBISONIC_MAX_ORDER. Out of range values are clamped.
+	*	\param [in] _bufferSize size of the blocks encoded and decoded
+	*/
+	void setup(Binaural::CCore & core, int _order, int _bufferSize);
+
+	/** \brief Adds a source to the bus in this block
+	*	\details If the source was not encoded in the previous block, it fades in from silence along the block.
+	*	\param [in,out] state encoding state of the source
+	*	\param [in] input signal of the source, already delayed
+	*	\param [in] direction direction of the source seen from the listener, in the coordinates of the world. It does not need to be a unit vector.
+	*	\param [in] gain gain of the source, including its distance attenuation
+	*/
+	void encode(TState & state, const CMonoBuffer<float> & input, Common::CVector3 direction, float gain);
+
+	/** \brief Renders the sources encoded in this block through the virtual loudspeakers, adds them to the output and clears the bus.
+	*		   To be called once per block, after all the sources are encoded, even if there are none, so that the loudspeakers ring out.
+	*	\param [in] listenerLocation location of the listener, around which the virtual loudspeakers are placed
+	*	\param [in,out] bufferOutput binaural output, to which the loudspeakers are added
+	*/
+	void decode(Common::CVector3 listenerLocation, Common::CEarPair<CMonoBuffer<float>> & bufferOutput);
+
+	int getOrder();
+	int getNumberOfChannels();
+	int getNumberOfSpeakers();
+
+	/** \brief Computes the real spherical harmonics up to AMBISONIC_MAX_ORDER in a direction, in ACN order and with N3D normalisation
+	*	\param [in] direction unit vector, x forward, y left and z up
+	*	\param [out] harmonics AMBISONIC_MAX_CHANNELS values
+	*/
+	static void getSphericalHarmonics(Common::CVector3 direction, float * harmonics);
+
+private:
+	int order;
+	int numberOfChannels;
+	int bufferSize;
+	unsigned long blockCount;								// Blocks decoded since setup
+	std::vector<CMonoBuffer<float>> channels;				// Sources encoded in this block
+	std::vector<Common::CVector3> speakerDirections;		// Unit vectors
+	std::vector<float> decoder;								// Gain of each channel in each loudspeaker, numberOfChannels per loudspeaker
+	std::vector<shared_ptr<Binaural::CSingleSourceDSP>> speakerDSPs;
+	CMonoBuffer<float> speakerBuffer;						// Signal of the loudspeaker being rendered
+};
@@ -0,0 +1,402 @@
+#include "Benchmarks.h"
+#include "ReflectionPaths.h"
+#include "Room.h"
+#include "SourceImages.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#define BENCHMARK_ROOM_WIDTH 3.0f				// Room of ofApp::setup
+#define BENCHMARK_ROOM_LENGTH 2.0f
+#define BENCHMARK_ROOM_HEIGHT 2.5f
+#define BENCHMARK_VISIBILITY_PATHS 64			// Paths tested per wall
+#define BENCHMARK_VISIBILITY_SECONDS 0.5		// Minimum time measured for each implementation
+#define BENCHMARK_PATHS_IMAGES_PER_WALL 16		// Images reflected on each wall
+#define BENCHMARK_PATHS_LISTENERS 64			// Listener locations for which all the paths are computed
+#define BENCHMARK_SHOEBOX_ORDER 10				// Highest reflection order of the images generated in the shoebox room
+#define BENCHMARK_SHOEBOX_GENERIC_ORDER 6		// Highest one for the generic generator, whose number of images grows as 5^n
+#define BENCHMARK_BUILD_ORDER 7					// Highest reflection order of the images generated in parallel and serially
+
+namespace Benchmarks
+{
+	namespace
+	{
+		const float threshold = 0.000001f;		// THRESHOLD of Wall.cpp
+
+		// One path from an image to the listener through a wall
+		struct TPath
+		{
+			size_t wall;
+			Common::CVector3 image;
+			Common::CVector3 listener;
+		};
+
+		// Visibility test as it was before the plane and the edges of the walls were cached: the plane is recomputed from the corners
+		// each time the distance from a point to it is needed, and the point is inside if the angles subtended by the edges add up to 2*pi
+		struct TOriginalWall
+		{
+			std::vector<Common::CVector3> polygon;
+			float A, B, C, D;
+
+			void calculateABCD()
+			{
+				Common::CVector3 normal = (polygon.at(1) - polygon.at(0)).CrossProduct(polygon.at(2) - polygon.at(0));
+				float modulus = normal.GetDistance();
+				A = normal.x / modulus;
+				B = normal.y / modulus;
+				C = normal.z / modulus;
+				D = -(A * polygon.at(2).x + B * polygon.at(2).y + C * polygon.at(2).z);
+			}
+
+			float getDistanceFromPoint(Common::CVector3 point)
+			{
+				calculateABCD();
+				return std::fabs(A * point.x + B * point.y + C * point.z + D) / std::sqrt(A * A + B * B + C * C);
+			}
+
+			Common::CVector3 getIntersectionPointWithLine(Common::CVector3 p1, Common::CVector3 p2)
+			{
+				Common::CVector3 vecLine = p2 - p1;
+				float lambda = (-D - (A * p1.x + B * p1.y + C * p1.z)) / (A * vecLine.x + B * vecLine.y + C * vecLine.z);
+				Common::CVector3 cutPoint(p1.x + lambda * vecLine.x, p1.y + lambda * vecLine.y, p1.z + lambda * vecLine.z);
+				volatile float modulus = getDistanceFromPoint(cutPoint);		// Computed and not used by the original implementation
+				(void)modulus;
+				return cutPoint;
+			}
+
+			bool checkPointInsideWall(Common::CVector3 point)
+			{
+				if (getDistanceFromPoint(point) > threshold) return false;
+				double anglesum = 0;
+				size_t n = polygon.size();
+				for (size_t i = 0; i < n; i++)
+				{
+					Common::CVector3 p1 = polygon[i] - point;
+					Common::CVector3 p2 = polygon[(i + 1) % n] - point;
+					double m1 = p1.GetDistance();
+					double m2 = p2.GetDistance();
+					if (m1 * m2 <= threshold) return true;
+					anglesum += std::acos((p1.x * p2.x + p1.y * p2.y + p1.z * p2.z) / (m1 * m2));
+				}
+				return std::fabs(6.283185307179586476925287 - anglesum) < threshold;
+			}
+		};
+
+		// Walls of the room of ofApp::setup and of its image rooms up to the second order, which are the reflection walls of the images
+		// up to the third order
+		std::vector<Wall> getImageRoomWalls()
+		{
+			Room room;
+			room.setup(BENCHMARK_ROOM_WIDTH, BENCHMARK_ROOM_LENGTH, BENCHMARK_ROOM_HEIGHT);
+			std::vector<Room> rooms(1, room);
+			std::vector<Room> lastOrder = rooms;
+			for (int order = 1; order <= 2; order++)
+			{
+				std::vector<Room> nextOrder;
+				for (Room & lastRoom : lastOrder)
+				{
+					std::vector<Room> imageRooms = lastRoom.getImageRooms();
+					nextOrder.insert(nextOrder.end(), imageRooms.begin(), imageRooms.end());
+				}
+				rooms.insert(rooms.end(), nextOrder.begin(), nextOrder.end());
+				lastOrder.swap(nextOrder);
+			}
+			std::vector<Wall> walls;
+			for (const Room & imageRoom : rooms)
+				walls.insert(walls.end(), imageRoom.getWalls().begin(), imageRoom.getWalls().end());
+			return walls;
+		}
+
+		// Random location inside the room
+		Common::CVector3 getRandomLocation(std::mt19937 & generator)
+		{
+			std::uniform_real_distribution<float> x(-BENCHMARK_ROOM_LENGTH / 2, BENCHMARK_ROOM_LENGTH / 2);
+			std::uniform_real_distribution<float> y(-BENCHMARK_ROOM_WIDTH / 2, BENCHMARK_ROOM_WIDTH / 2);
+			std::uniform_real_distribution<float> z(-BENCHMARK_ROOM_HEIGHT / 2, BENCHMARK_ROOM_HEIGHT / 2);
+			float randomX = x(generator), randomY = y(generator);
+			return Common::CVector3(randomX, randomY, z(generator));
+		}
+
+		// Runs one implementation of the test on all the paths for at least BENCHMARK_VISIBILITY_SECONDS, and returns the time per path in ns
+		template <typename TTest>
+		double timeVisibility(const std::vector<TPath> & paths, TTest test, std::vector<char> & visible)
+		{
+			long long numberOfTests = 0;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			std::chrono::duration<double> elapsed(0);
+			while (elapsed.count() < BENCHMARK_VISIBILITY_SECONDS)
+			{
+				for (size_t i = 0; i < paths.size(); i++) visible[i] = test(paths[i]);
+				numberOfTests += paths.size();
+				elapsed = std::chrono::steady_clock::now() - start;
+			}
+			return 1e9 * elapsed.count() / numberOfTests;
+		}
+
+		// Generates the images with one of the generators as many times as fit in BENCHMARK_VISIBILITY_SECONDS, and returns the time per call in ms
+		template <typename TGenerate>
+		double timeGeneration(TGenerate generate, SourceImages::TImageStore & images)
+		{
+			long long numberOfCalls = 0;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			std::chrono::duration<double> elapsed(0);
+			while (elapsed.count() < BENCHMARK_VISIBILITY_SECONDS)
+			{
+				images = SourceImages::TImageStore();
+				generate(images);
+				numberOfCalls++;
+				elapsed = std::chrono::steady_clock::now() - start;
+			}
+			return 1e3 * elapsed.count() / numberOfCalls;
+		}
+
+		// Number of different locations of the images, to a tenth of a millimetre
+		size_t getNumberOfLocations(const SourceImages::TImageStore & images)
+		{
+			std::set<std::tuple<long, long, long>> locations;
+			for (size_t i = 0; i < images.paths.size(); i++)
+			{
+				Common::CVector3 location = images.paths.getLocation(i);
+				locations.insert(std::make_tuple(std::lround(location.x * 1e4), std::lround(location.y * 1e4), std::lround(location.z * 1e4)));
+			}
+			return locations.size();
+		}
+	}
+
+	bool run(const std::string & name)
+	{
+		if (name == "visibility") runVisibility();
+		else if (name == "paths") runPaths();
+		else if (name == "shoebox") runShoebox();
+		else if (name == "build") runBuild();
+		else return false;
+		return true;
+	}
+
+	void runVisibility()
+	{
+		std::vector<Wall> walls = getImageRoomWalls();
+		std::vector<TOriginalWall> originalWalls;
+		for (Wall & wall : walls)
+		{
+			TOriginalWall originalWall;
+			originalWall.polygon = wall.getCorners();
+			originalWall.calculateABCD();
+			originalWalls.push_back(originalWall);
+		}
+
+		// Each path goes from the image of a source inside the room, on a wall, to a listener inside the room
+		std::mt19937 generator(1);
+		std::vector<TPath> paths;
+		for (size_t w = 0; w < walls.size(); w++)
+		{
+			for (int i = 0; i < BENCHMARK_VISIBILITY_PATHS; i++)
+			{
+				TPath path;
+				path.wall = w;
+				path.image = walls[w].getImagePoint(getRandomLocation(generator));
+				path.listener = getRandomLocation(generator);
+				paths.push_back(path);
+			}
+		}
+
+		std::vector<char> originalVisible(paths.size()), cachedVisible(paths.size());
+		double originalTime = timeVisibility(paths, [&](const TPath & path) {
+			TOriginalWall & wall = originalWalls[path.wall];
+			return wall.checkPointInsideWall(wall.getIntersectionPointWithLine(path.image, path.listener));
+		}, originalVisible);
+		double cachedTime = timeVisibility(paths, [&](const TPath & path) {
+			Wall & wall = walls[path.wall];
+			return wall.checkPointInsideWall(wall.getIntersectionPointWithLine(path.image, path.listener));
+		}, cachedVisible);
+
+		// The angle sum of the original test misses some points inside the wall by rounding, as it must reach 2*pi within the threshold
+		size_t numberOfVisible = 0, onlyOriginal = 0, onlyCached = 0;
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			numberOfVisible += cachedVisible[i] != 0;
+			onlyOriginal += originalVisible[i] && !cachedVisible[i];
+			onlyCached += !originalVisible[i] && cachedVisible[i];
+		}
+
+		std::cout << "Visibility benchmark, " << walls.size() << " walls of the room and its image rooms up to the second order, "
+				  << paths.size() << " paths (" << numberOfVisible << " visible)" << std::endl;
+		printf("%10s %14s %14s %10s %18s\n", "version", "ns per test", "tests per ms", "speedup", "visible only here");
+		printf("%10s %14.1f %14.0f %10s %18zu\n", "original", originalTime, 1e6 / originalTime, "1.00", onlyOriginal);
+		printf("%10s %14.1f %14.0f %10.2f %18zu\n", "cached", cachedTime, 1e6 / cachedTime, originalTime / cachedTime, onlyCached);
+	}
+
+	void runPaths()
+	{
+		// Images of sources inside the room on each wall, all of them seen from each listener location
+		std::vector<Wall> walls = getImageRoomWalls();
+		std::mt19937 generator(1);
+		std::vector<size_t> imageWalls;
+		ReflectionPaths reflectionPaths;
+		for (size_t w = 0; w < walls.size(); w++)
+		{
+			for (int i = 0; i < BENCHMARK_PATHS_IMAGES_PER_WALL; i++)
+			{
+				reflectionPaths.addImage(walls[w].getImagePoint(getRandomLocation(generator)), walls[w]);
+				imageWalls.push_back(w);
+			}
+		}
+		std::vector<Common::CVector3> listeners;
+		for (int l = 0; l < BENCHMARK_PATHS_LISTENERS; l++) listeners.push_back(getRandomLocation(generator));
+		size_t numberOfImages = reflectionPaths.size();
+
+		// One image at a time, with the methods of Wall, as SourceImages did before
+		std::vector<ReflectionPaths::TResults> oneByOne(listeners.size()), sweep(listeners.size());
+		for (ReflectionPaths::TResults & results : oneByOne)
+		{
+			results.reflectionX.resize(numberOfImages);
+			results.reflectionY.resize(numberOfImages);
+			results.reflectionZ.resize(numberOfImages);
+			results.pathLengths.resize(numberOfImages);
+			results.visible.resize(numberOfImages);
+		}
+		long long numberOfSweeps = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::chrono::duration<double> elapsed(0);
+		while (elapsed.count() < BENCHMARK_VISIBILITY_SECONDS)
+		{
+			for (size_t l = 0; l < listeners.size(); l++)
+			{
+				ReflectionPaths::TResults & results = oneByOne[l];
+				for (size_t i = 0; i < numberOfImages; i++)
+				{
+					Common::CVector3 image = reflectionPaths.getLocation(i);
+					Wall & wall = walls[imageWalls[i]];
+					Common::CVector3 reflectionPoint = wall.getIntersectionPointWithLine(image, listeners[l]);
+					results.reflectionX[i] = reflectionPoint.x;
+					results.reflectionY[i] = reflectionPoint.y;
+					results.reflectionZ[i] = reflectionPoint.z;
+					results.pathLengths[i] = (listeners[l] - image).GetDistance();
+					results.visible[i] = wall.checkPointInsideWall(reflectionPoint);
+				}
+			}
+			numberOfSweeps += listeners.size();
+			elapsed = std::chrono::steady_clock::now() - start;
+		}
+		double oneByOneTime = 1e9 * elapsed.count() / (numberOfSweeps * numberOfImages);
+
+		numberOfSweeps = 0;
+		start = std::chrono::steady_clock::now();
+		elapsed = std::chrono::duration<double>(0);
+		while (elapsed.count() < BENCHMARK_VISIBILITY_SECONDS)
+		{
+			for (size_t l = 0; l < listeners.size(); l++) reflectionPaths.compute(listeners[l], numberOfImages, sweep[l]);
+			numberOfSweeps += listeners.size();
+			elapsed = std::chrono::steady_clock::now() - start;
+		}
+		double sweepTime = 1e9 * elapsed.count() / (numberOfSweeps * numberOfImages);
+
+		// The visibility and the reflection points must be the same. Path lengths may differ in the last bit, as the toolkit may compute
+		// the distance of CVector3 in another order.
+		size_t numberOfVisible = 0, differentVisibility = 0, differentPoints = 0;
+		double maxLengthError = 0;
+		for (size_t l = 0; l < listeners.size(); l++)
+		{
+			for (size_t i = 0; i < numberOfImages; i++)
+			{
+				numberOfVisible += sweep[l].visible[i];
+				differentVisibility += sweep[l].visible[i] != oneByOne[l].visible[i];
+				differentPoints += sweep[l].reflectionX[i] != oneByOne[l].reflectionX[i] || sweep[l].reflectionY[i] != oneByOne[l].reflectionY[i] ||
+								   sweep[l].reflectionZ[i] != oneByOne[l].reflectionZ[i];
+				maxLengthError = std::max(maxLengthError, (double)std::fabs(sweep[l].pathLengths[i] - oneByOne[l].pathLengths[i]));
+			}
+		}
+
+		std::cout << "Reflection paths benchmark, " << numberOfImages << " images on " << walls.size() << " walls, " << listeners.size()
+				  << " listener locations (" << numberOfVisible << " visible paths)" << std::endl;
+		printf("%12s %14s %14s %10s\n", "version", "ns per image", "images per ms", "speedup");
+		printf("%12s %14.1f %14.0f %10s\n", "one by one", oneByOneTime, 1e6 / oneByOneTime, "1.00");
+		printf("%12s %14.1f %14.0f %10.2f\n", "sweep", sweepTime, 1e6 / sweepTime, oneByOneTime / sweepTime);
+		std::cout << "Different visibility: " << differentVisibility << ", different reflection points: " << differentPoints
+				  << ", largest path length difference: " << maxLengthError << " m" << std::endl;
+	}
+
+	void runShoebox()
+	{
+		// Source of ofApp::setup
+		Room room;
+		room.setup(BENCHMARK_ROOM_WIDTH, BENCHMARK_ROOM_LENGTH, BENCHMARK_ROOM_HEIGHT);
+		Common::CVector3 sourceLocation(0.5f, -1.0f, 1.0f);
+
+		std::cout << "Shoebox benchmark, images of the source of the example in its room, without their DSPs, generated by reflecting the images on every wall "
+				  << "(generic) and by enumerating the lattice of copies of the room (shoebox)" << std::endl;
+		printf("%6s %15s %12s %12s %16s %12s %15s %12s %10s\n", "order", "generic images", "invalid", "duplicates", "different ones", "generic ms",
+			   "shoebox images", "shoebox ms", "speedup");
+		for (int order = 1; order <= BENCHMARK_SHOEBOX_ORDER; order++)
+		{
+			SourceImages::TImageStore shoeboxImages;
+			double shoeboxTime = timeGeneration([&](SourceImages::TImageStore & images) {
+				SourceImages::generateShoeboxImages(room, sourceLocation, order, 0.0f, images);
+			}, shoeboxImages);
+			if (order > BENCHMARK_SHOEBOX_GENERIC_ORDER)
+			{
+				printf("%6d %15s %12s %12s %16s %12s %15zu %12.3f %10s\n", order, "-", "-", "-", "-", "-", shoeboxImages.paths.size(), shoeboxTime, "-");
+				continue;
+			}
+
+			// Without the duplicates, the generic images must be the shoebox ones, which is checked by counting their different locations
+			SourceImages::TImageStore genericImages;
+			double genericTime = timeGeneration([&](SourceImages::TImageStore & images) {
+				SourceImages::generateImages(room, sourceLocation, order, 0.0f, images);
+			}, genericImages);
+			size_t numberOfInvalidImages = 0, numberOfDuplicates = 0;
+			for (int o = 0; o < order; o++)
+			{
+				numberOfInvalidImages += genericImages.invalidImages[o];
+				numberOfDuplicates += genericImages.duplicateImages[o];
+			}
+			printf("%6d %15zu %12zu %12zu %16zu %12.3f %15zu %12.3f %10.1f\n", order, genericImages.paths.size(), numberOfInvalidImages, numberOfDuplicates,
+				   getNumberOfLocations(genericImages), genericTime, shoeboxImages.paths.size(), shoeboxTime, genericTime / shoeboxTime);
+		}
+	}
+
+	void runBuild()
+	{
+		// Source of ofApp::setup
+		Room room;
+		room.setup(BENCHMARK_ROOM_WIDTH, BENCHMARK_ROOM_LENGTH, BENCHMARK_ROOM_HEIGHT);
+		Common::CVector3 sourceLocation(0.5f, -1.0f, 1.0f);
+
+		std::cout << "Build benchmark, images of the source of the example in its room, without their DSPs, generated by the generic method with one "
+				  << "task per first-order image (parallel) and on one thread (serial), and by enumerating the shoebox lattice, with "
+				  << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+		printf("%6s %15s %12s %12s %10s %15s %12s %10s\n", "order", "generic images", "serial ms", "parallel ms", "speedup", "shoebox images",
+			   "shoebox ms", "same");
+		for (int order = 1; order <= BENCHMARK_BUILD_ORDER; order++)
+		{
+			SourceImages::TImageStore serialImages, parallelImages, shoeboxImages;
+			double serialTime = timeGeneration([&](SourceImages::TImageStore & images) {
+				SourceImages::generateImages(room, sourceLocation, order, 0.0f, images, false);
+			}, serialImages);
+			double parallelTime = timeGeneration([&](SourceImages::TImageStore & images) {
+				SourceImages::generateImages(room, sourceLocation, order, 0.0f, images, true);
+			}, parallelImages);
+			double shoeboxTime = timeGeneration([&](SourceImages::TImageStore & images) {
+				SourceImages::generateShoeboxImages(room, sourceLocation, order, 0.0f, images);
+			}, shoeboxImages);
+
+			// Both generic stores must have the same images, in the same order
+			bool same = serialImages.parents == parallelImages.parents && serialImages.sources == parallelImages.sources &&
+						serialImages.wallIndices == parallelImages.wallIndices && serialImages.orderEnds == parallelImages.orderEnds;
+			for (size_t i = 0; i < serialImages.paths.size() && same; i++)
+			{
+				Common::CVector3 serialLocation = serialImages.paths.getLocation(i), parallelLocation = parallelImages.paths.getLocation(i);
+				same = serialLocation.x == parallelLocation.x && serialLocation.y == parallelLocation.y && serialLocation.z == parallelLocation.z;
+			}
+			printf("%6d %15zu %12.3f %12.3f %10.2f %15zu %12.3f %10s\n", order, serialImages.paths.size(), serialTime, parallelTime, serialTime / parallelTime,
+				   shoeboxImages.paths.size(), shoeboxTime, same ? "yes" : "no");
+		}
+	}
+}
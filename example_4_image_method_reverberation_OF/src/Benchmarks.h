@@ -0,0 +1,57 @@
+/**
+*
+* \brief Declaration of the benchmarks that can be run from the command line of the example project 4
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: SAVLab (Spatial Audio Virtual Laboratory) ||
+* \b Website:
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from Spanish Ministerio de Ciencia e Innovacin under the SAVLab project (PID2019-107854GB-I00)
+*
+*/
+#pragma once
+#include <string>
+
+namespace Benchmarks
+{
+	/** \brief Runs one of the benchmarks and prints its results through the console
+	*	\details Usage: example --benchmark <name>, run instead of opening the window of the example. Available benchmarks:
+	*			 - visibility: time of the visibility test of an image (intersection with its reflection wall and point in polygon test),
+	*			   with the walls of the example room and its image rooms, computed as before and after caching the plane and edges of the walls
+	*			 - paths: time per image of the reflection paths of thousands of images, computed one by one with Wall and in one sweep with ReflectionPaths
+	*			 - shoebox: time to generate the images of the example room up to each order, generic and by enumerating the shoebox lattice
+	*			 - build: time to generate the images of the example room up to each order, generic in parallel and serially, and by enumerating the lattice
+	*	\param [in] name name of the benchmark
+	*	\retval false if there is no benchmark with that name
+	*/
+	bool run(const std::string & name);
+
+	/** \brief Measures the visibility test of the image sources against the original implementation, which recomputed the plane of the
+	*		   wall on each call and summed the angles subtended by its edges, and checks that both give the same result
+	*/
+	void runVisibility();
+
+	/** \brief Measures ReflectionPaths against computing the path of each image with the methods of its reflection wall, and checks
+	*		   that both give the same visibility and reflection points
+	*/
+	void runPaths();
+
+	/** \brief Measures the generation of the images of the example source in the example room by SourceImages::generateImages and
+	*		   SourceImages::generateShoeboxImages, and counts the different locations of the generic images
+	*/
+	void runShoebox();
+
+	/** \brief Measures the generation of the images of the example source in the example room by SourceImages::generateImages with
+	*		   and without parallel tasks, and by SourceImages::generateShoeboxImages, and checks that both generic ones are the same
+	*/
+	void runBuild();
+}
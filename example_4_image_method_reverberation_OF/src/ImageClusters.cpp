@@ -0,0 +1,107 @@
+#include "ImageClusters.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const float goldenRatio = 1.6180339887f;
+
+	// Vertices of the dodecahedron, not normalised
+	const float dodecahedron[IMAGE_CLUSTERS][3] = {
+		{ 1, 1, 1 }, { 1, 1, -1 }, { 1, -1, 1 }, { 1, -1, -1 }, { -1, 1, 1 }, { -1, 1, -1 }, { -1, -1, 1 }, { -1, -1, -1 },
+		{ 0, 1 / goldenRatio, goldenRatio }, { 0, 1 / goldenRatio, -goldenRatio }, { 0, -1 / goldenRatio, goldenRatio }, { 0, -1 / goldenRatio, -goldenRatio },
+		{ 1 / goldenRatio, goldenRatio, 0 }, { 1 / goldenRatio, -goldenRatio, 0 }, { -1 / goldenRatio, goldenRatio, 0 }, { -1 / goldenRatio, -goldenRatio, 0 },
+		{ goldenRatio, 0, 1 / goldenRatio }, { goldenRatio, 0, -1 / goldenRatio }, { -goldenRatio, 0, 1 / goldenRatio }, { -goldenRatio, 0, -1 / goldenRatio } };
+}
+
+void ImageClusters::setup(Binaural::CCore & core, int _bufferSize)
+{
+	bufferSize = _bufferSize;
+	centers.clear();
+	dsps.clear();
+	for (int c = 0; c < IMAGE_CLUSTERS; c++)
+	{
+		Common::CVector3 center(dodecahedron[c][0], dodecahedron[c][1], dodecahedron[c][2]);
+		float length = center.GetDistance();
+		centers.push_back(Common::CVector3(center.x / length, center.y / length, center.z / length));
+
+		shared_ptr<Binaural::CSingleSourceDSP> clusterDSP = core.CreateSingleSourceDSP();
+		clusterDSP->SetSpatializationMode(Binaural::TSpatializationMode::HighQuality);
+		clusterDSP->DisableNearFieldEffect();
+		clusterDSP->EnableAnechoicProcess();
+		clusterDSP->DisableDistanceAttenuationAnechoic();			// Applied by the gain of each source when it is mixed
+		clusterDSP->DisablePropagationDelay();						// Applied by the tap of each source
+		dsps.push_back(clusterDSP);
+	}
+	directions.assign(IMAGE_CLUSTERS, Common::CVector3(0, 0, 0));
+	lastDirections = centers;
+	mixes.assign(IMAGE_CLUSTERS, CMonoBuffer<float>(bufferSize, 0.0f));
+	mixed.assign(IMAGE_CLUSTERS, 0);
+	previouslyMixed.assign(IMAGE_CLUSTERS, 0);
+}
+
+int ImageClusters::findCluster(Common::CVector3 direction, int previousCluster)
+{
+	int closest = 0;
+	float closestCosine = -2.0f;
+	for (int c = 0; c < IMAGE_CLUSTERS; c++)
+	{
+		float cosine = centers[c].x * direction.x + centers[c].y * direction.y + centers[c].z * direction.z;
+		if (cosine > closestCosine)
+		{
+			closest = c;
+			closestCosine = cosine;
+		}
+	}
+	if (previousCluster >= 0 && previousCluster < IMAGE_CLUSTERS)
+	{
+		const Common::CVector3 & previous = centers[previousCluster];
+		float previousCosine = previous.x * direction.x + previous.y * direction.y + previous.z * direction.z;
+		if (previousCosine + IMAGE_CLUSTER_HYSTERESIS >= closestCosine) return previousCluster;
+	}
+	return closest;
+}
+
+CMonoBuffer<float> & ImageClusters::getMix(int cluster)
+{
+	mixed[cluster] = 1;
+	return mixes[cluster];
+}
+
+void ImageClusters::addDirection(int cluster, Common::CVector3 direction, float weight)
+{
+	directions[cluster].x += direction.x * weight;
+	directions[cluster].y += direction.y * weight;
+	directions[cluster].z += direction.z * weight;
+}
+
+int ImageClusters::process(Common::CVector3 listenerLocation, Common::CEarPair<CMonoBuffer<float>> & bufferOutput)
+{
+	Common::CEarPair<CMonoBuffer<float>> bufferProcessed;
+	int numberOfClusters = 0;
+	for (int c = 0; c < IMAGE_CLUSTERS; c++)
+	{
+		if (mixed[c] || previouslyMixed[c])
+		{
+			// Clusters without sources in this block keep their last direction while they ring out
+			float length = directions[c].GetDistance();
+			if (length > 0.0f) lastDirections[c] = Common::CVector3(directions[c].x / length, directions[c].y / length, directions[c].z / length);
+			Common::CVector3 direction = lastDirections[c];
+			Common::CTransform clusterPosition;
+			clusterPosition.SetPosition(Common::CVector3(listenerLocation.x + direction.x * IMAGE_CLUSTER_DISTANCE,
+														 listenerLocation.y + direction.y * IMAGE_CLUSTER_DISTANCE,
+														 listenerLocation.z + direction.z * IMAGE_CLUSTER_DISTANCE));
+			dsps[c]->SetSourceTransform(clusterPosition);
+			dsps[c]->SetBuffer(mixes[c]);
+			dsps[c]->ProcessAnechoic(bufferProcessed.left, bufferProcessed.right);
+			bufferOutput.left += bufferProcessed.left;
+			bufferOutput.right += bufferProcessed.right;
+			std::fill(mixes[c].begin(), mixes[c].end(), 0.0f);
+			numberOfClusters++;
+		}
+		previouslyMixed[c] = mixed[c];
+		mixed[c] = 0;
+		directions[c] = Common::CVector3(0, 0, 0);
+	}
+	return numberOfClusters;
+}
@@ -0,0 +1,80 @@
+/**
+* \class ImageClusters
+*
+* \brief Declaration of ImageClusters, a few source DSPs that render the images of a source grouped by their direction
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: SAVLab (Spatial Audio Virtual Laboratory) ||
+* \b Website:
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from Spanish Ministerio de Ciencia e Innovacin under the SAVLab project (PID2019-107854GB-I00)
+*
+*/#pragma once
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+#include <Common/Vector3.h>
+#include <vector>
+
+#define IMAGE_CLUSTERS 20							// Cells of the sphere of directions, one around each vertex of a dodecahedron
+#define IMAGE_CLUSTER_DISTANCE 1.0f					// Distance of the clusters to the listener, in meters, at which the toolkit does not attenuate them
+#define IMAGE_CLUSTER_HYSTERESIS 0.02f				// A source only moves to another cell if it is closer to its center by this cosine
+
+/** \details Images whose directions from the listener are close are heard as one source, so instead of a source DSP per image, the
+*			 sphere of directions is split into IMAGE_CLUSTERS cells and the images in each cell are mixed, with their own delays and gains,
+*			 by the taps of the delay line of their source (PropagationDelayLine::readInto) into the buffer of the cell. Each cell with
+*			 images is then rendered by one source DSP placed in the mean direction of its images, weighted by their gains. The number of
+*			 HRTF convolutions is bounded by the number of cells, and no image has a buffer of its own.
+*			 A cell whose images leave it is still rendered in the next block, so that they fade out of it and the convolution rings out.
+*/
+class ImageClusters
+{
+public:
+	ImageClusters() : bufferSize{ 0 } {}
+
+	/** \brief Creates the source DSPs of the clusters and allocates their buffers
+	*	\param [in] core core where the source DSPs are created
+	*	\param [in] _bufferSize size of the blocks mixed and rendered
+	*/
+	void setup(Binaural::CCore & core, int _bufferSize);
+
+	/** \brief Returns the cluster of a direction, the cell whose center is closest to it
+	*	\param [in] direction unit vector from the listener to the source
+	*	\param [in] previousCluster cluster of the source in the previous block, kept unless the direction is clearly closer to another one, or -1
+	*/
+	int findCluster(Common::CVector3 direction, int previousCluster);
+
+	/** \brief Returns the buffer where the sources of a cluster are mixed in this block, and marks the cluster to be rendered
+	*/
+	CMonoBuffer<float> & getMix(int cluster);
+
+	/** \brief Adds the direction of a source mixed into a cluster to the mean direction of the cluster
+	*	\param [in] direction unit vector from the listener to the source
+	*	\param [in] weight gain of the source
+	*/
+	void addDirection(int cluster, Common::CVector3 direction, float weight);
+
+	/** \brief Renders the clusters mixed in this block or the previous one, adds them to the output and clears their buffers
+	*	\param [in] listenerLocation location of the listener, around which the clusters are placed
+	*	\param [in,out] bufferOutput binaural output, to which the clusters are added
+	*	\retval number of clusters rendered
+	*/
+	int process(Common::CVector3 listenerLocation, Common::CEarPair<CMonoBuffer<float>> & bufferOutput);
+
+private:
+	int bufferSize;
+	std::vector<Common::CVector3> centers;					// Unit vectors
+	std::vector<Common::CVector3> directions;				// Sum of the directions of the sources of each cluster in this block, weighted by their gains
+	std::vector<Common::CVector3> lastDirections;			// Unit vector where each cluster was rendered last time
+	std::vector<CMonoBuffer<float>> mixes;
+	std::vector<char> mixed;								// Whether each cluster was mixed in this block
+	std::vector<char> previouslyMixed;						// And in the previous one
+	std::vector<shared_ptr<Binaural::CSingleSourceDSP>> dsps;
+};
@@ -0,0 +1,175 @@
+#include "NearFieldILD.h"
+#include <ILD/ILDCereal.h>
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NEAR_FIELD_SSE2
+#endif
+
+#define CELL_SIZE 20			// Five coefficients for each of the four lanes
+
+namespace
+{
+	// One sample of the biquad in a lane of a cell, in transposed direct form II
+	inline float filterLane(const float * coefficients, float * z1, float * z2, int lane, float x)
+	{
+		float y = coefficients[lane] * x + z1[lane];
+		z1[lane] = coefficients[4 + lane] * x - coefficients[12 + lane] * y + z2[lane];
+		z2[lane] = coefficients[8 + lane] * x - coefficients[16 + lane] * y;
+		return y;
+	}
+}
+
+bool NearFieldILD::setup(shared_ptr<Binaural::CListener> _listener, const std::string & ildFileName)
+{
+	listener = _listener;
+	table.clear();
+	if (!ILD::CreateFrom3dti_ILDNearFieldEffectTable(ildFileName, listener)) return false;
+
+	numberOfDistances = (int)std::round((NEAR_FIELD_MAX_DISTANCE - NEAR_FIELD_MIN_DISTANCE) / NEAR_FIELD_DISTANCE_STEP) + 1;
+	numberOfAzimuths = (int)std::round(180.0f / NEAR_FIELD_AZIMUTH_STEP) + 1;
+	table.resize((size_t)numberOfDistances * numberOfAzimuths * CELL_SIZE);
+
+	shared_ptr<Binaural::CILD> ild = listener->GetILD();
+	for (int i = 0; i < numberOfDistances; i++)
+	{
+		float distance = NEAR_FIELD_MIN_DISTANCE + i * NEAR_FIELD_DISTANCE_STEP;
+		for (int j = 0; j < numberOfAzimuths; j++)
+		{
+			float azimuth = -90.0f + j * NEAR_FIELD_AZIMUTH_STEP;
+			float * cell = &table[((size_t)i * numberOfAzimuths + j) * CELL_SIZE];
+			if (!setCoefficients(ild->GetILDNearFieldEffectCoefficients(Common::T_ear::LEFT, distance, azimuth), 0, cell) ||
+				!setCoefficients(ild->GetILDNearFieldEffectCoefficients(Common::T_ear::RIGHT, distance, azimuth), 1, cell))
+			{
+				table.clear();
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool NearFieldILD::setCoefficients(const std::vector<float> & coefficients, int ear, float * cell)
+{
+	// Two biquads per ear, given as b0, b1, b2, a1, a2 or as b0, b1, b2, a0, a1, a2
+	size_t sectionSize = coefficients.size() / 2;
+	if (coefficients.size() % 2 != 0 || (sectionSize != 5 && sectionSize != 6)) return false;
+
+	for (int section = 0; section < 2; section++)
+	{
+		const float * c = &coefficients[section * sectionSize];
+		float a0 = sectionSize == 6 ? c[3] : 1.0f;
+		if (a0 == 0.0f) return false;
+		int lane = section * 2 + ear;
+		cell[lane] = c[0] / a0;
+		cell[4 + lane] = c[1] / a0;
+		cell[8 + lane] = c[2] / a0;
+		cell[12 + lane] = c[sectionSize - 2] / a0;
+		cell[16 + lane] = c[sectionSize - 1] / a0;
+	}
+	return true;
+}
+
+void NearFieldILD::setEnabled(bool _enabled)
+{
+	enabled.store(_enabled);
+}
+
+bool NearFieldILD::isEnabled()
+{
+	return enabled.load();
+}
+
+bool NearFieldILD::isLoaded()
+{
+	return !table.empty();
+}
+
+size_t NearFieldILD::getSizeInBytes()
+{
+	return table.size() * sizeof(float);
+}
+
+void NearFieldILD::process(TState & state, const Common::CTransform & sourceTransform, Common::CEarPair<CMonoBuffer<float>> & buffer)
+{
+	if (!enabled.load() || table.empty()) { state.active = false; return; }
+
+	Common::CVector3 vectorToSource = listener->GetListenerTransform().GetVectorTo(sourceTransform);
+	float distance = vectorToSource.GetDistance();
+	if (distance >= NEAR_FIELD_MAX_DISTANCE) { state.active = false; return; }
+	float azimuth = distance > 0.0f ? vectorToSource.GetInterauralAzimuthDegrees() : 0.0f;
+
+	if (!state.active)
+	{
+		std::fill(state.z1, state.z1 + 4, 0.0f);
+		std::fill(state.z2, state.z2 + 4, 0.0f);
+		state.active = true;
+	}
+
+	float coefficients[CELL_SIZE];
+	interpolateCoefficients(distance, azimuth, coefficients);
+	filter(coefficients, state, buffer.left.data(), buffer.right.data(), (int)std::min(buffer.left.size(), buffer.right.size()));
+}
+
+void NearFieldILD::interpolateCoefficients(float distance, float azimuth, float * coefficients)
+{
+	float row = (std::max(distance, NEAR_FIELD_MIN_DISTANCE) - NEAR_FIELD_MIN_DISTANCE) / NEAR_FIELD_DISTANCE_STEP;
+	float column = (std::min(std::max(azimuth, -90.0f), 90.0f) + 90.0f) / NEAR_FIELD_AZIMUTH_STEP;
+	int i = std::min((int)row, numberOfDistances - 2);
+	int j = std::min((int)column, numberOfAzimuths - 2);
+	float wi = std::min(row - i, 1.0f);
+	float wj = std::min(column - j, 1.0f);
+
+	const float * c00 = &table[((size_t)i * numberOfAzimuths + j) * CELL_SIZE];
+	const float * c01 = c00 + CELL_SIZE;
+	const float * c10 = c00 + (size_t)numberOfAzimuths * CELL_SIZE;
+	const float * c11 = c10 + CELL_SIZE;
+	float w00 = (1.0f - wi) * (1.0f - wj), w01 = (1.0f - wi) * wj, w10 = wi * (1.0f - wj), w11 = wi * wj;
+	for (int k = 0; k < CELL_SIZE; k++)
+		coefficients[k] = w00 * c00[k] + w01 * c01[k] + w10 * c10[k] + w11 * c11[k];
+}
+
+void NearFieldILD::filter(const float * coefficients, TState & state, float * left, float * right, int size)
+{
+	if (size == 0) return;
+
+	// Lanes 0 and 1 run the first biquad of each ear on sample n, while lanes 2 and 3 run the second one on the output of the first
+	// for sample n - 1. The first biquad of sample 0 and the second one of the last sample are run alone, so the block is not delayed.
+	float pendingLeft = filterLane(coefficients, state.z1, state.z2, 0, left[0]);
+	float pendingRight = filterLane(coefficients, state.z1, state.z2, 1, right[0]);
+	int n = 1;
+
+#ifdef NEAR_FIELD_SSE2
+	const __m128 b0 = _mm_loadu_ps(coefficients), b1 = _mm_loadu_ps(coefficients + 4), b2 = _mm_loadu_ps(coefficients + 8);
+	const __m128 a1 = _mm_loadu_ps(coefficients + 12), a2 = _mm_loadu_ps(coefficients + 16);
+	__m128 z1 = _mm_loadu_ps(state.z1), z2 = _mm_loadu_ps(state.z2);
+	__m128 y = _mm_setr_ps(pendingLeft, pendingRight, 0.0f, 0.0f);
+	for (; n < size; n++)
+	{
+		__m128 input = _mm_unpacklo_ps(_mm_load_ss(left + n), _mm_load_ss(right + n));
+		__m128 x = _mm_shuffle_ps(input, y, _MM_SHUFFLE(1, 0, 1, 0));
+		y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+		z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+		z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+		_mm_store_ss(left + n - 1, _mm_movehl_ps(y, y));
+		_mm_store_ss(right + n - 1, _mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 3, 3)));
+	}
+	_mm_storeu_ps(state.z1, z1);
+	_mm_storeu_ps(state.z2, z2);
+	pendingLeft = _mm_cvtss_f32(y);
+	pendingRight = _mm_cvtss_f32(_mm_shuffle_ps(y, y, _MM_SHUFFLE(1, 1, 1, 1)));
+#endif
+
+	for (; n < size; n++)
+	{
+		float x[4] = { left[n], right[n], pendingLeft, pendingRight };
+		pendingLeft = filterLane(coefficients, state.z1, state.z2, 0, x[0]);
+		pendingRight = filterLane(coefficients, state.z1, state.z2, 1, x[1]);
+		left[n - 1] = filterLane(coefficients, state.z1, state.z2, 2, x[2]);
+		right[n - 1] = filterLane(coefficients, state.z1, state.z2, 3, x[3]);
+	}
+
+	left[size - 1] = filterLane(coefficients, state.z1, state.z2, 2, pendingLeft);
+	right[size - 1] = filterLane(coefficients, state.z1, state.z2, 3, pendingRight);
+}
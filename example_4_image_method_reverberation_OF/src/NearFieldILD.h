@@ -0,0 +1,89 @@
+/**
+* \class NearFieldILD
+*
+* \brief Declaration of NearFieldILD, which applies the near field effect to the sources with a precomputed table of ILD filters
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: SAVLab (Spatial Audio Virtual Laboratory) ||
+* \b Website:
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from Spanish Ministerio de Ciencia e Innovacin under the SAVLab project (PID2019-107854GB-I00)
+*
+*/
+#pragma once
+#include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
+#include <Common/Transform.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#define NEAR_FIELD_MIN_DISTANCE 0.1f			// Closer sources get the filters of this distance, in meters
+#define NEAR_FIELD_MAX_DISTANCE 1.95f			// Farther sources are not filtered, as the effect is negligible there, in meters
+#define NEAR_FIELD_DISTANCE_STEP 0.05f			// Distance between two rows of the table, in meters
+#define NEAR_FIELD_AZIMUTH_STEP 5.0f			// Interaural azimuth between two columns of the table, in degrees
+
+/** \details The near field effect of the toolkit (EnableNearFieldEffect) looks up the ILD coefficients of each source in a hash table
+*			 and runs two biquads per ear with their own filter objects, once per source DSP. Here, the table loaded from the
+*			 .3dti-ild file is sampled once in setup into a dense grid of interaural azimuth and distance, so that the coefficients of
+*			 a source are obtained by bilinear interpolation of four cells without hashing or allocation. The two biquads of both ears
+*			 are then run together in the four lanes of one SSE register, the second biquad one sample behind the first.
+*/
+class NearFieldILD
+{
+public:
+	/** \brief Filter state of one source
+	*/
+	struct TState
+	{
+		TState() : active{ false } {}
+		float z1[4];										// Transposed direct form II state of the first and second biquad of each ear
+		float z2[4];
+		bool active;										// False if the source was not filtered in its last block, so the state must be cleared
+	};
+
+	NearFieldILD() : enabled{ true }, numberOfDistances{ 0 }, numberOfAzimuths{ 0 } {}
+
+	/** \brief Loads the near field ILD table of a listener and precomputes the filter grid from it
+	*	\param [in] _listener listener whose position and orientation are used to find the distance and azimuth of the sources
+	*	\param [in] ildFileName name of the near field .3dti-ild file
+	*	\retval true if the table was loaded. Otherwise, process leaves the buffers untouched.
+	*/
+	bool setup(shared_ptr<Binaural::CListener> _listener, const std::string & ildFileName);
+
+	/** \brief Applies the near field effect to the output of a source DSP
+	*	\param [in,out] state filter state of the source
+	*	\param [in] sourceTransform position of the source
+	*	\param [in,out] buffer binaural output of the source, filtered in place
+	*/
+	void process(TState & state, const Common::CTransform & sourceTransform, Common::CEarPair<CMonoBuffer<float>> & buffer);
+
+	/** \brief Switches the effect on and off. It may be called from the main thread while the audio thread processes.
+	*/
+	void setEnabled(bool _enabled);
+	bool isEnabled();
+	bool isLoaded();
+
+	/** \brief Returns the memory used by the precomputed grid, in bytes
+	*/
+	size_t getSizeInBytes();
+
+private:
+	bool setCoefficients(const std::vector<float> & coefficients, int ear, float * cell);
+	void interpolateCoefficients(float distance, float azimuth, float * coefficients);
+	void filter(const float * coefficients, TState & state, float * left, float * right, int size);
+
+	shared_ptr<Binaural::CListener> listener;
+	std::vector<float> table;								// b0, b1, b2, a1 and a2 of each cell, for the lanes left 1, right 1, left 2 and right 2
+	std::atomic<bool> enabled;								// Switched by the main thread and read by the audio thread
+	int numberOfDistances;
+	int numberOfAzimuths;
+};
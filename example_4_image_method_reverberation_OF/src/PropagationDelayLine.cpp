@@ -0,0 +1,139 @@
+#include "PropagationDelayLine.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PROPAGATION_DELAY_SSE2
+#endif
+
+#define MIN_DELAY 2.0f			// The interpolation reads two samples after the delayed position, which must have been written
+
+void PropagationDelayLine::setup(int _sampleRate, int _bufferSize, float maxDistance)
+{
+	sampleRate = _sampleRate;
+	bufferSize = _bufferSize;
+	size_t size = 1;
+	while (size < (size_t)std::ceil(maxDistance / SOUND_SPEED * sampleRate) + bufferSize + 4) size *= 2;
+	ring.assign(size, 0.0f);
+	mask = (unsigned long)size - 1;
+	writePosition = 0;
+	blockCount = 0;
+	output.assign(bufferSize, 0.0f);
+}
+
+void PropagationDelayLine::write(const CMonoBuffer<float> & input)
+{
+	for (size_t n = 0; n < input.size(); n++)
+		ring[(writePosition + n) & mask] = input[n];
+	writePosition += (unsigned long)input.size();
+	bufferSize = (int)input.size();
+	blockCount++;
+}
+
+float PropagationDelayLine::getMaxDelay()
+{
+	return (float)ring.size() - bufferSize - 4;
+}
+
+size_t PropagationDelayLine::getSizeInBytes()
+{
+	return ring.size() * sizeof(float);
+}
+
+const CMonoBuffer<float> & PropagationDelayLine::read(TTap & tap, float distance)
+{
+	float targetDelay = std::min(std::max(distance / SOUND_SPEED * sampleRate, MIN_DELAY), getMaxDelay());
+	if (tap.nextBlock != blockCount) tap.delay = targetDelay;			// New or silent tap, there is no previous delay to glide from
+	float delayStep = (targetDelay - tap.delay) / bufferSize;
+
+	output.resize(bufferSize);
+	interpolate(tap.delay + delayStep, delayStep, output.data());
+	tap.delay = targetDelay;
+	tap.gain = 1.0f;
+	tap.nextBlock = blockCount + 1;
+	return output;
+}
+
+void PropagationDelayLine::readInto(TTap & tap, float distance, float gain, CMonoBuffer<float> & mix, CMonoBuffer<float> * previousMix)
+{
+	bool continued = tap.nextBlock == blockCount;
+	float previousGain = continued ? tap.gain : 0.0f;					// New or silent taps fade in
+	read(tap, distance);
+
+	// The delayed block is left in output, which is then added to the mixes with gains moving linearly along the block
+	int size = std::min(bufferSize, (int)mix.size());
+	if (continued && previousMix != nullptr)
+	{
+		size = std::min(size, (int)previousMix->size());
+		float fadeStep = 1.0f / bufferSize;
+		for (int n = 0; n < size; n++)
+		{
+			float fade = (n + 1) * fadeStep;
+			mix[n] += fade * gain * output[n];
+			(*previousMix)[n] += (1.0f - fade) * previousGain * output[n];
+		}
+	}
+	else
+	{
+		float gainStep = (gain - previousGain) / bufferSize;
+		for (int n = 0; n < size; n++) mix[n] += (previousGain + (n + 1) * gainStep) * output[n];
+	}
+	tap.gain = gain;
+}
+
+void PropagationDelayLine::interpolate(float firstDelay, float delayStep, float * out)
+{
+	// Sample n of the block is at writePosition - bufferSize + n, and is read at that position minus its delay. The position is split
+	// into an integer part, relative to the start of the block, and a fraction used by the Lagrange polynomial through four samples.
+	unsigned long blockStart = writePosition - bufferSize;
+	int n = 0;
+
+#ifdef PROPAGATION_DELAY_SSE2
+	const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), half = _mm_set1_ps(0.5f), sixth = _mm_set1_ps(1.0f / 6.0f);
+	for (; n + 4 <= bufferSize; n += 4)
+	{
+		__m128 index = _mm_setr_ps((float)n, (float)(n + 1), (float)(n + 2), (float)(n + 3));
+		__m128 delay = _mm_add_ps(_mm_set1_ps(firstDelay), _mm_mul_ps(index, _mm_set1_ps(delayStep)));
+		__m128 position = _mm_sub_ps(index, delay);
+
+		// Floor, as the truncation rounds negative positions up
+		__m128i truncated = _mm_cvttps_epi32(position);
+		__m128 truncatedFloat = _mm_cvtepi32_ps(truncated);
+		__m128 correction = _mm_and_ps(_mm_cmpgt_ps(truncatedFloat, position), one);
+		__m128 floorFloat = _mm_sub_ps(truncatedFloat, correction);
+		__m128 f = _mm_sub_ps(position, floorFloat);
+		int integer[4];
+		_mm_storeu_si128((__m128i *)integer, _mm_cvtps_epi32(floorFloat));
+
+		// Coefficients of the samples at floor - 1, floor, floor + 1 and floor + 2
+		__m128 fPlusOne = _mm_add_ps(f, one), fMinusOne = _mm_sub_ps(f, one), fMinusTwo = _mm_sub_ps(f, two);
+		__m128 c0 = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(f, fMinusOne), fMinusTwo), _mm_sub_ps(_mm_setzero_ps(), sixth));
+		__m128 c1 = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(fPlusOne, fMinusOne), fMinusTwo), half);
+		__m128 c2 = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(fPlusOne, f), fMinusTwo), _mm_sub_ps(_mm_setzero_ps(), half));
+		__m128 c3 = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(fPlusOne, f), fMinusOne), sixth);
+
+		float x[4][4];
+		for (int lane = 0; lane < 4; lane++)
+		{
+			unsigned long base = blockStart + integer[lane] - 1;
+			for (int k = 0; k < 4; k++) x[k][lane] = ring[(base + k) & mask];
+		}
+		__m128 y = _mm_mul_ps(c0, _mm_loadu_ps(x[0]));
+		y = _mm_add_ps(y, _mm_mul_ps(c1, _mm_loadu_ps(x[1])));
+		y = _mm_add_ps(y, _mm_mul_ps(c2, _mm_loadu_ps(x[2])));
+		y = _mm_add_ps(y, _mm_mul_ps(c3, _mm_loadu_ps(x[3])));
+		_mm_storeu_ps(out + n, y);
+	}
+#endif
+
+	for (; n < bufferSize; n++)
+	{
+		float position = n - (firstDelay + n * delayStep);
+		float floorPosition = std::floor(position);
+		float f = position - floorPosition;
+		unsigned long base = blockStart + (int)floorPosition - 1;
+		float x0 = ring[base & mask], x1 = ring[(base + 1) & mask], x2 = ring[(base + 2) & mask], x3 = ring[(base + 3) & mask];
+		out[n] = -f * (f - 1.0f) * (f - 2.0f) / 6.0f * x0 + (f + 1.0f) * (f - 1.0f) * (f - 2.0f) / 2.0f * x1
+			   - (f + 1.0f) * f * (f - 2.0f) / 2.0f * x2 + (f + 1.0f) * f * (f - 1.0f) / 6.0f * x3;
+	}
+}
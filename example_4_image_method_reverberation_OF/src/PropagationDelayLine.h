@@ -0,0 +1,98 @@
+/**
+* \class PropagationDelayLine
+*
+* \brief Declaration of PropagationDelayLine, a ring buffer shared by the original source and all its images to apply their propagation delays
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: SAVLab (Spatial Audio Virtual Laboratory) ||
+* \b Website:
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from Spanish Ministerio de Ciencia e Innovacin under the SAVLab project (PID2019-107854GB-I00)
+*
+*/
+#pragma once
+#include <Common/Buffer.h>
+#include <vector>
+
+#define SOUND_SPEED 343.0f			// Speed of sound used by the toolkit by default, in m/s
+
+/** \details All the images of a source play the same signal with different delays, so instead of one delay line per source DSP
+*			 (EnablePropagationDelay), the input is written once per block into a ring buffer and each source reads it through its own tap.
+*			 A tap only keeps its current delay, so the memory does not grow with the number of images: the ring buffer is sized once for
+*			 the longest path allowed, as a power of two so that positions wrap with a mask. Longer paths are clamped to it.
+*			 Delays are read with third order Lagrange interpolation. When the path of a source changes, its delay moves linearly from
+*			 the value of the previous block to the new one along the block, sample by sample, which gives a smooth Doppler shift
+*			 instead of a click.
+*/
+class PropagationDelayLine
+{
+public:
+	/** \brief State of one source reading the delay line
+	*/
+	struct TTap
+	{
+		TTap() : delay{ 0.0f }, gain{ 1.0f }, nextBlock{ 0 } {}
+		float delay;										// Delay reached at the end of the last block read, in samples
+		float gain;											// Gain reached at the end of the last block mixed by readInto, 1 if it was read by read
+		unsigned long nextBlock;							// Block in which the tap must be read again to keep gliding from that delay
+	};
+
+	/** \brief Allocates the ring buffer
+	*	\param [in] _sampleRate sample rate, in Hz
+	*	\param [in] _bufferSize size of the blocks written and read
+	*	\param [in] maxDistance longest path from a source to the listener, in meters
+	*/
+	void setup(int _sampleRate, int _bufferSize, float maxDistance);
+
+	/** \brief Writes the next block of the input signal. To be called once per block, before reading it.
+	*/
+	void write(const CMonoBuffer<float> & input);
+
+	/** \brief Reads the last block written, delayed by the propagation time of a path
+	*	\details If the tap was not read in the previous block, its delay jumps to the new one instead of gliding from an old value.
+	*	\param [in,out] tap state of the source
+	*	\param [in] distance length of the path from the source to the listener, in meters
+	*	\retval delayed block, valid until the next call to read
+	*/
+	const CMonoBuffer<float> & read(TTap & tap, float distance);
+
+	/** \brief Reads the last block written, delayed by the propagation time of a path, and adds it with a gain to a mix of several taps
+	*	\details The gain glides along the block from the one of the previous block, as the delay does. If the tap was mixed into another
+	*			 buffer in the previous block, it fades out of that buffer while it fades into the new one, so that a tap can move between
+	*			 mixes without a click. If the tap was not read in the previous block, its delay jumps to the new one and it fades in from silence.
+	*	\param [in,out] tap state of the source
+	*	\param [in] distance length of the path from the source to the listener, in meters
+	*	\param [in] gain gain of the source
+	*	\param [in,out] mix buffer of the size of the blocks where the tap is added
+	*	\param [in,out] previousMix buffer where the tap was added in the previous block, if it was another one, or null
+	*/
+	void readInto(TTap & tap, float distance, float gain, CMonoBuffer<float> & mix, CMonoBuffer<float> * previousMix = nullptr);
+
+	/** \brief Returns the longest delay that can be applied, in samples
+	*/
+	float getMaxDelay();
+
+	/** \brief Returns the memory used by the ring buffer, in bytes
+	*/
+	size_t getSizeInBytes();
+
+private:
+	void interpolate(float firstDelay, float delayStep, float * out);
+
+	std::vector<float> ring;								// Last samples of the input, a power of two
+	unsigned long mask;										// ring.size() - 1
+	unsigned long writePosition;							// Samples written since setup, the newest one is at writePosition - 1
+	unsigned long blockCount;								// Blocks written since setup
+	int sampleRate;
+	int bufferSize;
+	CMonoBuffer<float> output;								// Result of the last read
+};
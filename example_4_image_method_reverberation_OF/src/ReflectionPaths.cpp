@@ -0,0 +1,168 @@
+#include "ReflectionPaths.h"
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define REFLECTION_PATHS_SSE2
+#endif
+
+#ifndef THRESHOLD
+#define THRESHOLD 0.000001f				// Same tolerance as Wall.cpp
+#endif
+
+void ReflectionPaths::addImage(Common::CVector3 location, Wall & reflectionWall)
+{
+	size_t image = locationX.size();
+	locationX.push_back(location.x);
+	locationY.push_back(location.y);
+	locationZ.push_back(location.z);
+
+	float a, b, c, d;
+	reflectionWall.getPlane(a, b, c, d);
+	planeA.push_back(a);
+	planeB.push_back(b);
+	planeC.push_back(c);
+	planeD.push_back(d);
+
+	int u, v;
+	std::vector<float> edgesA, edgesB, edgesC;
+	bool convex = reflectionWall.getEdgeFunctions(u, v, edgesA, edgesB, edgesC);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		projectionU[axis].push_back(axis == u ? 1.0f : 0.0f);
+		projectionV[axis].push_back(axis == v ? 1.0f : 0.0f);
+	}
+
+	// Walls that do not fit are tested one by one after the sweep, which then must not reject their points
+	bool swept = convex && edgesA.size() <= REFLECTION_PATHS_MAX_EDGES;
+	for (size_t k = 0; k < REFLECTION_PATHS_MAX_EDGES; k++)
+	{
+		bool edge = swept && k < edgesA.size();
+		edgeA[k].push_back(edge ? edgesA[k] : 0.0f);
+		edgeB[k].push_back(edge ? edgesB[k] : 0.0f);
+		edgeC[k].push_back(edge ? edgesC[k] : 1.0f);
+	}
+	if (!swept) otherWalls.push_back(std::make_pair(image, reflectionWall));
+}
+
+void ReflectionPaths::reserve(size_t numberOfImages)
+{
+	for (std::vector<float> * array : { &locationX, &locationY, &locationZ, &planeA, &planeB, &planeC, &planeD }) array->reserve(numberOfImages);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		projectionU[axis].reserve(numberOfImages);
+		projectionV[axis].reserve(numberOfImages);
+	}
+	for (size_t k = 0; k < REFLECTION_PATHS_MAX_EDGES; k++)
+	{
+		edgeA[k].reserve(numberOfImages);
+		edgeB[k].reserve(numberOfImages);
+		edgeC[k].reserve(numberOfImages);
+	}
+}
+
+void ReflectionPaths::setLocation(size_t image, Common::CVector3 location)
+{
+	locationX[image] = location.x;
+	locationY[image] = location.y;
+	locationZ[image] = location.z;
+}
+
+Common::CVector3 ReflectionPaths::getLocation(size_t image) const
+{
+	return Common::CVector3(locationX[image], locationY[image], locationZ[image]);
+}
+
+size_t ReflectionPaths::size() const
+{
+	return locationX.size();
+}
+
+void ReflectionPaths::compute(Common::CVector3 listenerLocation, size_t numberOfImages, TResults & results)
+{
+	if (results.visible.size() < numberOfImages)
+	{
+		results.reflectionX.resize(numberOfImages);
+		results.reflectionY.resize(numberOfImages);
+		results.reflectionZ.resize(numberOfImages);
+		results.pathLengths.resize(numberOfImages);
+		results.visible.resize(numberOfImages);
+	}
+
+	size_t i = 0;
+#ifdef REFLECTION_PATHS_SSE2
+	// Same operations, in the same order, as computeScalar, so both give the same results
+	const __m128 listenerX = _mm_set1_ps(listenerLocation.x), listenerY = _mm_set1_ps(listenerLocation.y), listenerZ = _mm_set1_ps(listenerLocation.z);
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+	const __m128 threshold = _mm_set1_ps(THRESHOLD), minusThreshold = _mm_set1_ps(-THRESHOLD);
+	for (; i + 4 <= numberOfImages; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&locationX[i]), y = _mm_loadu_ps(&locationY[i]), z = _mm_loadu_ps(&locationZ[i]);
+		__m128 a = _mm_loadu_ps(&planeA[i]), b = _mm_loadu_ps(&planeB[i]), c = _mm_loadu_ps(&planeC[i]), d = _mm_loadu_ps(&planeD[i]);
+
+		// Line from the image to the listener, and its intersection with the plane
+		__m128 lineX = _mm_sub_ps(listenerX, x), lineY = _mm_sub_ps(listenerY, y), lineZ = _mm_sub_ps(listenerZ, z);
+		__m128 lambda = _mm_sub_ps(_mm_xor_ps(d, signBit), _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, y)), _mm_mul_ps(c, z)));
+		lambda = _mm_div_ps(lambda, _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, lineX), _mm_mul_ps(b, lineY)), _mm_mul_ps(c, lineZ)));
+		__m128 pointX = _mm_add_ps(x, _mm_mul_ps(lambda, lineX));
+		__m128 pointY = _mm_add_ps(y, _mm_mul_ps(lambda, lineY));
+		__m128 pointZ = _mm_add_ps(z, _mm_mul_ps(lambda, lineZ));
+
+		// The point must be on the plane, which also rejects lines parallel to it, and inside every edge
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, pointX), _mm_mul_ps(b, pointY)), _mm_mul_ps(c, pointZ)), d);
+		__m128 inside = _mm_cmple_ps(_mm_andnot_ps(signBit, distance), threshold);
+		__m128 u = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&projectionU[0][i]), pointX), _mm_mul_ps(_mm_loadu_ps(&projectionU[1][i]), pointY)),
+							  _mm_mul_ps(_mm_loadu_ps(&projectionU[2][i]), pointZ));
+		__m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&projectionV[0][i]), pointX), _mm_mul_ps(_mm_loadu_ps(&projectionV[1][i]), pointY)),
+							  _mm_mul_ps(_mm_loadu_ps(&projectionV[2][i]), pointZ));
+		for (int k = 0; k < REFLECTION_PATHS_MAX_EDGES; k++)
+		{
+			__m128 edge = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&edgeA[k][i]), u), _mm_mul_ps(_mm_loadu_ps(&edgeB[k][i]), v)), _mm_loadu_ps(&edgeC[k][i]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, minusThreshold));
+		}
+
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lineX, lineX), _mm_mul_ps(lineY, lineY)), _mm_mul_ps(lineZ, lineZ)));
+
+		_mm_storeu_ps(&results.reflectionX[i], pointX);
+		_mm_storeu_ps(&results.reflectionY[i], pointY);
+		_mm_storeu_ps(&results.reflectionZ[i], pointZ);
+		_mm_storeu_ps(&results.pathLengths[i], length);
+		int mask = _mm_movemask_ps(inside);
+		for (int k = 0; k < 4; k++) results.visible[i + k] = (mask >> k) & 1;
+	}
+#endif
+	computeScalar(listenerLocation, i, numberOfImages, results);
+
+	for (std::pair<size_t, Wall> & other : otherWalls)
+	{
+		size_t image = other.first;
+		if (image >= numberOfImages) continue;
+		results.visible[image] = other.second.checkPointInsideWall(Common::CVector3(results.reflectionX[image], results.reflectionY[image], results.reflectionZ[image]));
+	}
+}
+
+void ReflectionPaths::computeScalar(Common::CVector3 listenerLocation, size_t begin, size_t end, TResults & results)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		float x = locationX[i], y = locationY[i], z = locationZ[i];
+		float a = planeA[i], b = planeB[i], c = planeC[i], d = planeD[i];
+
+		float lineX = listenerLocation.x - x, lineY = listenerLocation.y - y, lineZ = listenerLocation.z - z;
+		float lambda = (-d - (a * x + b * y + c * z)) / (a * lineX + b * lineY + c * lineZ);
+		float pointX = x + lambda * lineX;
+		float pointY = y + lambda * lineY;
+		float pointZ = z + lambda * lineZ;
+
+		bool inside = std::fabs(a * pointX + b * pointY + c * pointZ + d) <= THRESHOLD;
+		float u = projectionU[0][i] * pointX + projectionU[1][i] * pointY + projectionU[2][i] * pointZ;
+		float v = projectionV[0][i] * pointX + projectionV[1][i] * pointY + projectionV[2][i] * pointZ;
+		for (int k = 0; k < REFLECTION_PATHS_MAX_EDGES; k++)
+			inside = inside && edgeA[k][i] * u + edgeB[k][i] * v + edgeC[k][i] >= -THRESHOLD;
+
+		results.reflectionX[i] = pointX;
+		results.reflectionY[i] = pointY;
+		results.reflectionZ[i] = pointZ;
+		results.pathLengths[i] = std::sqrt(lineX * lineX + lineY * lineY + lineZ * lineZ);
+		results.visible[i] = inside;
+	}
+}
@@ -0,0 +1,92 @@
+/**
+* \class ReflectionPaths
+*
+* \brief Declaration of ReflectionPaths, which computes the reflection paths of all the image sources of a source in one sweep
+* \date	October 2026
+*
+* \authors Members of the 3DI-DIANA Research Group (University of Malaga)
+* \b Contact: A. Reyes-Lecuona as head of 3DI-DIANA Research Group (University of Malaga): areyes@uma.es
+*
+* \b Contributions: (additional authors/contributors can be added here)
+*
+* \b Project: SAVLab (Spatial Audio Virtual Laboratory) ||
+* \b Website:
+*
+* \b Copyright: University of Malaga - 2026
+*
+* \b Licence: GPLv3
+*
+* \b Acknowledgement: This project has received funding from Spanish Ministerio de Ciencia e Innovacin under the SAVLab project (PID2019-107854GB-I00)
+*
+*/
+#pragma once
+#include "Wall.h"
+#include <Common/Vector3.h>
+#include <utility>
+#include <vector>
+
+#define REFLECTION_PATHS_MAX_EDGES 4			// Edges of the walls tested in the sweep. Walls with more edges, or not convex, are tested one by one.
+
+/** \details The visibility of an image is the same test for all of them: the intersection of the line from the image to the listener
+*			 with the reflection wall of the image, and whether that point is inside the wall. Here the locations of the images, the planes
+*			 of their reflection walls and the edge functions of those walls projected onto a coordinate plane are kept in separate arrays
+*			 (structure of arrays), so that the test runs on four images at a time with SSE2, with no branches. The coordinate plane of
+*			 each wall is selected by multiplying the intersection point by one-hot weights, and walls with fewer edges are padded with
+*			 edges that every point is inside of. The results match Wall::getIntersectionPointWithLine and Wall::checkPointInsideWall.
+*/
+class ReflectionPaths
+{
+public:
+	/** \brief Paths of the images to one listener position, one element per image
+	*/
+	struct TResults
+	{
+		std::vector<float> reflectionX;						// Point where the path of each image crosses the plane of its reflection wall
+		std::vector<float> reflectionY;
+		std::vector<float> reflectionZ;
+		std::vector<float> pathLengths;						// Distance from each image to the listener, which is the length of its reflected path, in meters
+		std::vector<char> visible;							// Whether the crossing point is inside the reflection wall
+	};
+
+	/** \brief Adds an image at the end
+	*	\param [in] location location of the image
+	*	\param [in] reflectionWall wall where the path of the image is reflected
+	*/
+	void addImage(Common::CVector3 location, Wall & reflectionWall);
+
+	/** \brief Allocates the arrays for a number of images, so that adding them does not reallocate
+	*/
+	void reserve(size_t numberOfImages);
+
+	/** \brief Moves an image
+	*/
+	void setLocation(size_t image, Common::CVector3 location);
+
+	Common::CVector3 getLocation(size_t image) const;
+	size_t size() const;
+
+	/** \brief Computes the paths of the first images to a listener
+	*	\details The results are resized if they are smaller than the number of images, otherwise nothing is allocated.
+	*	\param [in] listenerLocation location of the listener
+	*	\param [in] numberOfImages number of images computed, from the first one
+	*	\param [out] results paths of the images. Elements after numberOfImages are not written.
+	*/
+	void compute(Common::CVector3 listenerLocation, size_t numberOfImages, TResults & results);
+
+private:
+	void computeScalar(Common::CVector3 listenerLocation, size_t begin, size_t end, TResults & results);
+
+	std::vector<float> locationX;							// Location of each image
+	std::vector<float> locationY;
+	std::vector<float> locationZ;
+	std::vector<float> planeA;								// Plane of the reflection wall of each image, Ax + By + Cz + D = 0
+	std::vector<float> planeB;
+	std::vector<float> planeC;
+	std::vector<float> planeD;
+	std::vector<float> projectionU[3];						// Weights of x, y and z in the coordinates of the projected wall, 1 for the coordinate kept and 0 for the others
+	std::vector<float> projectionV[3];
+	std::vector<float> edgeA[REFLECTION_PATHS_MAX_EDGES];	// Edge functions of each projected wall, see Wall::getEdgeFunctions
+	std::vector<float> edgeB[REFLECTION_PATHS_MAX_EDGES];
+	std::vector<float> edgeC[REFLECTION_PATHS_MAX_EDGES];
+	std::vector<std::pair<size_t, Wall>> otherWalls;		// Images whose wall is not tested in the sweep, with that wall
+};
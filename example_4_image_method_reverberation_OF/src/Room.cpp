@@ -35,19 +35,40 @@ void Room::setup(float width, float length, float height)
 	ceiling.insertCorner(length / 2, width / 2, height / 2);
 	insertWall(ceiling);
 
-
+	shoebox = walls.size() == 6;
+	shoeboxWidth = width;
+	shoeboxLength = length;
+	shoeboxHeight = height;
 }
 
 void Room::insertWall(Wall _newWall)
 {
 	walls.push_back(_newWall);
+	shoebox = false;
 }
 
-std::vector<Wall> Room::getWalls()
+const std::vector<Wall> & Room::getWalls() const
 {
 	return walls;
 }
 
+void Room::setAbsortion(float absortion)
+{
+	for (Wall & wall : walls) wall.setAbsortion(absortion);
+}
+
+bool Room::isShoebox() const
+{
+	return shoebox;
+}
+
+void Room::getShoeboxDimensions(float & width, float & length, float & height) const
+{
+	width = shoeboxWidth;
+	length = shoeboxLength;
+	height = shoeboxHeight;
+}
+
 std::vector<Room> Room::getImageRooms()
 {
 	std::vector<Room> roomList;
@@ -47,7 +47,20 @@ public:
 	/** \brief Returns a vector of walls containing all the walls of the room.
 	*	\param [out] Walls: vector of walls with all the walls of the room.
 	*/
-	std::vector<Wall> getWalls();
+	const std::vector<Wall> & getWalls() const;
+
+	/** \brief Sets the same absorption to all the walls of the room
+	*	\param [in] absortion: fraction of the energy of the sound absorbed by each reflection, between 0 and 1.
+	*/
+	void setAbsortion(float absortion);
+
+	/** \brief Returns whether the room is the shoebox created by setup, with no other walls
+	*/
+	bool isShoebox() const;
+
+	/** \brief Returns the dimensions given to setup. They are only meaningful if the room is a shoebox.
+	*/
+	void getShoeboxDimensions(float & width, float & length, float & height) const;
 
 	/** \brief Returns a vector of image rooms
 	*	\details creates an image (specular) room for each wall of this room and returns a vector contoining them.
@@ -66,5 +79,9 @@ private:
 	////////////
 
 	std::vector<Wall> walls;            //Vector with all the walls of the room
+	bool shoebox = false;               //Whether the walls are only the ones created by setup
+	float shoeboxWidth = 0;             //Dimensions given to setup
+	float shoeboxLength = 0;
+	float shoeboxHeight = 0;
 };
 
@@ -1,18 +1,194 @@
 #include "SourceImages.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+#ifndef THRESHOLD
+#define THRESHOLD 0.000001f				// Same tolerance as Wall.cpp
+#endif
+
+#define IMAGE_LOCATION_TOLERANCE 0.0001f		// Images closer than this, in metres, are at the same location
+#define IMAGE_BUCKET_SIZE 0.001f				// Side of the cubes of space in which the images are bucketed to find duplicates
+#define IMAGE_TASKS_MIN_ORDER 3					// Lower orders have too few images to pay for starting a task per branch
+#define MIXED_IMAGE_MIN_DISTANCE 0.1f			// Images mixed into the clusters or the ambisonic bus with shorter paths are attenuated as if they were this far, in meters
+#define IMAGE_DSP_KEEP_MARGIN 1.4125f			// An image keeps its source DSP unless an image without one is 3 dB louder
+
+namespace
+{
+	// Reflection of a point on the plane ax + by + cz + d = 0, with (a, b, c) a unit vector, whichever side of it the point is
+	Common::CVector3 reflectPoint(const float plane[4], Common::CVector3 point)
+	{
+		float distance = plane[0] * point.x + plane[1] * point.y + plane[2] * point.z + plane[3];
+		return Common::CVector3(point.x - 2 * distance * plane[0], point.y - 2 * distance * plane[1], point.z - 2 * distance * plane[2]);
+	}
+
+	// Key of the bucket at some integer coordinates, 21 bits each
+	long long getBucketKey(long long x, long long y, long long z)
+	{
+		return ((x & 0x1FFFFF) << 42) | ((y & 0x1FFFFF) << 21) | (z & 0x1FFFFF);
+	}
+
+	long long getBucketCoordinate(float coordinate)
+	{
+		return (long long)std::floor(coordinate / IMAGE_BUCKET_SIZE);
+	}
+
+	bool isSameLocation(Common::CVector3 a, Common::CVector3 b)
+	{
+		return std::fabs(a.x - b.x) <= IMAGE_LOCATION_TOLERANCE && std::fabs(a.y - b.y) <= IMAGE_LOCATION_TOLERANCE &&
+			   std::fabs(a.z - b.z) <= IMAGE_LOCATION_TOLERANCE;
+	}
+
+	// Images of three points around the source through the same walls as an image. Two images at the same location are the same
+	// image for any location of the source only if these points are at the same locations too.
+	const Common::CVector3 probeOffsets[3] = { Common::CVector3(1, 0, 0), Common::CVector3(0, 1, 0), Common::CVector3(0, 0, 1) };
+
+	// The first-order image on one wall and all its descendants, stored by reflection order in arrays owned by the task that generates them.
+	// Parents are indices in these arrays, or -1 for the first-order image.
+	struct TBranch
+	{
+		std::vector<Common::CVector3> locations;
+		std::vector<Common::CVector3> probes;							// Three per image
+		std::vector<int> parents;
+		std::vector<int> wallIndices;
+		std::vector<Wall> reflectionWalls;
+		std::vector<float> reflectionGains;
+		std::vector<char> valid;
+		std::vector<size_t> orderEnds;
+		std::vector<size_t> invalidImages;
+		std::vector<size_t> inaudibleImages;
+	};
+
+	// Fraction of the amplitude of a sound reflected by a wall, from the fraction of its energy absorbed
+	float getReflectionGain(Wall & wall)
+	{
+		return std::sqrt(1.0f - std::min(std::max(wall.getAbsortion(), 0.0f), 1.0f));
+	}
+
+	void generateBranch(const std::vector<Wall> & walls, size_t firstWall, Common::CVector3 sourceLocation, int reflectionOrder, float minimumGain, TBranch & branch)
+	{
+		size_t numberOfWalls = walls.size();
+
+		// The branch has at most 5^(n-1) images of order n when the room is convex, as the wall of the last reflection is skipped
+		size_t capacity = 0;
+		for (size_t order = 1, numberOfImages = 1; order <= (size_t)reflectionOrder; order++, numberOfImages *= numberOfWalls - 1) capacity += numberOfImages;
+		branch.locations.reserve(capacity);
+		branch.probes.reserve(3 * capacity);
+		branch.parents.reserve(capacity);
+		branch.wallIndices.reserve(capacity);
+		branch.reflectionWalls.reserve(capacity);
+		branch.reflectionGains.reserve(capacity);
+		branch.valid.reserve(capacity);
+		std::vector<Wall> roomWalls = walls;
+
+		Common::CVector3 sourceProbes[3];
+		for (int k = 0; k < 3; k++) sourceProbes[k] = sourceLocation + probeOffsets[k];
+
+		// Walls of the image room of each image of the previous order, numberOfWalls per image. The original source is in the room itself.
+		std::vector<Wall> parentRooms = walls;
+		size_t firstParent = 0;
+		size_t numberOfParents = 1;
+
+		for (int order = 1; order <= reflectionOrder; order++)
+		{
+			std::vector<Wall> imageRooms;
+			size_t firstImage = branch.locations.size();
+			size_t numberOfInvalidImages = 0, numberOfInaudibleImages = 0;
+			for (size_t p = 0; p < numberOfParents; p++)
+			{
+				int parent = order == 1 ? -1 : (int)(firstParent + p);
+				Common::CVector3 parentLocation = parent < 0 ? sourceLocation : branch.locations[parent];
+				const Common::CVector3 * parentProbes = parent < 0 ? sourceProbes : &branch.probes[parent * 3];
+				Wall * parentRoom = &parentRooms[p * numberOfWalls];
+				for (size_t i = order == 1 ? firstWall : 0; i < (order == 1 ? firstWall + 1 : numberOfWalls); i++)
+				{
+					// A reflection is valid if it is on another wall than the last one and the parent is in front of the wall, on the side
+					// its normal points to. Unlike the distance to the listener used before, this does not depend on where the listener is.
+					// Whether the parent is in front depends on where the source is, so those reflections are kept and flagged instead.
+					if (parent >= 0 && (int)i == branch.wallIndices[parent])
+					{
+						numberOfInvalidImages++;
+						continue;
+					}
+					float plane[4];
+					parentRoom[i].getPlane(plane[0], plane[1], plane[2], plane[3]);
+					float parentDistance = plane[0] * parentLocation.x + plane[1] * parentLocation.y + plane[2] * parentLocation.z + plane[3];
+
+					Common::CVector3 imageLocation = reflectPoint(plane, parentLocation);
+					Common::CVector3 imageProbes[3];
+					for (int k = 0; k < 3; k++) imageProbes[k] = reflectPoint(plane, parentProbes[k]);
+
+					// An image back at the original source, after reflecting around a corner, is not valid either
+					bool backAtSource = isSameLocation(imageLocation, sourceLocation);
+					for (int k = 0; k < 3 && backAtSource; k++) backAtSource = isSameLocation(imageProbes[k], sourceProbes[k]);
+					if (backAtSource)
+					{
+						numberOfInvalidImages++;
+						continue;
+					}
+
+					// Images below the minimum gain are never heard, and neither are their descendants, whose gain can only be lower
+					float gain = (parent < 0 ? 1.0f : branch.reflectionGains[parent]) * getReflectionGain(roomWalls[i]);
+					if (gain < minimumGain)
+					{
+						numberOfInaudibleImages++;
+						continue;
+					}
+
+					branch.locations.push_back(imageLocation);
+					for (int k = 0; k < 3; k++) branch.probes.push_back(imageProbes[k]);
+					branch.parents.push_back(parent);
+					branch.wallIndices.push_back((int)i);
+					branch.reflectionWalls.push_back(parentRoom[i]);
+					branch.reflectionGains.push_back(gain);
+					branch.valid.push_back(parentDistance > THRESHOLD);
+
+					// The image room of this image is only needed to create the images of the next order
+					if (order < reflectionOrder)
+					{
+						for (size_t j = 0; j < numberOfWalls; j++) imageRooms.push_back(parentRoom[i].getImageWall(parentRoom[j]));
+					}
+				}
+			}
+			branch.orderEnds.push_back(branch.locations.size());
+			branch.invalidImages.push_back(numberOfInvalidImages);
+			branch.inaudibleImages.push_back(numberOfInaudibleImages);
+			parentRooms.swap(imageRooms);
+			firstParent = firstImage;
+			numberOfParents = branch.locations.size() - firstImage;
+		}
+	}
+}
 
-void SourceImages::setup(Binaural::CCore &_core, Common::CVector3 _location)
+void SourceImages::setup(Binaural::CCore &_core, Common::CVector3 _location, PropagationDelayLine * _delayLine, NearFieldILD * _nearField)
 {
 	core = &_core;
+	delayLine = _delayLine;
+	nearField = _nearField;
 	sourceLocation = _location;
-	sourceDSP = _core.CreateSingleSourceDSP();						// Creating audio source
+	audioSourceLocation = _location;
+	sourceDSP = createSourceDSP(_location);
+	if (delayLine != nullptr) clusters.setup(_core, _core.GetAudioState().bufferSize);
+}
+
+shared_ptr<Binaural::CSingleSourceDSP> SourceImages::createSourceDSP(Common::CVector3 _location)
+{
+	shared_ptr<Binaural::CSingleSourceDSP> newDSP = core->CreateSingleSourceDSP();	// Creating audio source
 	Common::CTransform sourcePosition;
-	sourcePosition.SetPosition(_location);											 
-	sourceDSP->SetSourceTransform(sourcePosition);					//Set source position
-	sourceDSP->SetSpatializationMode(Binaural::TSpatializationMode::HighQuality);	// Choosing high quality mode for anechoic processing
-	sourceDSP->DisableNearFieldEffect();											// Audio source will not be close to listener, so we don't need near field effect
-	sourceDSP->EnableAnechoicProcess();											// Enable anechoic processing for this source
-	sourceDSP->EnableDistanceAttenuationAnechoic();								// Do not perform distance simulation
-	sourceDSP->EnablePropagationDelay();
+	sourcePosition.SetPosition(_location);
+	newDSP->SetSourceTransform(sourcePosition);					//Set source position
+	newDSP->SetSpatializationMode(Binaural::TSpatializationMode::HighQuality);	// Choosing high quality mode for anechoic processing
+	newDSP->DisableNearFieldEffect();											// Applied after the anechoic process by the near field filters, if any
+	newDSP->EnableAnechoicProcess();											// Enable anechoic processing for this source
+	newDSP->EnableDistanceAttenuationAnechoic();								// Do not perform distance simulation
+	if (delayLine == nullptr) newDSP->EnablePropagationDelay();
+	else newDSP->DisablePropagationDelay();									// Applied when reading the shared delay line
+	return newDSP;
 }
 
 shared_ptr<Binaural::CSingleSourceDSP> SourceImages::getSourceDSP()
@@ -23,48 +199,78 @@ shared_ptr<Binaural::CSingleSourceDSP> SourceImages::getSourceDSP()
 //FIXME: returns only the first reflections and should return all reflectons uo to a reflection order
 std::vector<shared_ptr<Binaural::CSingleSourceDSP>> SourceImages::getImageSourceDSPs()
 {
-	std::vector<shared_ptr<Binaural::CSingleSourceDSP>> imageDSPList;
-	for (int i = 0; i < images.size(); i++)
+	std::vector<shared_ptr<Binaural::CSingleSourceDSP>> imageDSPs;
+	for (size_t i = 0; i < getNumberOfImages(1); i++)
 	{
-		shared_ptr<Binaural::CSingleSourceDSP> tempDSP = images[i].getSourceDSP();
-		imageDSPList.push_back(tempDSP);
+		if (images.dsps[i] != nullptr) imageDSPs.push_back(images.dsps[i]);
 	}
-	return imageDSPList;
+	return imageDSPs;
 }
 
-//FIXME: the condition of visibility is wrong and should be fixed only the first reflection after the source is checked 
-int SourceImages::getNumberOfVisibleImages(int reflectionOrder, Common::CVector3 listenerLocation)
+size_t SourceImages::getNumberOfImages(int reflectionOrder)
+{
+	if (reflectionOrder <= 0 || images.orderEnds.empty()) return 0;
+	return images.orderEnds[std::min((size_t)reflectionOrder, images.orderEnds.size()) - 1];
+}
+
+int SourceImages::computePaths(ReflectionPaths & imagePaths, const std::vector<char> & valid, Common::CVector3 source, Common::CVector3 listenerLocation,
+							   int reflectionOrder, ReflectionPaths::TResults & paths, std::vector<char> & rendered)
 {
-	int subtotal = 0;
-	if (reflectionOrder > 0)
+	size_t numberOfImages = getNumberOfImages(reflectionOrder);
+	imagePaths.compute(listenerLocation, numberOfImages, paths);
+	if (rendered.size() < numberOfImages) rendered.resize(numberOfImages);
+	if (images.allVisible) std::copy(valid.begin(), valid.begin() + numberOfImages, paths.visible.begin());
+	else
 	{
-		reflectionOrder--;
-		for (int i = 0; i < images.size(); i++)
+		// Parents come before their images, so their visibility is already final
+		for (size_t i = 0; i < numberOfImages; i++)
 		{
-			Common::CVector3 reflectionPoint = images.at(i).getReflectionWall().getIntersectionPointWithLine(images[i].getLocation(), listenerLocation);
-			if (images.at(i).getReflectionWall().checkPointInsideWall(reflectionPoint))
-			{
-				subtotal++;
-				subtotal+=images.at(i).getNumberOfVisibleImages(reflectionOrder, listenerLocation);
-			}
-
+			int parent = images.parents[i];
+			paths.visible[i] = paths.visible[i] && valid[i] && (parent < 0 || paths.visible[parent]);
 		}
-		return subtotal;
 	}
-	else
+
+	// An image is rendered once if its path or the path of any of its duplicates is visible, they come after it, and if its level relative
+	// to the direct path, its reflection gain times the 1/r attenuation of its longer path, is not below the threshold
+	float directDistance = (listenerLocation - source).GetDistance();
+	std::fill(rendered.begin(), rendered.begin() + numberOfImages, 0);
+	int numberOfRenderedImages = 0;
+	for (size_t i = 0; i < numberOfImages; i++)
 	{
-		return 0;
+		if (!paths.visible[i] || rendered[images.sources[i]]) continue;
+		if (images.reflectionGains[i] * directDistance < audibilityThreshold * paths.pathLengths[i]) continue;
+		rendered[images.sources[i]] = 1;
+		numberOfRenderedImages++;
 	}
+	return numberOfRenderedImages;
+}
+
+void SourceImages::updateDrawPaths(Common::CVector3 listenerLocation, int reflectionOrder)
+{
+	if (drawPathsValid && reflectionOrder == drawReflectionOrder && listenerLocation.x == drawListenerLocation.x &&
+		listenerLocation.y == drawListenerLocation.y && listenerLocation.z == drawListenerLocation.z) return;
+	drawNumberOfVisibleImages = computePaths(drawImagePaths, drawValid, sourceLocation, listenerLocation, reflectionOrder, drawPaths, drawRenderedImages);
+	drawListenerLocation = listenerLocation;
+	drawReflectionOrder = reflectionOrder;
+	drawPathsValid = true;
+}
 
+int SourceImages::getNumberOfVisibleImages(int reflectionOrder, Common::CVector3 listenerLocation)
+{
+	updateDrawPaths(listenerLocation, reflectionOrder);
+	return drawNumberOfVisibleImages;
+}
+
+int SourceImages::getNumberOfImagesWithoutDSP(int reflectionOrder, Common::CVector3 listenerLocation)
+{
+	updateDrawPaths(listenerLocation, reflectionOrder);
+	return std::max(drawNumberOfVisibleImages - (int)numberOfImageDSPs, 0);
 }
 
 
 void SourceImages::setLocation(Common::CVector3 _location)
 {
 	sourceLocation = _location;
-	Common::CTransform sourcePosition;
-	sourcePosition.SetPosition(_location);									 
-	sourceDSP->SetSourceTransform(sourcePosition);					//Set source position
 	updateImages();
 }
 
@@ -73,61 +279,320 @@ Common::CVector3 SourceImages::getLocation()
 	return sourceLocation;
 }
 
-void SourceImages::setReflectionWall(Wall _reflectionWall)
+void SourceImages::createImages(const Room & _room, Common::CVector3 listenerLocation, int reflectionOrder)
 {
-	reflectionWall = _reflectionWall;
+	// The source DSPs of the previous images go back to the pool
+	for (size_t image : activeImages) releaseImage(image);
+	activeImages.clear();
+
+	images = TImageStore();
+	drawPathsValid = false;
+	if (_room.isShoebox()) generateShoeboxImages(_room, sourceLocation, reflectionOrder, audibilityThreshold, images);
+	else generateImages(_room, sourceLocation, reflectionOrder, audibilityThreshold, images);
+
+	// Duplicates are rendered by the DSP of the first image at their location, so at most one DSP per different image is needed
+	size_t numberOfImages = images.paths.size();
+	size_t numberOfDifferentImages = 0;
+	for (size_t i = 0; i < numberOfImages; i++) numberOfDifferentImages += images.sources[i] == (int)i;
+	numberOfImageDSPs = maxImageDSPs < 0 ? numberOfDifferentImages : std::min(numberOfDifferentImages, (size_t)maxImageDSPs);
+	while (dspPool.size() < numberOfImageDSPs) dspPool.push_back(createSourceDSP(sourceLocation));
+	numberOfImageDSPs = dspPool.size();
+	activeImages.reserve(numberOfDifferentImages);
+	dspCandidates.reserve(numberOfDifferentImages);
+
+	// The main thread keeps its own copy of the locations, and the buffers handed to the audio thread never change their size afterwards
+	drawImagePaths = images.paths;
+	drawValid = images.valid;
+	audioSourceLocation = sourceLocation;
+	{
+		std::lock_guard<std::mutex> lock(locationsMutex);
+		locationsPublished = false;
+		publishedLocations.assign(numberOfImages, sourceLocation);
+		publishedValid.assign(numberOfImages, 0);
+	}
+	pendingLocations.assign(numberOfImages, sourceLocation);
+	pendingValid.assign(numberOfImages, 0);
+	takenLocations.assign(numberOfImages, sourceLocation);
+	takenValid.assign(numberOfImages, 0);
+
+	images.dsps.assign(numberOfImages, nullptr);
+	images.delayTaps.assign(numberOfImages, PropagationDelayLine::TTap());
+	images.nearFieldStates.assign(numberOfImages, NearFieldILD::TState());
+	images.ambisonicStates.assign(numberOfImages, AmbisonicBus::TState());
+	images.clusters.assign(numberOfImages, -1);
+	images.active.assign(numberOfImages, 0);
+	images.renderGains.assign(numberOfImages, 0.0f);
+
+	computePaths(images.paths, images.valid, audioSourceLocation, listenerLocation, reflectionOrder, audioPaths, audioRenderedImages);	// Allocates the results before the audio thread uses them
 }
 
-Wall SourceImages::getReflectionWall()
+void SourceImages::generateImages(const Room & _room, Common::CVector3 _sourceLocation, int reflectionOrder, float minimumGain, TImageStore & images, bool parallel)
 {
-	return reflectionWall;
+	// The images reflected from each first-order image do not depend on the other ones, so each branch is generated by a task of its own
+	const std::vector<Wall> & walls = _room.getWalls();
+	std::vector<TBranch> branches(walls.size());
+	if (parallel && reflectionOrder >= IMAGE_TASKS_MIN_ORDER && std::thread::hardware_concurrency() > 1)
+	{
+		std::vector<std::future<void>> tasks;
+		for (size_t b = 0; b < branches.size(); b++)
+			tasks.push_back(std::async(std::launch::async, generateBranch, std::cref(walls), b, _sourceLocation, reflectionOrder, minimumGain,
+										 std::ref(branches[b])));
+		for (std::future<void> & task : tasks) task.get();
+	}
+	else
+	{
+		for (size_t b = 0; b < branches.size(); b++) generateBranch(walls, b, _sourceLocation, reflectionOrder, minimumGain, branches[b]);
+	}
+
+	size_t numberOfImages = 0;
+	for (TBranch & branch : branches) numberOfImages += branch.locations.size();
+	images.paths.reserve(numberOfImages);
+	images.parents.reserve(numberOfImages);
+	images.sources.reserve(numberOfImages);
+	images.wallIndices.reserve(numberOfImages);
+	images.reflectionWalls.reserve(numberOfImages);
+	images.reflectionGains.reserve(numberOfImages);
+	images.valid.reserve(numberOfImages);
+
+	// Images in each bucket of space, to look for duplicates in the neighbour buckets. Duplicates are usually in other branches.
+	std::vector<Common::CVector3> probes;
+	probes.reserve(3 * numberOfImages);
+	std::unordered_multimap<long long, int> buckets;
+	buckets.reserve(numberOfImages);
+	auto findImage = [&](Common::CVector3 location, const Common::CVector3 * locationProbes, int & image) -> bool {
+		long long x = getBucketCoordinate(location.x), y = getBucketCoordinate(location.y), z = getBucketCoordinate(location.z);
+		for (long long dx = -1; dx <= 1; dx++) for (long long dy = -1; dy <= 1; dy++) for (long long dz = -1; dz <= 1; dz++)
+		{
+			auto range = buckets.equal_range(getBucketKey(x + dx, y + dy, z + dz));
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				image = it->second;
+				bool same = isSameLocation(location, images.paths.getLocation(image));
+				for (int k = 0; k < 3 && same; k++) same = isSameLocation(locationProbes[k], probes[image * 3 + k]);
+				if (same) return true;
+			}
+		}
+		return false;
+	};
+
+	// The branches are merged order by order, in the same order as the images would be generated one by one, so the first image at each
+	// location is the same one whether the branches were generated in parallel or not
+	std::vector<std::vector<int>> branchImages(branches.size());			// Index in the store of each image of each branch
+	for (int order = 1; order <= reflectionOrder; order++)
+	{
+		size_t numberOfInvalidImages = 0, numberOfInaudibleImages = 0, numberOfDuplicates = 0;
+		for (size_t b = 0; b < branches.size(); b++)
+		{
+			TBranch & branch = branches[b];
+			numberOfInvalidImages += branch.invalidImages[order - 1];
+			numberOfInaudibleImages += branch.inaudibleImages[order - 1];
+			for (size_t i = order == 1 ? 0 : branch.orderEnds[order - 2]; i < branch.orderEnds[order - 1]; i++)
+			{
+				// Duplicates are kept, with their descendants, as their paths may be visible when the path of the first one is not
+				int image = (int)images.paths.size();
+				int source;
+				if (findImage(branch.locations[i], &branch.probes[i * 3], source)) numberOfDuplicates++;
+				else
+				{
+					source = image;
+					Common::CVector3 location = branch.locations[i];
+					buckets.insert(std::make_pair(getBucketKey(getBucketCoordinate(location.x), getBucketCoordinate(location.y), getBucketCoordinate(location.z)), image));
+				}
+
+				branchImages[b].push_back(image);
+				images.paths.addImage(branch.locations[i], branch.reflectionWalls[i]);
+				images.parents.push_back(branch.parents[i] < 0 ? -1 : branchImages[b][branch.parents[i]]);
+				images.sources.push_back(source);
+				images.wallIndices.push_back(branch.wallIndices[i]);
+				images.reflectionWalls.push_back(std::move(branch.reflectionWalls[i]));
+				images.reflectionGains.push_back(branch.reflectionGains[i]);
+				images.valid.push_back(branch.valid[i]);
+				for (int k = 0; k < 3; k++) probes.push_back(branch.probes[i * 3 + k]);
+			}
+		}
+		images.orderEnds.push_back(images.paths.size());
+		images.invalidImages.push_back(numberOfInvalidImages);
+		images.inaudibleImages.push_back(numberOfInaudibleImages);
+		images.duplicateImages.push_back(numberOfDuplicates);
+	}
 }
 
-void SourceImages::createImages(Room _room, Common::CVector3 listenerLocation, int reflectionOrder)
+void SourceImages::generateShoeboxImages(const Room & _room, Common::CVector3 _sourceLocation, int reflectionOrder, float minimumGain, TImageStore & images)
 {
-	reflectionOrder--;
+	float width, length, height;
+	_room.getShoeboxDimensions(width, length, height);
+	const float size[3] = { length, width, height };						// Along X, Y and Z
+	const float source[3] = { _sourceLocation.x, _sourceLocation.y, _sourceLocation.z };
+
+	// Wall of the room on the negative (0) and positive (1) side of each axis. Its normal points inwards, against that side.
 	std::vector<Wall> walls = _room.getWalls();
-	for (int i = 0; i < walls.size(); i++)
+	int sideWalls[3][2] = { { 0, 0 }, { 0, 0 }, { 0, 0 } };
+	for (size_t i = 0; i < walls.size(); i++)
 	{
-		SourceImages tempSourceImage;
-		Common::CVector3 tempImageLocation = walls[i].getImagePoint(sourceLocation);
-
-		// if the image is closer to the listener than the previous original, that reflection is not real and should not be included
-		// this is equivalent to determine wether source and listener are on the same side of the wall or not
-		if ((listenerLocation - sourceLocation).GetDistance() < (listenerLocation - tempImageLocation).GetDistance())
+		Common::CVector3 normal = walls[i].getNormal();
+		const float component[3] = { normal.x, normal.y, normal.z };
+		for (int axis = 0; axis < 3; axis++)
 		{
-			tempSourceImage.setup(*core, tempImageLocation);
-			tempSourceImage.setReflectionWall(walls.at(i));
+			if (std::fabs(component[axis]) > 0.5f) sideWalls[axis][component[axis] < 0 ? 1 : 0] = (int)i;
+		}
+	}
 
-			if (reflectionOrder > 0)
-			{
-				// We need to calculate the image room before asking for all the new images
+	// Image of each copy of the room up to the order, in a dense grid of (2 * reflectionOrder + 1)^3 copies, to find the parents
+	int span = 2 * reflectionOrder + 1;
+	std::vector<int> copyImages(span * span * span, -1);
+	auto copyIndex = [reflectionOrder, span](const int copy[3]) {
+		return ((copy[0] + reflectionOrder) * span + copy[1] + reflectionOrder) * span + copy[2] + reflectionOrder;
+	};
 
-				Room tempRoom;
-				for (int j = 0; j < walls.size(); j++)
+	for (int order = 1; order <= reflectionOrder; order++)
+	{
+		size_t numberOfInaudibleImages = 0;
+		// Copies with |i|+|j|+|k| = order
+		for (int i = -order; i <= order; i++)
+		{
+			int restI = order - std::abs(i);
+			for (int j = -restI; j <= restI; j++)
+			{
+				int restJ = restI - std::abs(j);
+				for (int k = -restJ; k <= restJ; k += restJ > 0 ? 2 * restJ : 1)
 				{
-					Wall tempWall = walls.at(i).getImageWall(walls.at(j));
-					tempRoom.insertWall(tempWall);
+					int copy[3] = { i, j, k };
+					int axis = 0;
+					for (int a = 1; a < 3; a++)
+					{
+						if (std::abs(copy[a]) > std::abs(copy[axis])) axis = a;
+					}
+					int side = copy[axis] > 0 ? 1 : 0;
+					int parentCopy[3] = { i, j, k };
+					parentCopy[axis] += side == 1 ? -1 : 1;
+
+					// Images below the minimum gain are not created, and neither are the ones in the copies behind them, with lower gains
+					int parent = order == 1 ? -1 : copyImages[copyIndex(parentCopy)];
+					int wallIndex = sideWalls[axis][parentCopy[axis] % 2 == 0 ? side : 1 - side];
+					float gain = parent < 0 ? getReflectionGain(walls[wallIndex]) : images.reflectionGains[parent] * getReflectionGain(walls[wallIndex]);
+					if ((order > 1 && parent < 0) || gain < minimumGain)
+					{
+						numberOfInaudibleImages++;
+						continue;
+					}
+
+					// The copies are mirrored along the axes where their index is odd
+					float location[3];
+					for (int a = 0; a < 3; a++) location[a] = copy[a] * size[a] + (copy[a] % 2 == 0 ? source[a] : -source[a]);
+					Common::CVector3 imageLocation(location[0], location[1], location[2]);
+
+					// The wall between both copies is the wall of the room on that side moved to the parent copy, so its normal points to the parent
+					Common::CVector3 offset(parentCopy[0] * size[0], parentCopy[1] * size[1], parentCopy[2] * size[2]);
+					Wall reflectionWall;
+					for (Common::CVector3 corner : walls[sideWalls[axis][side]].getCorners()) reflectionWall.insertCorner(corner + offset);
+
+					copyImages[copyIndex(copy)] = (int)images.paths.size();
+					images.paths.addImage(imageLocation, reflectionWall);
+					images.parents.push_back(parent);
+					images.sources.push_back((int)images.sources.size());
+					images.wallIndices.push_back(wallIndex);
+					images.reflectionWalls.push_back(reflectionWall);
+					images.reflectionGains.push_back(gain);
+					images.valid.push_back(1);
 				}
-				tempSourceImage.createImages(tempRoom, listenerLocation, reflectionOrder);
 			}
-
-			images.push_back(tempSourceImage);
 		}
+		images.orderEnds.push_back(images.paths.size());
+		images.invalidImages.push_back(0);
+		images.inaudibleImages.push_back(numberOfInaudibleImages);
+		images.duplicateImages.push_back(0);
+	}
+	images.allVisible = true;
+}
+
+void SourceImages::setAudibilityThreshold(float decibels)
+{
+	audibilityThreshold = std::pow(10.0f, decibels / 20.0f);
+}
+
+void SourceImages::setImageRendering(TImageRendering rendering)
+{
+	imageRendering = rendering;
+}
+
+void SourceImages::setAmbisonicBus(AmbisonicBus * _ambisonicBus)
+{
+	ambisonicBus = _ambisonicBus;
+}
+
+void SourceImages::setMaxImageDSPs(int maxDSPs)
+{
+	maxImageDSPs = maxDSPs;
+}
+
+void SourceImages::printImageCounts()
+{
+	cout << "Image sources per reflection order (reflections, discarded as invalid or below the audibility threshold, duplicates of a previous image, different images, "
+		 << "images behind their reflection wall for the current location of the source):" << endl;
+	size_t firstImage = 0;
+	for (size_t order = 0; order < images.orderEnds.size(); order++)
+	{
+		size_t numberOfImages = images.orderEnds[order] - firstImage;
+		size_t numberOfInvalidImages = std::count(drawValid.begin() + firstImage, drawValid.begin() + images.orderEnds[order], 0);
+		cout << "  Order " << order + 1 << ": " << numberOfImages + images.invalidImages[order] + images.inaudibleImages[order] << " reflections, "
+			 << images.invalidImages[order] << " invalid, " << images.inaudibleImages[order] << " inaudible, " << images.duplicateImages[order] << " duplicates, "
+			 << numberOfImages - images.duplicateImages[order] << " images, " << numberOfInvalidImages << " not valid now" << endl;
+		firstImage = images.orderEnds[order];
 	}
+	size_t numberOfDifferentImages = 0;
+	for (size_t i = 0; i < images.sources.size(); i++) numberOfDifferentImages += images.sources[i] == (int)i;
+	cout << "Source DSPs for the images: " << numberOfImageDSPs << ", for " << numberOfDifferentImages << " different images. "
+		 << "When more images are rendered at once, the quietest ones are left out." << endl;
 }
 
 void SourceImages::updateImages()
 {
-	for (int i = 0; i < images.size(); i++)
+	// Parents come before their images, so they are already at their new location. An image is reflected on the plane of its wall whichever
+	// side its parent is, and its path is only rendered while the parent is in front.
+	for (size_t i = 0; i < drawImagePaths.size(); i++)
 	{
-		//FIXME: When some images disappear or reappear, this has to be done differently
-		images[i].setLocation(images.at(i).getReflectionWall().getImagePoint(sourceLocation));
-		// Moves Images
-		Common::CTransform sourceImagePosition;
-		sourceImagePosition.SetPosition(images.at(i).getLocation());
-		images[i].getSourceDSP()->SetSourceTransform(sourceImagePosition);
+		int parent = images.parents[i];
+		Common::CVector3 parentLocation = parent < 0 ? sourceLocation : drawImagePaths.getLocation(parent);
+		float plane[4];
+		images.reflectionWalls[i].getPlane(plane[0], plane[1], plane[2], plane[3]);
+		drawValid[i] = plane[0] * parentLocation.x + plane[1] * parentLocation.y + plane[2] * parentLocation.z + plane[3] > THRESHOLD;
+		Common::CVector3 imageLocation = reflectPoint(plane, parentLocation);
+		drawImagePaths.setLocation(i, imageLocation);
+		pendingLocations[i] = imageLocation;
+	}
+	drawPathsValid = false;
+
+	// The audio thread moves its images and their source DSPs when it takes the locations
+	std::copy(drawValid.begin(), drawValid.end(), pendingValid.begin());
+	std::lock_guard<std::mutex> lock(locationsMutex);
+	publishedSourceLocation = sourceLocation;
+	publishedLocations.swap(pendingLocations);
+	publishedValid.swap(pendingValid);
+	locationsPublished = true;
+}
 
+void SourceImages::takeLocations()
+{
+	{
+		std::unique_lock<std::mutex> lock(locationsMutex, std::try_to_lock);
+		if (!lock.owns_lock() || !locationsPublished) return;
+		audioSourceLocation = publishedSourceLocation;
+		takenLocations.swap(publishedLocations);
+		takenValid.swap(publishedValid);
+		locationsPublished = false;
+	}
+
+	Common::CTransform sourcePosition;
+	sourcePosition.SetPosition(audioSourceLocation);
+	sourceDSP->SetSourceTransform(sourcePosition);
+	for (size_t i = 0; i < takenLocations.size(); i++) images.paths.setLocation(i, takenLocations[i]);
+	std::copy(takenValid.begin(), takenValid.end(), images.valid.begin());
+	for (size_t image : activeImages)
+	{
+		if (images.dsps[image] == nullptr) continue;
+		Common::CTransform sourceImagePosition;
+		sourceImagePosition.SetPosition(takenLocations[image]);
+		images.dsps[image]->SetSourceTransform(sourceImagePosition);
 	}
 }
 
@@ -139,46 +604,39 @@ void SourceImages::drawSource()
 
 void SourceImages::drawImages(int reflectionOrder)
 {
-	if (reflectionOrder > 0)
+	size_t numberOfImages = getNumberOfImages(reflectionOrder);
+	for (size_t i = 0; i < numberOfImages; i++)
 	{
-		reflectionOrder--;
-		for (int i = 0; i < images.size(); i++)
-		{
-			ofBox(images[i].getLocation().x, images[i].getLocation().y, images[i].getLocation().z, 0.05);
-			if (reflectionOrder > 0)
-			{
-				images[i].drawImages(reflectionOrder);
-			}
-		}
+		Common::CVector3 imageLocation = drawImagePaths.getLocation(i);
+		ofBox(imageLocation.x, imageLocation.y, imageLocation.z, 0.05);
 	}
 }
 
 void SourceImages::	drawRaysToListener(Common::CVector3 _listenerLocation, int _reflectionOrder)
 {
-	if (_reflectionOrder > 0)
+	updateDrawPaths(_listenerLocation, _reflectionOrder);
+	size_t numberOfImages = getNumberOfImages(_reflectionOrder);
+	for (size_t i = 0; i < numberOfImages; i++)
 	{
-		_reflectionOrder--;
-		for (int i = 0; i < images.size(); i++)
+		if (drawPaths.visible[i])
 		{
-			Common::CVector3 tempImageLocation = images.at(i).getLocation();
-			Common::CVector3 reflectionPoint = images.at(i).getReflectionWall().getIntersectionPointWithLine(tempImageLocation, _listenerLocation);
-			if (images.at(i).getReflectionWall().checkPointInsideWall(reflectionPoint))
-			{
-				ofBox(reflectionPoint.x, reflectionPoint.y, reflectionPoint.z, 0.05);
-				ofLine(tempImageLocation.x, tempImageLocation.y, tempImageLocation.z, _listenerLocation.x, _listenerLocation.y, _listenerLocation.z);
-				images.at(i).drawRaysToListener(_listenerLocation, _reflectionOrder);
-			}
+			Common::CVector3 tempImageLocation = drawImagePaths.getLocation(i);
+			Common::CVector3 reflectionPoint(drawPaths.reflectionX[i], drawPaths.reflectionY[i], drawPaths.reflectionZ[i]);
+			ofBox(reflectionPoint.x, reflectionPoint.y, reflectionPoint.z, 0.05);
+			ofLine(tempImageLocation.x, tempImageLocation.y, tempImageLocation.z, _listenerLocation.x, _listenerLocation.y, _listenerLocation.z);
 		}
 	}
 }
 
 void SourceImages::drawFirstReflectionRays(Common::CVector3 _listenerLocation)
 {
-	for (int i = 0; i < images.size(); i++)
+	updateDrawPaths(_listenerLocation, 1);
+	size_t numberOfImages = getNumberOfImages(1);
+	for (size_t i = 0; i < numberOfImages; i++)
 	{
-		Common::CVector3 reflectionPoint = images.at(i).getReflectionWall().getIntersectionPointWithLine(images[i].getLocation(), _listenerLocation);
-		if (images.at(i).getReflectionWall().checkPointInsideWall(reflectionPoint))
+		if (drawPaths.visible[i])
 		{
+			Common::CVector3 reflectionPoint(drawPaths.reflectionX[i], drawPaths.reflectionY[i], drawPaths.reflectionZ[i]);
 			ofBox(reflectionPoint.x, reflectionPoint.y, reflectionPoint.z, 0.05);
 			ofLine(sourceLocation.x, sourceLocation.y, sourceLocation.z, reflectionPoint.x, reflectionPoint.y, reflectionPoint.z);
 			ofLine(reflectionPoint.x, reflectionPoint.y, reflectionPoint.z, _listenerLocation.x, _listenerLocation.y, _listenerLocation.z);
@@ -187,41 +645,151 @@ void SourceImages::drawFirstReflectionRays(Common::CVector3 _listenerLocation)
 }
 
 
-void SourceImages::processAnechoic(CMonoBuffer<float> &bufferInput, Common::CEarPair<CMonoBuffer<float>> & bufferOutput)
+void SourceImages::processSource(Binaural::CSingleSourceDSP & dsp, PropagationDelayLine::TTap & tap, NearFieldILD::TState & state, float pathLength,
+								 float previousGain, float gain, CMonoBuffer<float> &bufferInput, Common::CEarPair<CMonoBuffer<float>> & bufferOutput)
 {
-		Common::CEarPair<CMonoBuffer<float>> bufferProcessed;
+	Common::CEarPair<CMonoBuffer<float>> bufferProcessed;
+
+	if (delayLine == nullptr) dsp.SetBuffer(bufferInput);
+	else dsp.SetBuffer(delayLine->read(tap, pathLength));
+	dsp.ProcessAnechoic(bufferProcessed.left, bufferProcessed.right);
+	if (nearField != nullptr) nearField->process(state, dsp.GetSourceTransform(), bufferProcessed);
+	if (previousGain != gain)
+	{
+		size_t size = std::min(bufferProcessed.left.size(), bufferProcessed.right.size());
+		float gainStep = (gain - previousGain) / size;
+		for (size_t n = 0; n < size; n++)
+		{
+			float sampleGain = previousGain + (n + 1) * gainStep;
+			bufferProcessed.left[n] *= sampleGain;
+			bufferProcessed.right[n] *= sampleGain;
+		}
+	}
+	else if (gain != 1.0f)
+	{
+		bufferProcessed.left.ApplyGain(gain);
+		bufferProcessed.right.ApplyGain(gain);
+	}
 
-		sourceDSP->SetBuffer(bufferInput);
-		sourceDSP->ProcessAnechoic(bufferProcessed.left, bufferProcessed.right);
+	bufferOutput.left += bufferProcessed.left;
+	bufferOutput.right += bufferProcessed.right;
+}
 
-		bufferOutput.left += bufferProcessed.left;
-		bufferOutput.right += bufferProcessed.right;
+void SourceImages::processAnechoic(CMonoBuffer<float> &bufferInput, Common::CEarPair<CMonoBuffer<float>> & bufferOutput, Common::CVector3 _listenerLocation)
+{
+	takeLocations();
+	processSource(*sourceDSP, delayTap, nearFieldState, (_listenerLocation - audioSourceLocation).GetDistance(), 1.0f, 1.0f, bufferInput, bufferOutput);
 }
 
-void SourceImages::processImages(CMonoBuffer<float> &bufferInput, 
-								 Common::CEarPair<CMonoBuffer<float>> & bufferOutput, 
-								 Common::CVector3 _listenerLocation, 
+void SourceImages::processImages(CMonoBuffer<float> &bufferInput,
+								 Common::CEarPair<CMonoBuffer<float>> & bufferOutput,
+								 Common::CVector3 _listenerLocation,
 								 int reflectionOrder)
 {
-	if (reflectionOrder > 0)
+	takeLocations();
+	int numberOfRenderedImages = computePaths(images.paths, images.valid, audioSourceLocation, _listenerLocation, reflectionOrder, audioPaths, audioRenderedImages);
+	TImageRendering rendering = delayLine == nullptr || (imageRendering == TImageRendering::AmbisonicBus && ambisonicBus == nullptr) ?
+								TImageRendering::SourceDSPs : imageRendering;
+	if (rendering != activeRendering)
 	{
-		reflectionOrder--;
-		for (int i = 0; i < images.size(); i++)
+		for (size_t image : activeImages) releaseImage(image);
+		activeImages.clear();
+		activeRendering = rendering;
+	}
+
+	// When more images are rendered than there are source DSPs, only the loudest ones are, by their level relative to the direct path.
+	// The ones left out fade out below, and their DSPs are taken by the louder ones in the next block.
+	size_t numberOfImages = getNumberOfImages(reflectionOrder);
+	if (rendering == TImageRendering::SourceDSPs && (size_t)numberOfRenderedImages > numberOfImageDSPs)
+	{
+		dspCandidates.clear();
+		for (size_t i = 0; i < numberOfImages; i++)
 		{
-			Common::CVector3 reflectionPoint = images.at(i).getReflectionWall().getIntersectionPointWithLine(images[i].getLocation(), _listenerLocation);
-			if (images.at(i).getReflectionWall().checkPointInsideWall(reflectionPoint))
-			{
-				Common::CEarPair<CMonoBuffer<float>> bufferProcessed;
+			if (!audioRenderedImages[i]) continue;
+			float level = images.reflectionGains[i] / std::max(audioPaths.pathLengths[i], MIXED_IMAGE_MIN_DISTANCE);
+			dspCandidates.push_back(std::make_pair(images.active[i] ? level * IMAGE_DSP_KEEP_MARGIN : level, i));
+		}
+		std::nth_element(dspCandidates.begin(), dspCandidates.begin() + numberOfImageDSPs, dspCandidates.end(), std::greater<std::pair<float, size_t>>());
+		for (size_t k = numberOfImageDSPs; k < dspCandidates.size(); k++) audioRenderedImages[dspCandidates[k].second] = 0;
+	}
 
-				images.at(i).getSourceDSP()->SetBuffer(bufferInput);
-				images.at(i).getSourceDSP()->ProcessAnechoic(bufferProcessed.left, bufferProcessed.right);
+	// Images that start to be rendered become active, taking a source DSP from the pool if they are rendered with their own one
+	for (size_t i = 0; i < numberOfImages; i++)
+	{
+		if (!audioRenderedImages[i] || images.active[i]) continue;
+		if (rendering == TImageRendering::SourceDSPs)
+		{
+			if (dspPool.empty()) continue;
+			images.dsps[i] = dspPool.back();
+			dspPool.pop_back();
+			Common::CTransform sourceImagePosition;
+			sourceImagePosition.SetPosition(images.paths.getLocation(i));
+			images.dsps[i]->SetSourceTransform(sourceImagePosition);
+		}
+		images.active[i] = 1;
+		images.renderGains[i] = 0.0f;
+		activeImages.push_back(i);
+	}
 
-				bufferOutput.left += bufferProcessed.left;
-				bufferOutput.right += bufferProcessed.right;
+	// The active images that are no longer rendered fade out in this block, and then are released. Only the changes touch the pool.
+	for (size_t k = 0; k < activeImages.size();)
+	{
+		size_t i = activeImages[k];
+		bool rendered = i < numberOfImages && audioRenderedImages[i];
+		float pathLength = i < numberOfImages ? audioPaths.pathLengths[i] : (images.paths.getLocation(i) - _listenerLocation).GetDistance();
+		renderImage(i, rendering, pathLength, rendered ? images.reflectionGains[i] : 0.0f, bufferInput, bufferOutput, _listenerLocation);
+		if (rendered) k++;
+		else
+		{
+			releaseImage(i);
+			activeImages[k] = activeImages.back();
+			activeImages.pop_back();
+		}
+	}
+	if (rendering == TImageRendering::Clusters) clusters.process(_listenerLocation, bufferOutput);
+}
 
-				images.at(i).processImages(bufferInput, bufferOutput, _listenerLocation, reflectionOrder);
-			}
+void SourceImages::renderImage(size_t image, TImageRendering rendering, float pathLength, float gain, CMonoBuffer<float> &bufferInput,
+							   Common::CEarPair<CMonoBuffer<float>> & bufferOutput, Common::CVector3 listenerLocation)
+{
+	if (rendering == TImageRendering::SourceDSPs)
+	{
+		processSource(*images.dsps[image], images.delayTaps[image], images.nearFieldStates[image], pathLength, images.renderGains[image], gain,
+					  bufferInput, bufferOutput);
+		images.renderGains[image] = gain;
+		return;
+	}
 
-		}
+	// The virtual loudspeakers and the clusters are at the distance where the toolkit does not attenuate. Their gains glide by themselves.
+	float referenceDistance = rendering == TImageRendering::AmbisonicBus ? AMBISONIC_SPEAKER_DISTANCE : IMAGE_CLUSTER_DISTANCE;
+	gain *= referenceDistance / std::max(pathLength, MIXED_IMAGE_MIN_DISTANCE);
+	Common::CVector3 direction = images.paths.getLocation(image) - listenerLocation;
+	if (rendering == TImageRendering::AmbisonicBus)
+	{
+		ambisonicBus->encode(images.ambisonicStates[image], delayLine->read(images.delayTaps[image], pathLength), direction, gain);
+		return;
+	}
+
+	// Images that move to another cluster fade out of the previous one in the same block
+	float directionLength = direction.GetDistance();
+	if (directionLength > 0.0f) direction = Common::CVector3(direction.x / directionLength, direction.y / directionLength, direction.z / directionLength);
+	int previousCluster = images.clusters[image];
+	int cluster = clusters.findCluster(direction, previousCluster);
+	CMonoBuffer<float> * previousMix = previousCluster >= 0 && previousCluster != cluster ? &clusters.getMix(previousCluster) : nullptr;
+	delayLine->readInto(images.delayTaps[image], pathLength, gain, clusters.getMix(cluster), previousMix);
+	clusters.addDirection(cluster, direction, gain);
+	images.clusters[image] = cluster;
+}
+
+void SourceImages::releaseImage(size_t image)
+{
+	if (images.dsps[image] != nullptr)
+	{
+		images.dsps[image]->ResetSourceBuffers();
+		dspPool.push_back(images.dsps[image]);
+		images.dsps[image] = nullptr;
 	}
+	images.active[image] = 0;
+	images.clusters[image] = -1;
+	images.renderGains[image] = 0.0f;
 }
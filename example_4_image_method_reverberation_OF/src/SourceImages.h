@@ -1,7 +1,7 @@
 /**
 * \class SourceImages
 *
-* \brief Declaration of SourceImages interface. This class recursively contains the source images implementing the Image Source Methot (ISM) using 3D Tune-In Toolkit
+* \brief Declaration of SourceImages interface. This class contains, in flat arrays, the source images implementing the Image Source Methot (ISM) using 3D Tune-In Toolkit
 * \date	July 2021
 *
 * \authors F. Arebola-Prez and A. Reyes-Lecuona, members of the 3DI-DIANA Research Group (University of Malaga)
@@ -22,11 +22,29 @@
 #pragma once
 #include "SoundSource.h"
 #include "Room.h"
+#include "PropagationDelayLine.h"
+#include "NearFieldILD.h"
+#include "ReflectionPaths.h"
+#include "AmbisonicBus.h"
+#include "ImageClusters.h"
 #include <BinauralSpatializer/3DTI_BinauralSpatializer.h>
 #include <Common/Vector3.h>
+#include <mutex>
+
+#define DEFAULT_AUDIBILITY_THRESHOLD 0.001f		// Images 60 dB below the direct path are not rendered
+
 class SourceImages
 {
 	public:
+	/** \brief Ways of rendering the images
+	*/
+	enum class TImageRendering
+	{
+		SourceDSPs,			// Each image with its own source DSP
+		Clusters,			// Images mixed by the taps of the delay line into a few source DSPs, grouped by their direction (see ImageClusters)
+		AmbisonicBus		// Images encoded into the ambisonic bus given to setAmbisonicBus, decoded by the caller
+	};
+
 	////////////
 	// Methods
 	////////////
@@ -35,45 +53,99 @@ class SourceImages
 	*	\details creates the original source at a given initial location keeping a link to the Toolkit core.
 	*	\param [in] _Core: pointer to the 3DTI binaural core
 	*   \param [in] _location: initial location for the original source.
+	*   \param [in] _delayLine: delay line shared by the source and its images to apply their propagation delay. If it is null,
+	*			 the propagation delay is applied by the source DSP of each image.
+	*   \param [in] _nearField: near field filters applied to the output of the source and its images. If it is null, there is no near field effect.
 	*/
-	void setup(Binaural::CCore &_core, Common::CVector3 _location);
+	void setup(Binaural::CCore &_core, Common::CVector3 _location, PropagationDelayLine * _delayLine = nullptr, NearFieldILD * _nearField = nullptr);
 
 	/** \brief changes the location of the original source
-	*	\details Sets a new location for the original source and updates all images accordingly.
+	*	\details Sets a new location for the original source and updates all images accordingly. To be called from the main thread:
+	*			 the new locations are handed to the audio thread, which moves the source DSPs in the next block it processes.
 	*   \param [in] _location: new location for the original source.
 	*/
 	void setLocation(Common::CVector3 _location);
 
-	/** \brief Returns the location of the original source 
+	/** \brief Returns the location of the original source
 	*   \param [out] Location: Current location for the original source.
 	*/
 	Common::CVector3 getLocation();
 
-	/** \brief sets the wall where this image was reflected
-	*	\details The first source, which model the original (not reflected) source has not a reflection wall, but all teh images 
-				 should have teh wall where the reflecion is modeled in order to make furtehr calculations
-	*   \param [in] _reflectionWall.
-	*/
-	void setReflectionWall(Wall _reflectionWall);
-
-	/** \brief Returns the  wall where the reflecion produced this image
-	*   \param [out] Reflection wall.
-	*/
-	Wall getReflectionWall();
-
 	/** \brief Returns the 3DTI single source DSP of the original source
 	*   \param [out] SingleSourceDSP: 3DTI single source DSP of the original source.
 	*/
 	shared_ptr<Binaural::CSingleSourceDSP> getSourceDSP();
 
 	/** \brief Returns a vector with DTI single source DSP of the first reflection images sources.
+	*	\details Images only have a source DSP, taken from the pool, while they are rendered with their own one. As the audio thread
+	*			 takes and returns them, it is only to be called from the audio thread.
 	*   \param [out] SingleSourceDSPVector: vector of 3DTI single source DSP of image sources.
 	*/
 	std::vector<shared_ptr<Binaural::CSingleSourceDSP>> getImageSourceDSPs();
 
+	/** \brief Returns the number of images up to a reflection order with a visible path to the listener, each duplicate counted once
+	*/
 	int getNumberOfVisibleImages(int reflectionOrder, Common::CVector3 listenerLocation);
 
-	void createImages(Room _room, Common::CVector3 listenerLocation, int reflectionOrder);
+	/** \brief Returns how many of those images are not rendered with a source DSP each because there are more of them than source DSPs
+	*	\details They are the quietest ones, see setMaxImageDSPs. Images mixed into clusters or encoded into the ambisonic bus are all rendered.
+	*/
+	int getNumberOfImagesWithoutDSP(int reflectionOrder, Common::CVector3 listenerLocation);
+
+	/** \brief Creates the images of the original source up to a reflection order, replacing the previous ones
+	*	\details The images are generated by generateShoeboxImages if the room is a shoebox created by Room::setup, and by generateImages otherwise.
+	*			 Not to be called while the audio thread is processing the source.
+	*   \param [in] _room: room where the original source is.
+	*   \param [in] listenerLocation: location of the listener.
+	*   \param [in] reflectionOrder: highest reflection order of the images.
+	*/
+	void createImages(const Room & _room, Common::CVector3 listenerLocation, int reflectionOrder);
+
+	/** \brief Sets the level, relative to the direct path, below which images are not rendered. It applies to the images created afterwards.
+	*	\details The level of an image is its reflection gain, the product of the reflection coefficients sqrt(1 - absorption) of the walls
+	*			 in its path, times the distance attenuation of its path relative to the direct one. As paths are never shorter than the direct
+	*			 one, images whose reflection gain alone is below the threshold are not created at all, nor their descendants, and the rest
+	*			 are culled in each block by their level at the current listener location.
+	*   \param [in] decibels: threshold in dB relative to the direct path, negative. The default one is -60 dB, DEFAULT_AUDIBILITY_THRESHOLD.
+	*/
+	void setAudibilityThreshold(float decibels);
+
+	/** \brief Sets how the images are rendered from the next block processed. The original source keeps its own source DSP.
+	*	\details With clusters or the ambisonic bus, each image rendered is read from the delay line with its delay and mixed or encoded
+	*			 with its reflection gain and the 1/r distance attenuation of its path, which is what the toolkit applies by default, and
+	*			 the near field effect is not applied to it. Without a delay line, or without a bus for the ambisonic rendering, each
+	*			 image is rendered with its own source DSP.
+	*/
+	void setImageRendering(TImageRendering rendering);
+
+	/** \brief Sets the ambisonic bus into which the images are encoded when they are rendered through it
+	*	\details The caller decodes the bus once per block, after processImages.
+	*   \param [in] _ambisonicBus: bus, shared with other sources, or null
+	*/
+	void setAmbisonicBus(AmbisonicBus * _ambisonicBus);
+
+	/** \brief Sets the highest number of source DSPs of the images, which are created by createImages. It applies to the images created afterwards.
+	*	\details The source DSPs are kept in a pool. An image takes one when it starts to be rendered with its own source DSP and returns
+	*			 it when it has faded out. When more images are visible and audible than there are source DSPs, only the loudest ones,
+	*			 by their level relative to the direct path, are rendered. A quieter image that has a DSP fades out and hands it over
+	*			 to a louder one in the next block. Images that have a DSP keep it unless the other one is louder by IMAGE_DSP_KEEP_MARGIN.
+	*   \param [in] maxDSPs: highest number of source DSPs, or -1, the default, for one per different image
+	*/
+	void setMaxImageDSPs(int maxDSPs);
+
+	/** \brief Prints through the console the number of reflections of each order, and how many of them were discarded as invalid or are
+	*		   duplicates of a previous image, rendered by its DSP, and the number of source DSPs for the different images
+	*/
+	void printImageCounts();
+
+	/** \brief Moves the images to follow the original source
+	*	\details Reflections on a wall that the image reflected is behind are not valid. As this depends on where the source is, each
+	*			 reflection is checked again with the new location. Images that become valid or not valid are faded in or out by
+	*			 processImages, with their descendants, whose paths go through them. Every image moves with the source, so every
+	*			 image is moved and checked again, not only the subtrees whose validity changes.
+	*			 The images drawn and counted by the main thread are moved at once. The new locations and validity are then published
+	*			 to the audio thread, which takes them at the start of its next block, see takeLocations.
+	*/
 	void updateImages();
 	void drawSource();
 	void drawImages(int reflectionOrder);
@@ -81,23 +153,166 @@ class SourceImages
 	void drawFirstReflectionRays(Common::CVector3 _listenerLocation);
 
 
-	void processAnechoic(CMonoBuffer<float> &bufferInput, Common::CEarPair<CMonoBuffer<float>> & bufferOutput);
+	/** \brief Processes the original source. If there is a delay line, the input must have been written into it in this block.
+	*/
+	void processAnechoic(CMonoBuffer<float> &bufferInput, Common::CEarPair<CMonoBuffer<float>> & bufferOutput, Common::CVector3 _listenerLocation);
+
+	/** \brief Processes the images rendered up to a reflection order. If there is a delay line, the input must have been written into it in this block.
+	*	\details Images that start to be rendered fade in along the block, and images that stop being rendered, because their path is no
+	*			 longer visible, they are no longer valid or audible, or they are above the reflection order, fade out along the block and
+	*			 return their source DSP to the pool. Changing the rendering cuts the images of the previous one instead.
+	*/
 	void processImages(CMonoBuffer<float> &bufferInput, Common::CEarPair<CMonoBuffer<float>> & bufferOutput, Common::CVector3 _listenerLocation, int _reflectionOrder);
 
+	/** \brief Image sources of all orders, one element of each array per image
+	*	\details Images are stored by reflection order, so the images up to an order are the first ones and the parent of an image
+	*			 always comes before it. The images are traversed, updated and drawn with linear scans of these arrays.
+	*			 The delay tap and near field state of each image are only created by createImages. Images only have a DSP while they are
+	*			 rendered with their own one, and duplicates never have one.
+	*/
+	struct TImageStore
+	{
+		ReflectionPaths paths;												//Location and reflection wall of each image, laid out for the visibility test
+		std::vector<int> parents;											//Image reflected to obtain this one, or -1 if it is the original source
+		std::vector<int> sources;											//This image, or the first one at the same location if it is a duplicate reached through other walls
+		std::vector<int> wallIndices;										//Wall of the room given to createImages whose image produced this image
+		std::vector<Wall> reflectionWalls;									//That wall in the image room of the parent, where the path of this image is reflected
+		std::vector<float> reflectionGains;									//Product of the reflection coefficients of the walls in the path of this image
+		std::vector<char> valid;											//Whether the parent is in front of the reflection wall, for the current location of the source
+		std::vector<shared_ptr<Binaural::CSingleSourceDSP>> dsps;			//Source DSP of each image
+		std::vector<PropagationDelayLine::TTap> delayTaps;					//Position of each image in the delay line
+		std::vector<NearFieldILD::TState> nearFieldStates;					//State of the near field filters of each image
+		std::vector<AmbisonicBus::TState> ambisonicStates;					//Encoding gains of each image in the ambisonic bus
+		std::vector<int> clusters;											//Cluster where each image was mixed the last time, or -1
+		std::vector<char> active;											//Whether each image was rendered in the last block processed
+		std::vector<float> renderGains;										//Gain of each image with its own source DSP at the end of that block
+		std::vector<size_t> orderEnds;										//Number of images of each reflection order and lower ones
+		std::vector<size_t> invalidImages;									//Number of reflections of each order discarded as never valid
+		std::vector<size_t> inaudibleImages;								//Number of reflections of each order discarded for their reflection gain
+		std::vector<size_t> duplicateImages;								//Number of images of each order that are duplicates
+		bool allVisible = false;											//Whether every image is visible from anywhere in the room, as in a shoebox room
+	};
+
+	/** \brief Generates the images of a source in any room up to a reflection order, without their DSPs
+	*	\details The images of each order are obtained by reflecting the images of the previous order on every wall of their image room,
+	*			 which gives 6*5^(n-1) images of order n in a shoebox room, many of them at the same location.
+	*			 A reflection is discarded, with all its descendants, if it is on the wall of the last reflection, or if the new image is back
+	*			 at the original source. A reflection on a wall that the image reflected is behind is kept, flagged as not valid, as it may
+	*			 become valid when the source moves. An image at the location of a previous one, that stays
+	*			 there wherever the source is, is a duplicate: it is kept to test its path, but it is rendered by the DSP of the previous one.
+	*			 Duplicates are found by bucketing the images in cubes of space. Images whose reflection gain is below minimumGain are discarded
+	*			 with all their descendants.
+	*			 The first-order image on each wall and its descendants are generated by a task of their own, in arrays of their own,
+	*			 and then merged order by order, so the images are the same, in the same order, with or without tasks.
+	*   \param [out] images: store where the images are added. It must be empty.
+	*   \param [in] parallel: whether the branches are generated by parallel tasks, or one after the other by the calling thread. Low orders,
+	*			 or machines with one hardware thread, use the calling thread anyway.
+	*/
+	static void generateImages(const Room & _room, Common::CVector3 _sourceLocation, int reflectionOrder, float minimumGain, TImageStore & images, bool parallel = true);
+
+	/** \brief Generates the images of a source in a shoebox room created by Room::setup up to a reflection order, without their DSPs
+	*	\details The images are the points of the lattice of mirrored copies of the room, each one in the copy translated by (i*length, j*width, k*height)
+	*			 and of order |i|+|j|+|k|, so they are enumerated directly, without duplicates: 4n^2+2 images of order n. All of them are
+	*			 visible from any listener inside the room. The parent of an image is the one in the neighbour copy closer to the room, along
+	*			 the axis where the image is farthest, and its reflection wall is the wall between both copies. Images whose reflection gain is
+	*			 below minimumGain are discarded, and so are the ones in the copies behind them.
+	*   \param [out] images: store where the images are added. It must be empty.
+	*/
+	static void generateShoeboxImages(const Room & _room, Common::CVector3 _sourceLocation, int reflectionOrder, float minimumGain, TImageStore & images);
+
 private:
 	////////////
 	// Attributes
 	////////////
 
-
-	std::vector<Wall> walls;										   //DEPRECATED: List of walls where the source will be reflected. Not used any more, as each image source reminds its reflection wall
-	Wall reflectionWall;											   //Wall which produced current image as a reflection
-	Common::CVector3 sourceLocation;								   //Original source location
+	Common::CVector3 sourceLocation;								   //Original source location, set by the main thread
+	Common::CVector3 audioSourceLocation;								//Location of the original source in the block processed by the audio thread
 	shared_ptr<Binaural::CSingleSourceDSP>	sourceDSP;				   //Pointer to the original source interface
 
-	std::vector<SourceImages> images;									//recursive list of images
+	TImageStore images;													//Images of the original source, moved by the audio thread
+	ReflectionPaths drawImagePaths;										//Copy of images.paths moved by the main thread, whose images are drawn and counted
+	std::vector<char> drawValid;										//Copy of images.valid updated by the main thread
+	ReflectionPaths::TResults audioPaths;								//Paths of the images in the last block processed, computed by the audio thread
+	std::vector<char> audioRenderedImages;								//Images rendered in that block, with a visible path or a duplicate with one
+	ReflectionPaths::TResults drawPaths;								//Paths of the images drawn and counted, computed by the main thread
+	std::vector<char> drawRenderedImages;
+	int drawNumberOfVisibleImages = 0;
+	float audibilityThreshold = DEFAULT_AUDIBILITY_THRESHOLD;			//Lowest level of the images rendered relative to the direct path, as a gain
+	bool drawPathsValid = false;										//Whether drawPaths are the paths to drawListenerLocation up to drawReflectionOrder
+	Common::CVector3 drawListenerLocation;
+	int drawReflectionOrder = 0;
 
 	Binaural::CCore *core;                                              //Core
-	
-};
+	PropagationDelayLine *delayLine;									//Delay line shared with the original source and the other images, or null
+	PropagationDelayLine::TTap delayTap;								//Position of the original source in the delay line
+	NearFieldILD *nearField;											//Near field filters shared with the original source and the other images, or null
+	NearFieldILD::TState nearFieldState;								//State of the near field filters of the original source
+	TImageRendering imageRendering = TImageRendering::SourceDSPs;
+	AmbisonicBus *ambisonicBus = nullptr;								//Bus where the images are encoded, shared with other sources, or null
+	ImageClusters clusters;												//Source DSPs of the images grouped by their direction, set up if there is a delay line
+	std::vector<shared_ptr<Binaural::CSingleSourceDSP>> dspPool;		//Source DSPs not used by any image
+	int maxImageDSPs = -1;												//Highest number of source DSPs of the images, or -1 for one per different image
+	size_t numberOfImageDSPs = 0;										//Source DSPs created for the images, in the pool or in use
+	std::vector<std::pair<float, size_t>> dspCandidates;				//Level and index of the images rendered, ranked when there are more than source DSPs
+	std::vector<size_t> activeImages;									//Images rendered in the last block processed
+	TImageRendering activeRendering = TImageRendering::SourceDSPs;		//Rendering of those images
+
+	// Locations and validity of the images handed from the main thread to the audio thread. Both threads only swap the buffers while
+	// holding the mutex, so neither of them copies or allocates with it held.
+	std::mutex locationsMutex;
+	bool locationsPublished = false;									//Whether publishedLocations are newer than the ones of the audio thread
+	Common::CVector3 publishedSourceLocation;
+	std::vector<Common::CVector3> publishedLocations;
+	std::vector<char> publishedValid;
+	std::vector<Common::CVector3> pendingLocations;						//Filled by the main thread before swapping them with the published ones
+	std::vector<char> pendingValid;
+	std::vector<Common::CVector3> takenLocations;						//Swapped with the published ones by the audio thread
+	std::vector<char> takenValid;
+
+	/** \brief Creates a source DSP at a given location, configured as the ones of the original source and all its images
+	*/
+	shared_ptr<Binaural::CSingleSourceDSP> createSourceDSP(Common::CVector3 _location);
+
+	/** \brief Returns the number of images created up to a reflection order
+	*/
+	size_t getNumberOfImages(int reflectionOrder);
 
+	/** \brief Computes the paths of the images up to a reflection order to the listener, in one sweep
+	*	\details An image is visible if it is valid, its path to the listener crosses its reflection wall and its parent is visible too.
+	*	\param [in] imagePaths, valid, source: locations and validity of the images and location of the source, the ones of the audio thread or the main thread
+	*	\param [out] paths: paths and visibility of the images. The ones above the order are not written.
+	*	\param [out] rendered: true for each image that is not a duplicate and is visible or has a visible duplicate
+	*	\retval number of images rendered
+	*/
+	int computePaths(ReflectionPaths & imagePaths, const std::vector<char> & valid, Common::CVector3 source, Common::CVector3 listenerLocation,
+					 int reflectionOrder, ReflectionPaths::TResults & paths, std::vector<char> & rendered);
+
+	/** \brief Moves the source and its images to the locations last published by updateImages, if there are new ones. Called by the audio thread.
+	*	\details The source DSPs of the original source and of the active images are moved too. If the main thread is publishing at that
+	*			 moment, the locations are taken in the next block instead of waiting for it.
+	*/
+	void takeLocations();
+
+	/** \brief Updates drawPaths, unless they were computed for the same listener location and reflection order and the images have not moved
+	*/
+	void updateDrawPaths(Common::CVector3 listenerLocation, int reflectionOrder);
+
+	/** \brief Processes the original source or one image and adds it to the output
+	*	\details The input is read from the delay line with the delay of the path length when there is one, and the near field effect
+	*			 is applied to the output of the source DSP when there are near field filters. The output is scaled by a gain that moves
+	*			 linearly along the block from previousGain, the one of the previous block, to gain.
+	*/
+	void processSource(Binaural::CSingleSourceDSP & dsp, PropagationDelayLine::TTap & tap, NearFieldILD::TState & state, float pathLength,
+					   float previousGain, float gain, CMonoBuffer<float> &bufferInput, Common::CEarPair<CMonoBuffer<float>> & bufferOutput);
+
+	/** \brief Renders one active image in this block with the given rendering, with a gain gliding from the one of the previous block
+	*	\param [in] gain reflection gain of the image, or 0 to fade it out
+	*/
+	void renderImage(size_t image, TImageRendering rendering, float pathLength, float gain, CMonoBuffer<float> &bufferInput,
+					 Common::CEarPair<CMonoBuffer<float>> & bufferOutput, Common::CVector3 listenerLocation);
+
+	/** \brief Makes an image inactive and returns its source DSP, if it has one, to the pool, with its buffers cleared
+	*/
+	void releaseImage(size_t image);
+
+};
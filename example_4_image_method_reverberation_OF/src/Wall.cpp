@@ -1,5 +1,6 @@
 #include "ofMain.h"
 #include "Wall.h"
+#include <cmath>
 
 #ifndef THRESHOLD
 #define THRESHOLD 0.000001f
@@ -24,8 +25,9 @@ int Wall::insertCorner(float _x, float _y, float _z)
 		if (polygon.size() == 3)
 		{
 			calculate_ABCD();
-			return 1;
+			updateProjection();
 		}
+		return 1;
 	}
 	else
 	{
@@ -34,12 +36,14 @@ int Wall::insertCorner(float _x, float _y, float _z)
 	    if (diff < THRESHOLD) // DBL_EPSILON? THRESHOLD?
 	    {
 			polygon.push_back(tempCorner);
+			updateProjection();
 			return 1;
 	    }
 	    else 
 		{
 			tempCorner = getPointProjection(_x, _y, _z);
 			polygon.push_back(tempCorner);
+			updateProjection();
 			return 0;
 	    }
 	}
@@ -55,24 +59,14 @@ void Wall::setAbsortion(float _absortion)
 	absortion = _absortion;
 }
 
-Common::CVector3 Wall::getNormal()
+float Wall::getAbsortion()
 {
-	//Common::CVector3 normal, p1, p2; 
-	Common::CVector3 p1, p2, normal;
-	float modulus;
-
-	p1 = polygon.at(1) - polygon.at(0);
-	p2 = polygon.at(2) - polygon.at(0);
-
-	normal = p1.CrossProduct(p2);
-
-	modulus = normal.GetDistance();
+	return absortion;
+}
 
-	normal.x = normal.x / modulus;
-	normal.y = normal.y / modulus;
-	normal.z = normal.z / modulus;
-		
-	return normal;
+Common::CVector3 Wall::getNormal()
+{
+	return Common::CVector3(A, B, C);
 }
 
 Common::CVector3 Wall::getCenter()
@@ -111,7 +105,6 @@ Common::CVector3 Wall::getPointProjection(float x0, float y0, float z0)
 	double diff1, diff2;
 	float rX, rY, rZ;
 	
-	calculate_ABCD();
 	normalV = getNormal();
 	lambda =(double) getDistanceFromPoint(point);
 
@@ -147,11 +140,8 @@ Common::CVector3 Wall::getPointProjection(float x0, float y0, float z0)
 
 float Wall::getDistanceFromPoint(Common::CVector3 point)
 {
-	float distance;
-	calculate_ABCD();
-	distance = fabs(A*point.x + B * point.y + C * point.z + D);
-	distance = distance / sqrtf(A * A + B * B + C * C);
-	return distance;
+	// (A, B, C) is a unit vector
+	return fabs(A * point.x + B * point.y + C * point.z + D);
 }
 
 Common::CVector3 Wall::getImagePoint(Common::CVector3 point)
@@ -179,13 +169,14 @@ Wall Wall::getImageWall(Wall _wall)
 		Common::CVector3 tempImageCorner = getImagePoint(corners.at(i));
 		tempWall.insertCorner(tempImageCorner);
 	}
+	tempWall.setAbsortion(_wall.getAbsortion());
 	return tempWall;
 }
 
 Common::CVector3 Wall::getIntersectionPointWithLine(Common::CVector3 p1, Common::CVector3 p2)
 {
 	Common::CVector3 cutPoint, vecLine;
-	float modulus, lambda;
+	float lambda;
 
 	vecLine = p2 - p1;
 	
@@ -196,54 +187,131 @@ Common::CVector3 Wall::getIntersectionPointWithLine(Common::CVector3 p1, Common:
 	cutPoint.y = p1.y + lambda * vecLine.y;
 	cutPoint.z = p1.z + lambda * vecLine.z;
 
-	modulus = getDistanceFromPoint(cutPoint); // must be = ZERO
-	
 	return cutPoint;
 }
 
 bool  Wall::checkPointInsideWall(Common::CVector3 point)
 {
 	float modulus = getDistanceFromPoint(point);
-	if (modulus > THRESHOLD) return FALSE;        // Point is not in the wall
+	if (!(modulus <= THRESHOLD)) return FALSE;    // Point is not in the wall, or not a point if the line was parallel to the wall
 
-	double m1, m2, anglesum=0, costheta, anglediff;
-	Common::CVector3 p1, p2;
-	int n = polygon.size();
-		
-	for (auto i = 0; i<n; i++) 
+	float u = axisU == 0 ? point.x : point.y;
+	float v = axisV == 1 ? point.y : point.z;
+	int n = edgeA.size();
+
+	if (convex)
 	{
-		p1.x = polygon[i].x - point.x;
-		p1.y = polygon[i].y - point.y;
-		p1.z = polygon[i].z - point.z;
-		p2.x = polygon[(i + 1) % n].x - point.x;
-		p2.y = polygon[(i + 1) % n].y - point.y;
-		p2.z = polygon[(i + 1) % n].z - point.z;
-		m1 = p1.GetDistance();
-		m2 = p2.GetDistance();
-		if (m1*m2 <= THRESHOLD)
-			return TRUE;                     // Point is on a corner of the wall,
-		else
-			costheta = (p1.x*p2.x + p1.y*p2.y + p1.z*p2.z) / (m1*m2);
-
-		anglesum += acos(costheta);
-    }
-	anglediff = fabs(TWOPI - anglesum);
-    if (anglediff < THRESHOLD)
-		return TRUE;
-	else
-		return FALSE;
+		// Inside, or on the border, if the point is not outside the line of any edge. No branch per edge, so the loop can be vectorized.
+		int outside = 0;
+		for (int i = 0; i < n; i++)
+			outside += !(edgeA[i] * u + edgeB[i] * v + edgeC[i] >= -THRESHOLD);
+		return n > 0 && outside == 0;
+	}
+
+	// Even-odd rule: the point is inside if a ray from it along u crosses an odd number of edges
+	bool inside = false;
+	n = projectedU.size();
+	for (int i = 0, j = n - 1; i < n; j = i++)
+	{
+		if ((projectedV[i] > v) != (projectedV[j] > v) &&
+			u < projectedU[j] + (v - projectedV[j]) * (projectedU[i] - projectedU[j]) / (projectedV[i] - projectedV[j]))
+			inside = !inside;
+	}
+	return inside;
+}
+
+void Wall::getPlane(float & a, float & b, float & c, float & d)
+{
+	a = A;
+	b = B;
+	c = C;
+	d = D;
+}
+
+bool Wall::getEdgeFunctions(int & u, int & v, std::vector<float> & a, std::vector<float> & b, std::vector<float> & c)
+{
+	u = axisU;
+	v = axisV;
+	a = edgeA;
+	b = edgeB;
+	c = edgeC;
+	return convex;
 }
 
 void Wall::calculate_ABCD()
 {
-	Common::CVector3 normal;
-	normal = getNormal();
+	Common::CVector3 p1, p2, normal;
+	float modulus;
+
+	p1 = polygon.at(1) - polygon.at(0);
+	p2 = polygon.at(2) - polygon.at(0);
+
+	normal = p1.CrossProduct(p2);
+
+	modulus = normal.GetDistance();
+
+	normal.x = normal.x / modulus;
+	normal.y = normal.y / modulus;
+	normal.z = normal.z / modulus;
+
 	A = normal.x;
 	B = normal.y;
 	C = normal.z;
 	D = -(A * polygon.at(2).x + B * polygon.at(2).y + C * polygon.at(2).z);
 }
 
+void Wall::updateProjection()
+{
+	// The coordinate along which the normal is largest is dropped, which keeps the projected polygon as large as possible
+	float nx = fabs(A), ny = fabs(B), nz = fabs(C);
+	if (nx >= ny && nx >= nz) { axisU = 1; axisV = 2; }
+	else if (ny >= nz) { axisU = 0; axisV = 2; }
+	else { axisU = 0; axisV = 1; }
+
+	int n = polygon.size();
+	projectedU.resize(n);
+	projectedV.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		projectedU[i] = axisU == 0 ? polygon[i].x : polygon[i].y;
+		projectedV[i] = axisV == 1 ? polygon[i].y : polygon[i].z;
+	}
+
+	// Twice the signed area, to orient the edge functions towards the inside whatever the order of the corners
+	double area = 0;
+	for (int i = 0; i < n; i++)
+	{
+		int j = (i + 1) % n;
+		area += (double)projectedU[i] * projectedV[j] - (double)projectedU[j] * projectedV[i];
+	}
+	float orientation = area >= 0 ? 1.0f : -1.0f;
+
+	edgeA.clear();
+	edgeB.clear();
+	edgeC.clear();
+	convex = true;
+	float previousTurn = 0;
+	for (int i = 0; i < n; i++)
+	{
+		int j = (i + 1) % n;
+		int k = (i + 2) % n;
+		float du = projectedU[j] - projectedU[i];
+		float dv = projectedV[j] - projectedV[i];
+		float length = sqrtf(du * du + dv * dv);
+		if (length <= THRESHOLD) continue;               // Repeated corner
+
+		float a = -dv * orientation / length;
+		float b = du * orientation / length;
+		edgeA.push_back(a);
+		edgeB.push_back(b);
+		edgeC.push_back(-(a * projectedU[i] + b * projectedV[i]));
+
+		float turn = du * (projectedV[k] - projectedV[j]) - dv * (projectedU[k] - projectedU[j]);
+		if (turn * previousTurn < 0) convex = false;
+		if (turn != 0) previousTurn = turn;
+	}
+}
+
 void Wall::draw()
 {
 	int numberVertex=polygon.size();
@@ -23,8 +23,23 @@ public:
 
 	Common::CVector3 getIntersectionPointWithLine(Common::CVector3 point1, Common::CVector3 point2);
 
+	/** \brief Checks whether a point of the plane of the wall is inside its polygon
+	*	\details The polygon is projected, when its corners are inserted, onto the coordinate plane where it has the largest area. Convex
+	*			 polygons are tested with one edge function per edge, and other polygons by counting the edges crossed by a ray.
+	*/
 	bool checkPointInsideWall(Common::CVector3 point);
 
+	/** \brief Returns the plane of the wall, Ax + By + Cz + D = 0, with (A, B, C) its unit normal
+	*/
+	void getPlane(float & a, float & b, float & c, float & d);
+
+	/** \brief Returns the projection used by checkPointInsideWall
+	*	\param [out] u, v: coordinates kept by the projection, 0 for x, 1 for y and 2 for z
+	*	\param [out] a, b, c: edge functions of the projected polygon, a * u + b * v + c being the distance to each edge, positive inside
+	*	\retval true if the polygon is convex, so that a point is inside when it is not outside any edge
+	*/
+	bool getEdgeFunctions(int & u, int & v, std::vector<float> & a, std::vector<float> & b, std::vector<float> & c);
+
 	void draw();
 	void drawNormal(float length=LENGTH_OF_NORMALS);
 		
@@ -32,7 +47,16 @@ private:
 	std::vector<Common::CVector3> polygon; // corners of the wall
 	float absortion = 0;
 
-	float A, B, C, D;                      // General Plane Eq.: Ax + By + Cz + D = 0
+	float A = 0, B = 0, C = 0, D = 0;      // General Plane Eq.: Ax + By + Cz + D = 0, with (A, B, C) the unit normal. Computed when the corners are inserted
+	int axisU = 0, axisV = 1;              // Coordinates kept when the polygon is projected onto a coordinate plane
+	bool convex = true;                    // Whether the projected polygon is convex
+	std::vector<float> projectedU;         // Projected corners
+	std::vector<float> projectedV;
+	std::vector<float> edgeA;              // Edge functions of the projected polygon: edgeA * u + edgeB * v + edgeC is the distance to the
+	std::vector<float> edgeB;              // line of each edge, positive towards the inside
+	std::vector<float> edgeC;
+
+	void updateProjection();
 		
 };
 
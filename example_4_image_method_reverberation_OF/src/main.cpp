@@ -1,8 +1,17 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "Benchmarks.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char *argv[]){
+	// Benchmarks can be run from the command line instead of the example: example --benchmark <name>
+	if (argc > 2 && string(argv[1]) == "--benchmark")
+	{
+		if (!Benchmarks::run(argv[2]))
+			cout << "Unknown benchmark: " << argv[2] << endl;
+		return 0;
+	}
+
 	ofSetupOpenGL(1024,768,OF_WINDOW);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
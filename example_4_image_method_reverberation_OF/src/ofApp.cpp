@@ -5,7 +5,13 @@
 
 #define SOURCE_STEP 0.01f
 #define LISTENER_STEP 0.01f
-#define MAX_REFLECTION_ORDER 3
+#define MAX_REFLECTION_ORDER 4
+#define MAX_PROPAGATION_DISTANCE 50.0f		// Longest path of an image to the listener, in meters. Longer paths get this delay.
+#define WALL_ABSORTION 0.3f				// Fraction of the energy of the sound absorbed by each reflection on the walls
+#define AUDIBILITY_THRESHOLD -60.0f		// Level, in dB relative to the direct path, below which images are not rendered
+#define MAX_IMAGE_DSPS 64					// Images rendered at once with a source DSP each, the pool of source DSPs taken by the loudest images
+#define AMBISONIC_ORDER 2					// Order of the ambisonic bus, rendered through 12 virtual loudspeakers
+#define NEAR_FIELD_ILD_FILE "NearFieldCompensation_ILD_44100.3dti-ild"		// Near field ILD table of the toolkit resources, for SAMPLERATE
 
 //--------------------------------------------------------------
 void ofApp::setup(){
@@ -52,6 +58,7 @@ void ofApp::setup(){
 	mainRoom.insertWall(ceiling);
 */
 	mainRoom.setup(3, 2, 2.5);
+	mainRoom.setAbsortion(WALL_ABSORTION);
 
 
 	// Core setup
@@ -75,11 +82,21 @@ void ofApp::setup(){
 	if (!sofaLoadResult) { 
 		cout << "ERROR: Error trying to load the SOFA file" << endl<<endl;
 	}																			
+	// Near field ILD can be found in 3dti_AudioToolkit/resources/ILD. It is optional, see Note 4 of the README
+	if (!nearField.setup(listener, NEAR_FIELD_ILD_FILE)) {
+		cout << "Notice: " << NEAR_FIELD_ILD_FILE << " not found, copy it from 3dti_AudioToolkit/resources/ILD to render the near field effect" << endl << endl;
+	}
 
 	// Source  setup
 	//sourceImages.setup(myCore, Common::CVector3(-0.5, 0, 1), Common::CVector3(0.5, -1, 1));
-	sourceImages.setup(myCore, Common::CVector3(0.5, -1, 1));
+	propagationDelay.setup(SAMPLERATE, BUFFERSIZE, MAX_PROPAGATION_DISTANCE);
+	sourceImages.setup(myCore, Common::CVector3(0.5, -1, 1), &propagationDelay, &nearField);
+	sourceImages.setAudibilityThreshold(AUDIBILITY_THRESHOLD);
+	sourceImages.setMaxImageDSPs(MAX_IMAGE_DSPS);
+	ambisonicBus.setup(myCore, AMBISONIC_ORDER, BUFFERSIZE);
+	sourceImages.setAmbisonicBus(&ambisonicBus);
 	sourceImages.createImages(mainRoom,listenerLocation, MAX_REFLECTION_ORDER);			//trying second order reflections (only to draw, not to sound)
+	sourceImages.printImageCounts();
 	LoadWavFile(source1Wav, "speech_female.wav");											// Loading .wav file										   
 
 	//AudioDevice Setup
@@ -154,11 +171,14 @@ void ofApp::draw(){
 	/// print number of visible images
 	ofPushStyle();
 	ofSetColor(50, 150);
-	ofRect(ofGetWidth() - 300, 30, 270, 35);
+	ofRect(ofGetWidth() - 300, 30, 270, 50);
 	ofPopStyle();
 	char numberOfImagesStr[255];
 	sprintf(numberOfImagesStr, "Number of visible images: %d", sourceImages.getNumberOfVisibleImages(reflectionOrder, listenerPosition));
 	ofDrawBitmapString(numberOfImagesStr, ofGetWidth() - 280, 50);
+	int numberOfImagesWithoutDSP = imageRendering.load() == SourceImages::TImageRendering::SourceDSPs ? sourceImages.getNumberOfImagesWithoutDSP(reflectionOrder, listenerPosition) : 0;
+	sprintf(numberOfImagesStr, "Left out, without a DSP: %d", numberOfImagesWithoutDSP);
+	ofDrawBitmapString(numberOfImagesStr, ofGetWidth() - 280, 70);
 
 
 /*
@@ -288,6 +308,17 @@ void ofApp::keyPressed(int key){
 		reflectionOrder--;
 		if (reflectionOrder <0) reflectionOrder = 0;
 		break;
+	case 'n': //switches the near field effect on and off
+		nearField.setEnabled(!nearField.isEnabled());
+		break;
+	case 'b': //switches the rendering of the images between a source DSP each, clusters of directions and the ambisonic bus
+		{
+			SourceImages::TImageRendering rendering = imageRendering.load();
+			if (rendering == SourceImages::TImageRendering::SourceDSPs) imageRendering.store(SourceImages::TImageRendering::Clusters);
+			else if (rendering == SourceImages::TImageRendering::Clusters) imageRendering.store(SourceImages::TImageRendering::AmbisonicBus);
+			else imageRendering.store(SourceImages::TImageRendering::SourceDSPs);
+		}
+		break;
 
 	}
 }
@@ -463,10 +494,14 @@ void ofApp::audioProcess(Common::CEarPair<CMonoBuffer<float>> & bufferOutput, in
 	CMonoBuffer<float> source1(uiBufferSize);
 	source1Wav.FillBuffer(source1);
 
-	sourceImages.processAnechoic(source1, bufferOutput);
 	Common::CTransform lisenerTransform = listener->GetListenerTransform();
 	Common::CVector3 lisenerPosition = lisenerTransform.GetPosition();
+	propagationDelay.write(source1);						// The source and its images read it with their own delay
+	SourceImages::TImageRendering rendering = imageRendering.load();		// Read once, as the main thread switches it
+	sourceImages.setImageRendering(rendering);
+	sourceImages.processAnechoic(source1, bufferOutput, lisenerPosition);
 	sourceImages.processImages(source1, bufferOutput, lisenerPosition, reflectionOrder);
+	if (rendering == SourceImages::TImageRendering::AmbisonicBus) ambisonicBus.decode(lisenerPosition, bufferOutput);
 
 
 /*	// Declaration of stereo buffer
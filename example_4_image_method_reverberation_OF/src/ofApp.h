@@ -27,7 +27,11 @@
 #include "SoundSource.h"
 #include "Room.h"
 #include "SourceImages.h"
+#include "PropagationDelayLine.h"
+#include "NearFieldILD.h"
+#include "AmbisonicBus.h"
 #include <Common/Vector3.h>
+#include <atomic>
 
 
 class ofApp : public ofBaseApp{
@@ -63,6 +67,10 @@ class ofApp : public ofBaseApp{
 		ofSoundStream systemSoundStream;
 
 		SourceImages sourceImages;
+		PropagationDelayLine propagationDelay;			// Propagation delays of the source and all its images
+		NearFieldILD nearField;							// Near field effect of the source and all its images
+		AmbisonicBus ambisonicBus;						// Bus where the images are encoded and decoded once per block, instead of a source DSP per image
+		std::atomic<SourceImages::TImageRendering> imageRendering{ SourceImages::TImageRendering::SourceDSPs };		// How the images are rendered, switched by the main thread and read by the audio thread
 		SoundSource source1Wav;
 		shared_ptr<Binaural::CSingleSourceDSP>	source1DSP;							 // Pointers to each audio source interface
 